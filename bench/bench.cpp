@@ -0,0 +1,35 @@
+#include "bench.h"
+#include <fmt/core.h>
+#include <string_view>
+
+namespace bench
+{
+std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+Registrar::Registrar(const char* name, std::function<void()> run) {
+    registry().push_back(Benchmark{name, std::move(run)});
+}
+
+void measure(const std::string& label, std::uint64_t operations, const std::function<std::uint64_t()>& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const std::uint64_t checksum = f();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    fmt::print("  {:<40} {:>12.1f} ns/op   (checksum {})\n", label,
+        static_cast<double>(elapsed.count()) / static_cast<double>(operations), checksum);
+}
+} // namespace bench
+
+// Runs all the benchmarks, or only those whose name contains the first argument.
+int main(int argc, char** argv) {
+    const std::string_view filter = (argc > 1) ? argv[1] : "";
+    for (const auto& benchmark : bench::registry()) {
+        if (benchmark.name.find(filter) == std::string::npos) continue;
+        fmt::print("{}\n", benchmark.name);
+        benchmark.run();
+    }
+    return 0;
+}
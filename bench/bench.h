@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+struct Benchmark {
+    std::string           name;
+    std::function<void()> run;
+};
+
+std::vector<Benchmark>& registry();
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> run);
+};
+
+/**
+ * Run f once and print the mean time per operation, f is expected to perform the given number of operations.
+ * f returns a checksum which is printed as well, so the compiler can't drop the measured work.
+*/
+void measure(const std::string& label, std::uint64_t operations, const std::function<std::uint64_t()>& f);
+} // namespace bench
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static const bench::Registrar name##_registrar(#name, name); \
+    static void name()
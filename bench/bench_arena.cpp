@@ -0,0 +1,52 @@
+#include "bench.h"
+#include <mylib/arena.h>
+#include <mylib/growing_array.h>
+#include <cstdint>
+
+namespace
+{
+constexpr std::uint64_t ACQUISITIONS_COUNT{1000000u};
+constexpr std::uint64_t PUSHES_COUNT{1u << 24};
+}
+
+BENCHMARK(ArenaAcquireRelease) {
+    mylib::Arena arena(1024u*1024u*64u);
+    bench::measure("mylib::Arena getChunk/releaseChunk", ACQUISITIONS_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < ACQUISITIONS_COUNT; i++) {
+            mylib::Chunk* chunk = arena.getChunk(256u + (i & 7u)*mylib::Arena::PAGE_SIZE);
+            checksum += chunk->size();
+            arena.releaseChunk(chunk, mylib::ClearPolicy::NO_CLEAR);
+        }
+        return checksum;
+    });
+}
+
+BENCHMARK(ArenaChunkPush) {
+    mylib::Arena arena(1024u*1024u*256u);
+    mylib::Chunk* chunk = arena.getChunk(PUSHES_COUNT*sizeof(std::uint64_t));
+    bench::measure("mylib::Chunk push/pop", PUSHES_COUNT, [&] {
+        for (std::uint64_t i = 0; i < PUSHES_COUNT; i++) {
+            chunk->push(i);
+        }
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < PUSHES_COUNT / 2; i++) {
+            chunk->pop(sizeof(std::uint64_t));
+            checksum += *reinterpret_cast<const std::uint64_t*>(chunk->end());
+        }
+        return checksum;
+    });
+    arena.releaseChunk(chunk);
+
+    bench::measure("mylib::GrowingArray push_back", PUSHES_COUNT, [&] {
+        mylib::GrowingArray<std::uint64_t> arr(&arena);
+        for (std::uint64_t i = 0; i < PUSHES_COUNT; i++) {
+            arr.push_back(i);
+        }
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < arr.size(); i += 4096) {
+            checksum += arr[i];
+        }
+        return checksum;
+    });
+}
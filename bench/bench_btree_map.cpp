@@ -0,0 +1,124 @@
+#include "bench.h"
+#include <mylib/btree_map.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t ELEMENTS_COUNT{1000000u};
+constexpr std::uint64_t LOOKUPS_COUNT{1000000u};
+constexpr std::uint64_t RANGES_COUNT{10000u};
+constexpr std::uint64_t RANGE_LENGTH{1000u};
+
+// Timestamps with random gaps, inserted in random order.
+std::vector<std::uint64_t> makeKeys() {
+    std::mt19937_64 random(1);
+    std::vector<std::uint64_t> keys(ELEMENTS_COUNT);
+    std::uint64_t timestamp = 0;
+    for (auto& key : keys) {
+        timestamp += 1 + random() % 16;
+        key = timestamp;
+    }
+    std::shuffle(keys.begin(), keys.end(), random);
+    return keys;
+}
+
+template<class Map>
+void runWorkloads(const char* name, Map& map, const std::vector<std::uint64_t>& keys) {
+    bench::measure(fmt::format("{} insert", name), keys.size(), [&] {
+        for (std::uint64_t key : keys) {
+            map.insert({key, key});
+        }
+        return static_cast<std::uint64_t>(map.size());
+    });
+
+    std::mt19937_64 random(2);
+    bench::measure(fmt::format("{} find", name), LOOKUPS_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < LOOKUPS_COUNT; i++) {
+            checksum += (*map.find(keys[random() % keys.size()])).second;
+        }
+        return checksum;
+    });
+
+    const std::uint64_t max_key = *std::max_element(keys.begin(), keys.end());
+    bench::measure(fmt::format("{} range scan of {}", name, RANGE_LENGTH), RANGES_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < RANGES_COUNT; i++) {
+            const std::uint64_t from = random() % max_key;
+            auto itr = map.lower_bound(from);
+            for (std::uint64_t j = 0; (j < RANGE_LENGTH) && (itr != map.end()); j++, ++itr) {
+                checksum += (*itr).second;
+            }
+        }
+        return checksum;
+    });
+}
+
+// Adapts BTreeMap to the std::map interface used by the workloads.
+struct BTreeMapAdapter {
+    explicit BTreeMapAdapter(mylib::Arena* arena) : map(arena) {}
+
+    using iterator = mylib::BTreeMap<std::uint64_t, std::uint64_t>::iterator;
+
+    void insert(const std::pair<std::uint64_t, std::uint64_t>& element) { map.insert(element.first, element.second); }
+    iterator find(std::uint64_t key) { return map.find(key); }
+    iterator lower_bound(std::uint64_t key) { return map.lower_bound(key); }
+    iterator end() { return map.end(); }
+    std::size_t size() const { return map.size(); }
+
+    mylib::BTreeMap<std::uint64_t, std::uint64_t> map;
+};
+}
+
+BENCHMARK(BTreeMapVsStdMap) {
+    const std::vector<std::uint64_t> keys = makeKeys();
+    {
+        std::map<std::uint64_t, std::uint64_t> map;
+        runWorkloads("std::map", map, keys);
+    }
+    {
+        mylib::Arena arena(1024u*1024u*256u);
+        BTreeMapAdapter map(&arena);
+        runWorkloads("mylib::BTreeMap", map, keys);
+
+        // The range scan without the iterator, visiting the leaves in place.
+        std::mt19937_64 random(3);
+        const std::uint64_t max_key = *std::max_element(keys.begin(), keys.end());
+        bench::measure(fmt::format("mylib::BTreeMap scan of ~{}", RANGE_LENGTH), RANGES_COUNT, [&] {
+            std::uint64_t checksum = 0;
+            for (std::uint64_t i = 0; i < RANGES_COUNT; i++) {
+                const std::uint64_t from = random() % max_key;
+                // Keys are 8.5 apart on average.
+                map.map.scan(from, from + RANGE_LENGTH*17/2, [&checksum](std::uint64_t, std::uint64_t value) { checksum += value; });
+            }
+            return checksum;
+        });
+    }
+}
+
+BENCHMARK(BTreeMapBulkLoad) {
+    std::vector<std::uint64_t> keys = makeKeys();
+    std::sort(keys.begin(), keys.end());
+    mylib::Arena arena(1024u*1024u*256u);
+    mylib::GrowingArray<std::pair<std::uint64_t, std::uint64_t>> sorted(&arena);
+    for (std::uint64_t key : keys) {
+        sorted.push_back(std::make_pair(key, key));
+    }
+
+    bench::measure("std::map insert sorted", keys.size(), [&] {
+        std::map<std::uint64_t, std::uint64_t> map;
+        for (std::uint64_t key : keys) {
+            map.emplace_hint(map.end(), key, key);
+        }
+        return static_cast<std::uint64_t>(map.size());
+    });
+    bench::measure("mylib::BTreeMap bulk_load", keys.size(), [&] {
+        mylib::BTreeMap<std::uint64_t, std::uint64_t> map(&arena);
+        map.bulk_load(sorted);
+        return static_cast<std::uint64_t>(map.size());
+    });
+}
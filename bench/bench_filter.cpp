@@ -0,0 +1,64 @@
+#include "bench.h"
+#include <mylib/filter.h>
+#include <fmt/core.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t KEYS_COUNT{1u << 22};
+
+// Inserted keys are even, the lookups of odd keys are all misses.
+std::vector<std::uint64_t> makeKeys(std::uint64_t seed, std::uint64_t parity) {
+    std::mt19937_64 random(seed);
+    std::vector<std::uint64_t> keys(KEYS_COUNT);
+    for (auto& key : keys) key = (random() & ~1ull) | parity;
+    return keys;
+}
+
+template<class Filter>
+void runLookups(const char* name, const Filter& filter, const std::vector<std::uint64_t>& hits, const std::vector<std::uint64_t>& misses) {
+    auto results = std::make_unique<bool[]>(KEYS_COUNT);
+    bench::measure(fmt::format("{} contains, one by one", name), KEYS_COUNT, [&] {
+        std::uint64_t count = 0;
+        for (std::uint64_t key : misses) count += filter.contains(key);
+        return count;
+    });
+    std::uint64_t false_positives = 0;
+    bench::measure(fmt::format("{} contains, batch", name), KEYS_COUNT, [&] {
+        false_positives = filter.contains(misses, std::span<bool>(results.get(), KEYS_COUNT));
+        return false_positives;
+    });
+    bench::measure(fmt::format("{} contains, batch of hits", name), KEYS_COUNT, [&] {
+        return filter.contains(hits, std::span<bool>(results.get(), KEYS_COUNT));
+    });
+    fmt::print("  {:<40} {:>12.4f} %   ({} bytes per key)\n", fmt::format("{} false positive rate", name),
+        100.0*static_cast<double>(false_positives) / KEYS_COUNT, static_cast<double>(filter.memoryUsage()) / KEYS_COUNT);
+}
+}
+
+BENCHMARK(FilterThroughputAndFalsePositives) {
+    const std::vector<std::uint64_t> hits = makeKeys(1, 0);
+    const std::vector<std::uint64_t> misses = makeKeys(2, 1);
+    mylib::Arena arena(1024u*1024u*64u);
+
+    for (double rate : {0.01, 0.001}) {
+        mylib::BloomFilter bloom(&arena, KEYS_COUNT, rate);
+        bench::measure(fmt::format("BloomFilter({}) insert, batch", rate), KEYS_COUNT, [&] {
+            bloom.insert(hits);
+            return bloom.size();
+        });
+        runLookups(fmt::format("BloomFilter({})", rate).c_str(), bloom, hits, misses);
+    }
+
+    mylib::CuckooFilter cuckoo(&arena, KEYS_COUNT);
+    bench::measure("CuckooFilter insert", KEYS_COUNT, [&] { return cuckoo.insert(hits); });
+    fmt::print("  {:<40} {:>12.3f}\n", "CuckooFilter load factor", cuckoo.loadFactor());
+    runLookups("CuckooFilter", cuckoo, hits, misses);
+    bench::measure("CuckooFilter erase", KEYS_COUNT, [&] {
+        std::uint64_t count = 0;
+        for (std::uint64_t key : hits) count += cuckoo.erase(key);
+        return count;
+    });
+}
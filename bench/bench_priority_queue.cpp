@@ -0,0 +1,109 @@
+#include "bench.h"
+#include <mylib/priority_queue.h>
+#include <fmt/core.h>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t HOLD_OPERATIONS{1u << 20};
+constexpr std::uint64_t UPDATES_COUNT{1u << 20};
+
+// Timer workload: the queue holds count deadlines, every operation fires the earliest timer and schedules a new one.
+std::vector<std::uint64_t> deadlines(std::uint64_t count) {
+    std::mt19937_64 random(count);
+    std::vector<std::uint64_t> values(count + HOLD_OPERATIONS);
+    for (auto& value : values) {
+        value = random() >> 16;
+    }
+    return values;
+}
+
+template<std::size_t D>
+void runHold(mylib::Arena& arena, const std::vector<std::uint64_t>& values, std::uint64_t count) {
+    mylib::PriorityQueue<std::uint64_t, std::greater<std::uint64_t>, D> queue(&arena);
+    queue.push_bulk(std::span(values.data(), count));
+    bench::measure(fmt::format("mylib::PriorityQueue<{}> hold, {} timers", D, count), HOLD_OPERATIONS, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < HOLD_OPERATIONS; i++) {
+            checksum += queue.top();
+            queue.pop();
+            queue.push(queue.top() + values[count + i]);
+        }
+        return checksum;
+    });
+}
+
+template<std::size_t D>
+void runHeapify(mylib::Arena& arena, const std::vector<std::uint64_t>& values, std::uint64_t count) {
+    bench::measure(fmt::format("mylib::PriorityQueue<{}> push_bulk of {}", D, count), count, [&] {
+        mylib::PriorityQueue<std::uint64_t, std::greater<std::uint64_t>, D> queue(&arena);
+        queue.push_bulk(std::span(values.data(), count));
+        return queue.top();
+    });
+}
+
+template<std::size_t D>
+void runUpdates(mylib::Arena& arena, std::uint64_t count) {
+    mylib::IndexedPriorityQueue<std::uint64_t, std::greater<std::uint64_t>, D> queue(&arena);
+    std::mt19937_64 random(count);
+    for (std::uint64_t i = 0; i < count; i++) {
+        queue.push(random() >> 16);
+    }
+    bench::measure(fmt::format("mylib::IndexedPriorityQueue<{}> update, {} tasks", D, count), UPDATES_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < UPDATES_COUNT; i++) {
+            // Rescheduling moves a task either way, like a scheduler adjusting deadlines.
+            queue.update(random() % count, random() >> 16);
+            checksum += queue.top();
+        }
+        return checksum;
+    });
+}
+}
+
+BENCHMARK(PriorityQueueArity) {
+    for (std::uint64_t count : {1000u, 100000u, 1000000u, 10000000u}) {
+        mylib::Arena arena;
+        const auto values = deadlines(count);
+        std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<std::uint64_t>> std_queue(
+            std::greater<std::uint64_t>(), std::vector<std::uint64_t>(values.begin(), values.begin() + count));
+        bench::measure(fmt::format("std::priority_queue hold, {} timers", count), HOLD_OPERATIONS, [&] {
+            std::uint64_t checksum = 0;
+            for (std::uint64_t i = 0; i < HOLD_OPERATIONS; i++) {
+                checksum += std_queue.top();
+                std_queue.pop();
+                std_queue.push(std_queue.top() + values[count + i]);
+            }
+            return checksum;
+        });
+        runHold<2>(arena, values, count);
+        runHold<4>(arena, values, count);
+        runHold<8>(arena, values, count);
+    }
+}
+
+BENCHMARK(PriorityQueueHeapify) {
+    constexpr std::uint64_t COUNT{10000000u};
+    mylib::Arena arena;
+    const auto values = deadlines(COUNT);
+    bench::measure(fmt::format("std::priority_queue from a range of {}", COUNT), COUNT, [&] {
+        std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<std::uint64_t>> queue(
+            values.begin(), values.begin() + COUNT);
+        return queue.top();
+    });
+    runHeapify<2>(arena, values, COUNT);
+    runHeapify<4>(arena, values, COUNT);
+    runHeapify<8>(arena, values, COUNT);
+}
+
+BENCHMARK(PriorityQueueDecreaseKey) {
+    for (std::uint64_t count : {1000u, 1000000u}) {
+        mylib::Arena arena;
+        runUpdates<2>(arena, count);
+        runUpdates<4>(arena, count);
+        runUpdates<8>(arena, count);
+    }
+}
@@ -0,0 +1,40 @@
+#include "bench.h"
+#include <mylib/rope.h>
+#include <fmt/core.h>
+#include <string>
+
+namespace
+{
+constexpr std::uint64_t APPENDS_COUNT{20000u};
+
+// Builds a payload of about 1MiB out of short lines, the way responses are assembled.
+std::string makeLine(std::uint64_t i) {
+    return fmt::format("{{\"id\":{},\"value\":\"{:0>32}\"}},\n", i, i);
+}
+}
+
+BENCHMARK(RopeConcatenation) {
+    bench::measure("mylib::String operator+", APPENDS_COUNT, [] {
+        mylib::String payload("");
+        for (std::uint64_t i = 0; i < APPENDS_COUNT; i++) {
+            payload = payload + makeLine(i).c_str();
+        }
+        return static_cast<std::uint64_t>(payload.size());
+    });
+
+    mylib::Arena arena(1024u*1024u*64u);
+    bench::measure("mylib::Rope append + flatten", APPENDS_COUNT, [&] {
+        mylib::Rope payload(&arena);
+        for (std::uint64_t i = 0; i < APPENDS_COUNT; i++) {
+            payload.append(makeLine(i));
+        }
+        return static_cast<std::uint64_t>(payload.flatten().size());
+    });
+    bench::measure("mylib::Rope insert in the middle", APPENDS_COUNT, [&] {
+        mylib::Rope payload(&arena);
+        for (std::uint64_t i = 0; i < APPENDS_COUNT; i++) {
+            payload.insert(payload.size() / 2, makeLine(i));
+        }
+        return static_cast<std::uint64_t>(payload.ioVecs().size());
+    });
+}
@@ -0,0 +1,63 @@
+#include "bench.h"
+#include <mylib/growing_array.h>
+#include <mylib/segmented_array.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t ELEMENTS_COUNT{1u << 25};
+constexpr std::uint64_t BATCH_SIZE{1024u};
+
+// Times every batch of pushes separately, and reports the tail of the distribution,
+// since relocating the whole array shows up as rare spikes which the mean hides.
+template<class Array>
+void measurePushLatency(const char* name, Array& arr) {
+    std::vector<std::uint64_t> batches;
+    batches.reserve(ELEMENTS_COUNT / BATCH_SIZE);
+    for (std::uint64_t i = 0; i < ELEMENTS_COUNT; i += BATCH_SIZE) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (std::uint64_t j = i; j < i + BATCH_SIZE; j++) {
+            arr.push_back(j);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        batches.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    std::sort(batches.begin(), batches.end());
+    const auto percentile = [&](double p) {
+        return static_cast<double>(batches[static_cast<std::size_t>(p*(batches.size() - 1))]) / BATCH_SIZE;
+    };
+    fmt::print("  {:<40} p50 {:.1f} ns, p99 {:.1f} ns, p99.9 {:.1f} ns, max {:.1f} ns per push (size {})\n",
+        name, percentile(0.5), percentile(0.99), percentile(0.999), percentile(1.0), arr.size());
+}
+}
+
+BENCHMARK(SegmentedArrayPushLatency) {
+    {
+        mylib::Arena arena(1024u*1024u*64u);
+        mylib::GrowingArray<std::uint64_t> arr(&arena);
+        measurePushLatency("mylib::GrowingArray", arr);
+    }
+    {
+        mylib::Arena arena(1024u*1024u*64u);
+        mylib::SegmentedArray<std::uint64_t> arr(&arena);
+        measurePushLatency("mylib::SegmentedArray", arr);
+
+        bench::measure("mylib::SegmentedArray random index", ELEMENTS_COUNT, [&] {
+            std::uint64_t checksum = 0;
+            std::uint64_t index = 1;
+            for (std::uint64_t i = 0; i < ELEMENTS_COUNT; i++) {
+                index = (index*6364136223846793005u + 1442695040888963407u);
+                checksum += arr[(index >> 32) & (ELEMENTS_COUNT - 1)];
+            }
+            return checksum;
+        });
+        arena.setClearPolicy(mylib::ClearPolicy::CLEAR_ON_ACQUIRE);
+        bench::measure("mylib::SegmentedArray truncate to 1024", 1, [&] {
+            arr.truncate(BATCH_SIZE);
+            return static_cast<std::uint64_t>(arr.segmentsCount());
+        });
+    }
+}
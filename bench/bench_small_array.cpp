@@ -0,0 +1,49 @@
+#include "bench.h"
+#include <mylib/growing_array.h>
+#include <mylib/small_array.h>
+#include <cstdint>
+
+namespace
+{
+constexpr std::uint64_t REQUESTS_COUNT{100000u};
+constexpr std::uint64_t ELEMENTS_COUNT{24u};
+
+// A temporary array built and dropped per request, e.g. parsed header offsets.
+template<class Array>
+std::uint64_t handleRequest(mylib::Arena& arena, std::uint64_t request) {
+    Array arr(&arena);
+    for (std::uint64_t i = 0; i < ELEMENTS_COUNT; i++) {
+        arr.push_back(request + i);
+    }
+    std::uint64_t checksum = 0;
+    for (std::uint64_t i = 0; i < arr.size(); i++) {
+        checksum += arr[i];
+    }
+    return checksum;
+}
+}
+
+BENCHMARK(SmallArrayPerRequest) {
+    mylib::Arena arena(1024u*1024u*16u);
+    bench::measure("mylib::GrowingArray per request", REQUESTS_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < REQUESTS_COUNT; i++) {
+            checksum += handleRequest<mylib::GrowingArray<std::uint64_t>>(arena, i);
+        }
+        return checksum;
+    });
+    bench::measure("mylib::SmallArray<32> per request", REQUESTS_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < REQUESTS_COUNT; i++) {
+            checksum += handleRequest<mylib::SmallArray<std::uint64_t, 32>>(arena, i);
+        }
+        return checksum;
+    });
+    bench::measure("mylib::SmallArray<8> per request", REQUESTS_COUNT, [&] {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t i = 0; i < REQUESTS_COUNT; i++) {
+            checksum += handleRequest<mylib::SmallArray<std::uint64_t, 8>>(arena, i);
+        }
+        return checksum;
+    });
+}
@@ -0,0 +1,55 @@
+#include "bench.h"
+#include <mylib/sort.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t KEYS_COUNT{1u << 24};
+
+template<class T, class Generator>
+void fill(mylib::GrowingArray<T>& arr, std::vector<T>& values, Generator&& generate) {
+    arr.clear();
+    values.clear();
+    for (std::uint64_t i = 0; i < KEYS_COUNT; i++) {
+        values.push_back(generate(i));
+        arr.push_back(values.back());
+    }
+}
+
+template<class T, class Generator>
+void runSorts(const char* name, Generator&& generate) {
+    mylib::Arena arena(1024u*1024u*256u);
+    mylib::GrowingArray<T> arr(&arena);
+    std::vector<T> values;
+
+    fill(arr, values, generate);
+    bench::measure(fmt::format("std::sort {}", name), KEYS_COUNT, [&] {
+        std::sort(values.begin(), values.end());
+        return static_cast<std::uint64_t>(values[KEYS_COUNT / 2] == values[KEYS_COUNT / 2]);
+    });
+    bench::measure(fmt::format("mylib::sort {}", name), KEYS_COUNT, [&] {
+        mylib::sort(arr);
+        return static_cast<std::uint64_t>(arr[KEYS_COUNT / 2] == values[KEYS_COUNT / 2]);
+    });
+
+    fill(arr, values, generate);
+    const std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    bench::measure(fmt::format("mylib::parallel_sort {} ({} threads)", name, threads), KEYS_COUNT, [&] {
+        mylib::parallel_sort(arr, threads);
+        return static_cast<std::uint64_t>(std::is_sorted(arr.data(), arr.data() + arr.size()));
+    });
+}
+}
+
+BENCHMARK(SortPrimitiveKeys) {
+    std::mt19937_64 random(1);
+    runSorts<std::uint64_t>("uint64", [&](std::uint64_t) { return random(); });
+    runSorts<double>("double", [&](std::uint64_t) { return std::bit_cast<double>(random() >> 2); });
+    runSorts<std::pair<std::uint32_t, std::uint32_t>>("key-index pairs", [&](std::uint64_t i) {
+        return std::make_pair(static_cast<std::uint32_t>(random()), static_cast<std::uint32_t>(i));
+    });
+}
@@ -0,0 +1,46 @@
+#include "bench.h"
+#include <mylib/string.h>
+#include <fmt/core.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t STRINGS_COUNT{1000u};
+constexpr std::uint64_t CONTAINERS_COUNT{100u};
+
+// Stores every string in every container, the way the same labels end up in many series.
+std::uint64_t storeInContainers(const std::vector<mylib::String>& strings) {
+    std::vector<std::vector<mylib::String>> containers(CONTAINERS_COUNT);
+    std::uint64_t checksum = 0;
+    for (auto& container : containers) {
+        container.reserve(strings.size());
+        for (const auto& str : strings) {
+            container.push_back(str);
+        }
+        checksum += container.back().size();
+    }
+    return checksum;
+}
+
+void runCopies(std::uint64_t length) {
+    mylib::Arena arena(1024u*1024u*64u);
+    std::vector<mylib::String> deep;
+    std::vector<mylib::String> shared;
+    for (std::uint64_t i = 0; i < STRINGS_COUNT; i++) {
+        std::string str = fmt::format("{:0>{}}", i, length);
+        deep.emplace_back(str);
+        shared.emplace_back(&arena, mylib::StringView(str));
+    }
+
+    const std::uint64_t copies = STRINGS_COUNT*CONTAINERS_COUNT;
+    bench::measure(fmt::format("deep copy of {} bytes", length), copies, [&] { return storeInContainers(deep); });
+    bench::measure(fmt::format("shared copy of {} bytes", length), copies, [&] { return storeInContainers(shared); });
+}
+}
+
+BENCHMARK(StringCopies) {
+    runCopies(16);
+    runCopies(256);
+    runCopies(4096);
+}
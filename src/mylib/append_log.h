@@ -0,0 +1,371 @@
+#pragma once
+
+#include "arena.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mylib
+{
+/**
+ * Append-only log with a single writer and any number of concurrent readers, none of which take a lock.
+ * Elements are stored in segments, each of which occupies an arena chunk, and segments are linked into a list.
+ * The writer fills the slots past the committed length and publishes them with a release store of the length,
+ * readers take a snapshot with an acquire load of it, so everything below the snapshot's end is fully written
+ * and never modified again.
+ *
+ * Old elements are dropped by the writer with discard. Segments which become unreachable are retired,
+ * and returned to the arena once every snapshot that could still see them is destroyed (epoch based reclamation).
+ * The writer never waits for readers, a retired segment a reader still holds is simply reclaimed on a later call.
+ * T has to be trivially copyable, since the elements are never destroyed.
+*/
+template<class T>
+class AppendLog {
+    static_assert(std::is_trivially_copyable_v<T>, "elements have to be trivially copyable");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+    struct Segment {
+        std::atomic<Segment*> next{nullptr};
+        Chunk*                chunk;
+        std::uint64_t         base;     // Index of the first element in the segment.
+        std::uint64_t         capacity;
+        std::uint64_t         retire_epoch = 0;
+        Segment*              retired_next = nullptr;
+
+        T* data() noexcept {
+            return reinterpret_cast<T*>(reinterpret_cast<std::byte*>(this) + SLOTS_OFFSET);
+        }
+    };
+
+    constexpr static std::uint64_t SLOTS_OFFSET{(sizeof(Segment) + alignof(T) - 1) / alignof(T) * alignof(T)};
+
+    // Epoch a reader has pinned, INACTIVE if the record isn't used by any snapshot.
+    // Records are never freed while the log is alive, released ones are reused by later snapshots.
+    struct alignas(64) ReaderRecord {
+        std::atomic<std::uint64_t> epoch{INACTIVE};
+        std::atomic<bool>          claimed{false};
+        ReaderRecord*              next = nullptr;
+    };
+
+    constexpr static std::uint64_t INACTIVE{0};
+
+public:
+    constexpr static std::uint64_t DEFAULT_SEGMENT_SIZE{64u*1024u};
+
+    /**
+     * Forward iterator over the elements of a snapshot.
+    */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() noexcept = default;
+
+        reference operator*() const noexcept { return m_segment->data()[m_index - m_segment->base]; }
+        pointer operator->() const noexcept { return &**this; }
+
+        iterator& operator++() noexcept {
+            m_index += 1;
+            if (m_index == m_segment->base + m_segment->capacity) {
+                // NOTE: The next segment is linked before any of its elements are committed.
+                m_segment = m_segment->next.load(std::memory_order_acquire);
+            }
+            return *this;
+        }
+
+        iterator operator++(int) noexcept { iterator tmp = *this; ++(*this); return tmp; }
+
+        bool operator==(const iterator& rhs) const noexcept { return m_index == rhs.m_index; }
+
+        std::uint64_t index() const noexcept { return m_index; }
+
+    private:
+        friend class AppendLog;
+
+        iterator(Segment* segment, std::uint64_t index) noexcept
+        : m_segment(segment), m_index(index) {}
+
+        Segment*      m_segment = nullptr;
+        std::uint64_t m_index = 0;
+    };
+
+    using const_iterator = iterator;
+
+    /**
+     * Consistent view of the elements in [beginIndex(), endIndex()), the indices are positions in the whole log.
+     * The segments the snapshot sees are kept alive until it's destroyed, so snapshots should be short-lived,
+     * otherwise discarded segments pile up.
+    */
+    class Snapshot {
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        Snapshot(Snapshot&& rhs) noexcept
+        : m_record(rhs.m_record), m_segment(rhs.m_segment), m_begin(rhs.m_begin), m_end(rhs.m_end) {
+            rhs.m_record = nullptr;
+        }
+
+        ~Snapshot() noexcept {
+            if (m_record) {
+                m_record->epoch.store(INACTIVE, std::memory_order_release);
+                m_record->claimed.store(false, std::memory_order_release);
+            }
+        }
+
+        iterator begin() const noexcept { return iterator(m_segment, m_begin); }
+        iterator end() const noexcept { return iterator(nullptr, m_end); }
+
+        std::uint64_t beginIndex() const noexcept { return m_begin; }
+        std::uint64_t endIndex() const noexcept { return m_end; }
+        std::uint64_t size() const noexcept { return m_end - m_begin; }
+        bool          empty() const noexcept { return m_end == m_begin; }
+
+        /**
+         * @param index Position in the log, walks the segments from the snapshot's first one.
+         * @throw std::out_of_range If index is outside of the snapshot.
+        */
+        const T& at(std::uint64_t index) const {
+            if ((index < m_begin) || (index >= m_end))
+                throw std::out_of_range(fmt::format("index {} is out of snapshot range [{}, {})", index, m_begin, m_end));
+            Segment* segment = m_segment;
+            while (index >= segment->base + segment->capacity) {
+                segment = segment->next.load(std::memory_order_acquire);
+            }
+            return segment->data()[index - segment->base];
+        }
+
+    private:
+        friend class AppendLog;
+
+        Snapshot(ReaderRecord* record, Segment* segment, std::uint64_t begin, std::uint64_t end) noexcept
+        : m_record(record), m_segment(segment), m_begin(begin), m_end(end) {
+            // Start the iteration in the segment which holds the first element, not the first segment seen.
+            while (m_segment && (m_begin >= m_segment->base + m_segment->capacity) && (m_begin < m_end)) {
+                m_segment = m_segment->next.load(std::memory_order_acquire);
+            }
+        }
+
+        ReaderRecord* m_record;
+        Segment*      m_segment;
+        std::uint64_t m_begin;
+        std::uint64_t m_end;
+    };
+
+    /**
+     * @param arena Arena to take segments from.
+     * @param segment_size Size of the chunk a segment occupies, it holds at least a single element.
+    */
+    explicit AppendLog(Arena* arena, std::uint64_t segment_size=DEFAULT_SEGMENT_SIZE)
+    : m_arena(arena), m_segment_size(std::max<std::uint64_t>(segment_size, SLOTS_OFFSET + sizeof(T))) {
+        m_tail = newSegment(0);
+        m_head.store(m_tail, std::memory_order_relaxed);
+    }
+
+    /**
+     * NOTE: No snapshots may outlive the log.
+    */
+    ~AppendLog() noexcept {
+        Segment* segment = m_head.load(std::memory_order_relaxed);
+        while (segment) {
+            Segment* segment_next = segment->next.load(std::memory_order_relaxed);
+            m_arena->releaseChunk(segment->chunk);
+            segment = segment_next;
+        }
+        while (m_retired) {
+            Segment* retired_next = m_retired->retired_next;
+            m_arena->releaseChunk(m_retired->chunk);
+            m_retired = retired_next;
+        }
+        ReaderRecord* record = m_readers.load(std::memory_order_relaxed);
+        while (record) {
+            ReaderRecord* record_next = record->next;
+            delete record;
+            record = record_next;
+        }
+    }
+
+    AppendLog(const AppendLog&) = delete;
+    AppendLog& operator=(const AppendLog&) = delete;
+
+    /**
+     * Append a single element and publish it to the readers. Writer only.
+    */
+    void push(const T& value) {
+        store(value);
+        m_committed.store(m_length, std::memory_order_release);
+    }
+
+    /**
+     * Append all the values and publish them at once, so no snapshot sees only a part of the batch. Writer only.
+    */
+    void append(std::span<const T> values) {
+        for (const T& value : values) {
+            store(value);
+        }
+        m_committed.store(m_length, std::memory_order_release);
+    }
+
+    /**
+     * Drop the elements before index, new snapshots start at index at the earliest.
+     * Segments which hold only dropped elements are retired and returned to the arena
+     * as soon as no snapshot can reach them. Writer only.
+     * @param index Position in the log, clamped to the number of elements pushed.
+    */
+    void discard(std::uint64_t index) {
+        index = std::min(index, m_length);
+        if (index <= m_begin.load(std::memory_order_relaxed)) return;
+        m_begin.store(index, std::memory_order_release);
+
+        Segment* head = m_head.load(std::memory_order_relaxed);
+        bool retired = false;
+        while ((head != m_tail) && (head->base + head->capacity <= index)) {
+            Segment* head_next = head->next.load(std::memory_order_relaxed);
+            m_head.store(head_next, std::memory_order_seq_cst);
+            head->retire_epoch = m_epoch.load(std::memory_order_relaxed);
+            head->retired_next = m_retired;
+            m_retired = head;
+            m_retired_count += 1;
+            head = head_next;
+            retired = true;
+        }
+        if (retired) {
+            // Snapshots taken from now on pin a later epoch, and can't see the retired segments.
+            m_epoch.fetch_add(1, std::memory_order_seq_cst);
+        }
+        reclaim();
+    }
+
+    /**
+     * Return the retired segments no snapshot can reach to the arena. Called by push and discard,
+     * never waits for the readers, segments which are still visible are left for a later call. Writer only.
+     * @return Number of segments reclaimed.
+    */
+    std::uint64_t reclaim() noexcept {
+        if (!m_retired) return 0;
+
+        // The oldest epoch any snapshot has pinned, segments retired before it are unreachable.
+        std::uint64_t min_epoch = m_epoch.load(std::memory_order_seq_cst);
+        for (ReaderRecord* record = m_readers.load(std::memory_order_acquire); record; record = record->next) {
+            const std::uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+            if (epoch != INACTIVE) min_epoch = std::min(min_epoch, epoch);
+        }
+
+        std::uint64_t reclaimed = 0;
+        Segment** link = &m_retired;
+        while (*link) {
+            Segment* segment = *link;
+            if (segment->retire_epoch < min_epoch) {
+                *link = segment->retired_next;
+                m_arena->releaseChunk(segment->chunk);
+                reclaimed += 1;
+            }
+            else {
+                link = &segment->retired_next;
+            }
+        }
+        m_retired_count -= reclaimed;
+        return reclaimed;
+    }
+
+    /**
+     * Take a consistent view of the committed elements. Safe to call from any thread, concurrently with the writer.
+    */
+    Snapshot snapshot() const {
+        ReaderRecord* record = acquireRecord();
+
+        // Pin the epoch, and make sure the writer hasn't retired anything in between,
+        // otherwise the pinned epoch could be older than the segments this reader is about to see.
+        std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        while (true) {
+            record->epoch.store(epoch, std::memory_order_seq_cst);
+            const std::uint64_t current = m_epoch.load(std::memory_order_seq_cst);
+            if (current == epoch) break;
+            epoch = current;
+        }
+
+        Segment* head = m_head.load(std::memory_order_seq_cst);
+        const std::uint64_t begin = m_begin.load(std::memory_order_acquire);
+        const std::uint64_t end = m_committed.load(std::memory_order_acquire);
+        return Snapshot(record, head, std::max(begin, head->base), end);
+    }
+
+    /**
+     * @return Number of elements ever pushed and published, including the discarded ones.
+    */
+    std::uint64_t size() const noexcept { return m_committed.load(std::memory_order_acquire); }
+    std::uint64_t beginIndex() const noexcept { return m_begin.load(std::memory_order_acquire); }
+
+    /**
+     * @return Number of segments retired by discard, but not yet returned to the arena.
+    */
+    std::uint64_t retiredCount() const noexcept { return m_retired_count; }
+    std::uint64_t segmentCapacity() const noexcept { return m_tail->capacity; }
+
+private:
+    void store(const T& value) {
+        if (m_length == m_tail->base + m_tail->capacity) {
+            Segment* segment = newSegment(m_length);
+            // Linked before any of its elements are committed, so readers always find the segment.
+            m_tail->next.store(segment, std::memory_order_release);
+            m_tail = segment;
+            reclaim();
+        }
+        new (m_tail->data() + (m_length - m_tail->base)) T(value);
+        m_length += 1;
+    }
+
+    Segment* newSegment(std::uint64_t base) {
+        Chunk* chunk = m_arena->getChunk(m_segment_size);
+        auto* segment = new (chunk->begin()) Segment{};
+        segment->chunk = chunk;
+        segment->base = base;
+        segment->capacity = (chunk->size() - SLOTS_OFFSET) / sizeof(T);
+        chunk->advance(chunk->size());
+        return segment;
+    }
+
+    ReaderRecord* acquireRecord() const {
+        for (ReaderRecord* record = m_readers.load(std::memory_order_acquire); record; record = record->next) {
+            bool claimed = false;
+            if (!record->claimed.load(std::memory_order_relaxed) &&
+                record->claimed.compare_exchange_strong(claimed, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        auto* record = new ReaderRecord{};
+        record->claimed.store(true, std::memory_order_relaxed);
+        record->next = m_readers.load(std::memory_order_relaxed);
+        while (!m_readers.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {}
+        return record;
+    }
+
+    Arena*                              m_arena;
+    std::uint64_t                       m_segment_size;
+
+    // Shared with the readers.
+    alignas(64) std::atomic<std::uint64_t> m_committed{0};
+    std::atomic<std::uint64_t>          m_begin{0};
+    std::atomic<Segment*>               m_head{nullptr};
+    std::atomic<std::uint64_t>          m_epoch{1};
+    mutable std::atomic<ReaderRecord*>  m_readers{nullptr};
+
+    // Writer only.
+    alignas(64) Segment*                m_tail = nullptr;
+    std::uint64_t                       m_length = 0;
+    Segment*                            m_retired = nullptr;
+    std::uint64_t                       m_retired_count = 0;
+};
+
+} // namespace mylib
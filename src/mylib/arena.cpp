@@ -1,13 +1,26 @@
 #include "arena.h"
 
 #include <fmt/core.h>
+#include <algorithm>
+#include <cstdlib>
 #include <stdexcept>
 
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define MYLIB_NON_TEMPORAL_STORES
+#endif
+
 #ifdef _WIN32
 # define WIN32_LEAN_AND_MEAN
 # include <windows.h>
 # undef max
 # undef min
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <unistd.h>
 #endif
 
 namespace
@@ -18,54 +31,130 @@ public:
     : std::exception(msg)
     {}
 };
+
+// Error paths of the acquisition, kept out of line so the formatting code doesn't end up in getChunk.
+[[noreturn]] MYLIB_COLD void throwPersistentOutOfSpace(std::uint64_t size) {
+    throw std::length_error(fmt::format("persistent arena is out of space, requested {}", size));
+}
+
+[[noreturn]] MYLIB_COLD void throwReservedSizeExceeded(std::uint64_t limit, std::uint64_t size) {
+    throw std::length_error(fmt::format("arena exceeds the reserved size limit of {}, requested {}", limit, size));
+}
+
+constexpr std::uint64_t FILE_MAGIC{0x414e455241424c4dull}; // "MLBARENA"
+constexpr std::uint64_t FILE_VERSION{3u};
+
+// Clearing large chunks with regular stores would pull every cache line in
+// only to overwrite it, and evict the data other clients are working on.
+void clearMemory(std::byte* ptr, std::uint64_t size) noexcept {
+#ifdef MYLIB_NON_TEMPORAL_STORES
+    if (size >= mylib::Arena::NON_TEMPORAL_CLEAR_SIZE) {
+        const std::uint64_t head = (16 - (reinterpret_cast<std::uintptr_t>(ptr) & 15)) & 15;
+        std::memset(ptr, 0, head);
+        ptr += head;
+        size -= head;
+        const __m128i zero = _mm_setzero_si128();
+        for (std::uint64_t i = 0; i < size / 64; i++, ptr += 64) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(ptr), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(ptr + 16), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(ptr + 32), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(ptr + 48), zero);
+        }
+        _mm_sfence();
+        std::memset(ptr, 0, size % 64);
+        return;
+    }
+#endif
+    std::memset(ptr, 0, size);
+}
+
+// Mirrors MPOL_PREFERRED from <numaif.h>, which is a part of libnuma and might not be installed.
+constexpr int MPOL_PREFERRED_MODE{1};
 }
 
 namespace mylib
 {
 
-Arena::Arena(std::uint64_t size) {
-    m_blocks.push_back(std::make_unique<MemBlock>(size));
+Arena::Arena(std::uint64_t size)
+: Arena(ArenaOptions{.initial_size = size}) {}
+
+Arena::Arena(std::uint64_t size, std::int32_t numa_node)
+: Arena(ArenaOptions{.initial_size = size, .numa_node = numa_node}) {}
+
+Arena::Arena(const ArenaOptions& options)
+: m_options(options), m_next_block_size(std::min(options.block_size, options.max_block_size)) {
+    if (!(options.growth_factor >= 1.0) || !options.initial_size || !options.block_size || !options.max_block_size)
+        throw std::invalid_argument(fmt::format("invalid arena options, initial size {}, block size {}, growth factor {}, max block size {}", 
+                                                options.initial_size, options.block_size, options.growth_factor, options.max_block_size));
+    m_blocks.push_back(std::make_unique<MemBlock>(options.initial_size, options.numa_node, options.backing));
+    m_blocks_count += 1;
+}
+
+Arena::Arena(const std::filesystem::path& path, std::uint64_t size)
+: m_persistent(true) {
+    m_blocks.push_back(std::make_unique<MemBlock>(path, size));
     m_blocks_count += 1;
 }
 
 Arena::Arena(Arena&& rhs) 
-: m_blocks(std::move(rhs.m_blocks)),
-  m_blocks_count(rhs.m_blocks_count) {}
+: m_persistent(rhs.m_persistent),
+  m_options(rhs.m_options),
+  m_next_block_size(rhs.m_next_block_size),
+  m_epoch(rhs.m_epoch),
+  m_blocks_count(rhs.m_blocks_count),
+  m_dedicated_blocks_count(rhs.m_dedicated_blocks_count),
+  m_blocks(std::move(rhs.m_blocks)),
+  m_quarantine(std::move(rhs.m_quarantine)),
+  m_quarantine_head(rhs.m_quarantine_head),
+  m_quarantine_count(rhs.m_quarantine_count) {}
 
 Arena& Arena::operator=(Arena&& rhs) {
     if (this == &rhs) return *this;
     m_blocks = std::move(rhs.m_blocks);
     m_blocks_count = rhs.m_blocks_count;
+    m_dedicated_blocks_count = rhs.m_dedicated_blocks_count;
+    m_persistent = rhs.m_persistent;
+    m_options = rhs.m_options;
+    m_next_block_size = rhs.m_next_block_size;
+    m_epoch = rhs.m_epoch;
+    m_quarantine = std::move(rhs.m_quarantine);
+    m_quarantine_head = rhs.m_quarantine_head;
+    m_quarantine_count = rhs.m_quarantine_count;
     return *this;
 }
 
 Chunk* Arena::getChunk(std::uint64_t size, Chunk* old_chunk) {
+    // NOTE: The default policy is read under the same lock, rather than through clearPolicy(),
+    // so acquiring a chunk takes the mutex only once.
     std::lock_guard<std::mutex> lock(m_mutex);
+    return getChunkLocked(size, m_options.clear_policy, old_chunk);
+}
 
-    // NOTE: Compute a total allocation size taking into consideration an alignment.
-    // If a chunk is nullptr, we include the size of the MemBlock::ChunkHeader into the total allocation size.
-    // Thus, if requested size is equal to 1024, which is exactly the size of a single page (PAGE_SIZE), 
-    // two pages will be allocated comprising the size of 2048bytes(2Kib) in total,
-    // because we have to fit a ChunkHeader struct.
-    // +--------+-------------------+------------------------------------------------------------+
-    // | chunk  |         size      |                      empty space                           |
-    // | header |         size      |                      empty space                           |
-    // +--------+-------------------+------------------------------------------------------------+
-    //                              ^
-    //                              |
-    //                             m_pos
-    std::uint64_t new_size = size + CHUNK_HEADER_SIZE;
-    std::uint64_t rem = new_size % Arena::PAGE_SIZE;
-    std::uint64_t new_aligned_size = (rem == 0) ? new_size : (new_size + Arena::PAGE_SIZE - rem);
-    std::uint64_t page_count = new_aligned_size / Arena::PAGE_SIZE;
-    std::uint64_t total_size = page_count * Arena::PAGE_SIZE;
+Chunk* Arena::getChunk(std::uint64_t size, ClearPolicy policy, Chunk* old_chunk) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getChunkLocked(size, policy, old_chunk);
+}
+
+Chunk* Arena::getChunkLocked(std::uint64_t size, ClearPolicy policy, Chunk* old_chunk) {
+    const std::uint64_t total_size = allocationSize(size);
 
     MemBlock* potential_block = nullptr;
     for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
         MemBlock* cur_block = itr->get();
         auto result = cur_block->getEmptyChunk(total_size);
         if (result.has_value()) {
-            return result.value();
+            try {
+                prepareEmptyChunk(result.value(), policy);
+            } catch (...) {
+                // The chunk was already taken, put it back, otherwise it leaks for the arena's lifetime.
+                freeChunkLocked(result.value(), policy);
+                throw;
+            }
+            if (old_chunk) {
+                result.value()->copy(old_chunk);
+                freeChunkLocked(old_chunk, m_options.clear_policy);
+            }
+            return tagChunk(result.value());
         }
         
         if (!potential_block && (cur_block->remainingSpace() > total_size)) {
@@ -75,13 +164,10 @@ Chunk* Arena::getChunk(std::uint64_t size, Chunk* old_chunk) {
 
     // Arena where to insert a chunk hasn't been found.
     if (!potential_block) {
-        std::uint64_t new_size = std::max(total_size, DEFAULT_ALLOC_SIZE);
-        auto itr = m_blocks.insert(m_blocks.end(), std::make_unique<MemBlock>(new_size));
-        potential_block = itr->get();
-        m_blocks_count += 1;
+        potential_block = newBlockLocked(total_size, total_size >= m_options.dedicated_block_threshold);
     }
 
-    auto* new_chunk = potential_block->newChunk(total_size);
+    auto* new_chunk = tagChunk(potential_block->newChunk(total_size, policy != ClearPolicy::NO_CLEAR));
 
     // NOTE: Presumably, this shouldn't be the responsibility of arena to copy the data.
     // The one who owns the old chunk should copy before releasing it.
@@ -91,21 +177,296 @@ Chunk* Arena::getChunk(std::uint64_t size, Chunk* old_chunk) {
     // But maybe it's convenient to keep it here.
     if (old_chunk) {
         new_chunk->copy(old_chunk);
-        potential_block->freeChunk(old_chunk);
+        freeChunkLocked(old_chunk, m_options.clear_policy);
     }
 
     return new_chunk;
 }
 
+void Arena::getChunks(std::uint64_t size, std::uint64_t count, Chunk** out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    getChunksLocked(allocationSize(size), count, out, m_options.clear_policy);
+}
+
+void Arena::releaseChunks(std::span<Chunk* const> chunks) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Chunk* chunk : chunks) {
+        freeChunkLocked(chunk, m_options.clear_policy);
+    }
+    trimLocked(false);
+}
+
 void Arena::releaseChunk(Chunk* chunk) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_blocks.empty() && chunk) {
-        for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
-            Arena::MemBlock* block = itr->get();
-            if (block->freeChunk(chunk)) 
-                return;
+    freeChunkLocked(chunk, m_options.clear_policy);
+    trimLocked(false);
+}
+
+void Arena::releaseChunk(Chunk* chunk, ClearPolicy policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    freeChunkLocked(chunk, policy);
+    trimLocked(false);
+}
+
+void Arena::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
+        itr->get()->rewind();
+    }
+    if (m_persistent) {
+        std::fill(std::begin(m_blocks.front()->m_file_header->roots), std::end(m_blocks.front()->m_file_header->roots), nullptr);
+    }
+    std::fill(m_quarantine.begin(), m_quarantine.end(), nullptr);
+    m_quarantine_head = 0;
+    m_quarantine_count = 0;
+    trimLocked(false);
+}
+
+std::uint32_t Arena::beginEpoch() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return ++m_epoch;
+}
+
+std::uint32_t Arena::currentEpoch() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_epoch;
+}
+
+std::uint64_t Arena::retireEpoch(std::uint32_t epoch) {
+    using ChunkHeader = MemBlock::ChunkHeader;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::uint64_t retired = 0;
+    for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
+        MemBlock* block = itr->get();
+        if (!block->m_chunks) continue;
+
+        // NOTE: A block can be rewound only if every chunk is either free or belongs to the epoch,
+        // quarantined chunks have to stay where they are until they leave the quarantine.
+        std::uint64_t in_epoch = 0;
+        bool rewindable = true;
+        for (ChunkHeader* chunk_header = block->m_chunks;;) {
+            if (chunk_header->state == MemBlock::ChunkState::IN_USE) {
+                if (chunk_header->epoch == epoch) in_epoch += 1;
+                else rewindable = false;
+            }
+            else if (chunk_header->state == MemBlock::ChunkState::QUARANTINED) {
+                rewindable = false;
+            }
+            chunk_header = chunk_header->next;
+            if (chunk_header == block->m_chunks) break;
+        }
+
+        if (!in_epoch) continue;
+        retired += in_epoch;
+        if (rewindable) {
+            block->rewind();
+            continue;
+        }
+
+        for (ChunkHeader* chunk_header = block->m_chunks;;) {
+            ChunkHeader* next = chunk_header->next;
+            if ((chunk_header->state == MemBlock::ChunkState::IN_USE) && (chunk_header->epoch == epoch)) {
+                freeChunkLocked(&chunk_header->chunk, m_options.clear_policy);
+            }
+            chunk_header = next;
+            if (chunk_header == block->m_chunks) break;
+        }
+    }
+    trimLocked(false);
+    return retired;
+}
+
+void Arena::setClearPolicy(ClearPolicy policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options.clear_policy = policy;
+}
+
+ClearPolicy Arena::clearPolicy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options.clear_policy;
+}
+
+ChunkHandle Arena::getChunkHandle(std::uint64_t size) {
+    return ChunkHandle(getChunk(size));
+}
+
+void Arena::releaseChunk(const ChunkHandle& handle) {
+    Chunk* chunk = handle.get();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    freeChunkLocked(chunk, m_options.clear_policy);
+    trimLocked(false);
+}
+
+void Arena::setQuarantineSize(std::uint64_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::uint64_t i = 0; i < m_quarantine_count; i++) {
+        Chunk* chunk = m_quarantine[(m_quarantine_head + i) % m_quarantine.size()];
+        if (MemBlock* block = findBlockLocked(chunk))
+            block->unquarantineChunk(chunk);
+    }
+    m_quarantine.assign(count, nullptr);
+    m_quarantine_head = 0;
+    m_quarantine_count = 0;
+}
+
+void Arena::freeChunkLocked(Chunk* chunk, ClearPolicy policy) {
+    if (m_blocks.empty() || !chunk) {
+        return;
+    }
+
+    MemBlock* block = findBlockLocked(chunk);
+#ifdef MYLIB_ARENA_HARDENED
+    if (!block)
+        throw stale_chunk_error("released chunk doesn't belong to the arena");
+    if (reinterpret_cast<const MemBlock::ChunkHeader*>(chunk)->state != MemBlock::ChunkState::IN_USE)
+        throw stale_chunk_error("chunk is released twice");
+#endif
+    const bool quarantine = !m_quarantine.empty();
+    const bool clear = (policy == ClearPolicy::CLEAR_ON_RELEASE);
+    if (block && block->freeChunk(chunk, clear, quarantine) && quarantine) {
+        quarantineLocked(chunk);
+    }
+}
+
+std::uint64_t Arena::allocationSize(std::uint64_t size) noexcept {
+    // NOTE: Compute a total allocation size taking into consideration an alignment.
+    // If a chunk is nullptr, we include the size of the MemBlock::ChunkHeader into the total allocation size.
+    // Thus, if requested size is equal to 1024, which is exactly the size of a single page (PAGE_SIZE), 
+    // two pages will be allocated comprising the size of 2048bytes(2Kib) in total,
+    // because we have to fit a ChunkHeader struct.
+    // +--------+-------------------+------------------------------------------------------------+
+    // | chunk  |         size      |                      empty space                           |
+    // | header |         size      |                      empty space                           |
+    // +--------+-------------------+------------------------------------------------------------+
+    //                              ^
+    //                              |
+    //                             m_pos
+    std::uint64_t new_size = size + CHUNK_HEADER_SIZE;
+    std::uint64_t rem = new_size % Arena::PAGE_SIZE;
+    std::uint64_t new_aligned_size = (rem == 0) ? new_size : (new_size + Arena::PAGE_SIZE - rem);
+    std::uint64_t page_count = new_aligned_size / Arena::PAGE_SIZE;
+    return page_count * Arena::PAGE_SIZE;
+}
+
+void Arena::getChunksLocked(std::uint64_t total_size, std::uint64_t count, Chunk** out, ClearPolicy policy) {
+    const bool clear = (policy != ClearPolicy::NO_CLEAR);
+    std::uint64_t acquired = 0;
+    try {
+        // Free chunks first, a single pass over each block's list regardless of how many are taken.
+        for (auto itr = m_blocks.begin(); (itr != m_blocks.end()) && (acquired < count); itr++) {
+            const std::uint64_t first = acquired;
+            acquired += itr->get()->getEmptyChunks(total_size, count - acquired, out + acquired);
+            for (std::uint64_t i = first; i < acquired; i++) {
+                prepareEmptyChunk(out[i], policy);
+            }
+        }
+
+        // The rest is carved back to back from the remaining space of the blocks,
+        // a new block is sized to fit all the chunks which are still missing.
+        for (auto itr = m_blocks.begin(); (itr != m_blocks.end()) && (acquired < count); itr++) {
+            acquired += itr->get()->newChunks(total_size, count - acquired, out + acquired, clear);
+        }
+        if ((acquired < count) && (total_size >= m_options.dedicated_block_threshold)) {
+            while (acquired < count) {
+                out[acquired] = newBlockLocked(total_size, true)->newChunk(total_size, clear);
+                acquired += 1;
+            }
+        }
+        if (acquired < count) {
+            MemBlock* block = newBlockLocked(total_size * (count - acquired));
+            acquired += block->newChunks(total_size, count - acquired, out + acquired, clear);
         }
+        for (std::uint64_t i = 0; i < count; i++) {
+            tagChunk(out[i]);
+        }
+    } catch (...) {
+        for (std::uint64_t i = 0; i < acquired; i++) {
+            freeChunkLocked(out[i], policy);
+        }
+        throw;
+    }
+}
+
+Arena::MemBlock* Arena::newBlockLocked(std::uint64_t size, bool dedicated) {
+    if (m_persistent)
+        throwPersistentOutOfSpace(size);
+    std::uint64_t new_size = dedicated ? size : std::max(size, m_next_block_size);
+    if (m_options.max_reserved_size != UNLIMITED_SIZE) {
+        std::uint64_t reserved_size = reservedSizeLocked();
+        if (reserved_size + new_size > m_options.max_reserved_size) {
+            reserved_size -= trimLocked(true);
+        }
+        // NOTE: A memory block rounds its size, increased by sizeof(MemBlock), up to PAGE_SIZE.
+        std::uint64_t available = (m_options.max_reserved_size > reserved_size) ? (m_options.max_reserved_size - reserved_size) : 0;
+        available -= available % PAGE_SIZE;
+        if (available < size + sizeof(MemBlock)) 
+            throwReservedSizeExceeded(m_options.max_reserved_size, size);
+        new_size = std::min(new_size, available - sizeof(MemBlock));
+    }
+    auto itr = m_blocks.insert(m_blocks.end(), std::make_unique<MemBlock>(new_size, m_options.numa_node, m_options.backing));
+    m_blocks_count += 1;
+    itr->get()->m_dedicated = dedicated;
+    if (dedicated) {
+        m_dedicated_blocks_count += 1;
+    }
+    else {
+        // NOTE: The growth is computed in floating point, and has to be clamped before converting back,
+        // otherwise a large factor would overflow.
+        const double grown_size = static_cast<double>(m_next_block_size) * m_options.growth_factor;
+        m_next_block_size = (grown_size >= static_cast<double>(m_options.max_block_size)) 
+            ? m_options.max_block_size : static_cast<std::uint64_t>(grown_size);
+    }
+    return itr->get();
+}
+
+Arena::MemBlock* Arena::findBlockLocked(const Chunk* chunk) const noexcept {
+    for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
+        if (itr->get()->contains(chunk))
+            return itr->get();
     }
+    return nullptr;
+}
+
+void Arena::quarantineLocked(Chunk* chunk) noexcept {
+    // NOTE: The quarantine is a ring buffer, once it's full the oldest chunk is put into circulation.
+    const std::uint64_t capacity = m_quarantine.size();
+    if (m_quarantine_count == capacity) {
+        Chunk* oldest = m_quarantine[m_quarantine_head];
+        if (MemBlock* block = findBlockLocked(oldest))
+            block->unquarantineChunk(oldest);
+        m_quarantine[m_quarantine_head] = chunk;
+        m_quarantine_head = (m_quarantine_head + 1) % capacity;
+        return;
+    }
+    m_quarantine[(m_quarantine_head + m_quarantine_count) % capacity] = chunk;
+    m_quarantine_count += 1;
+}
+
+void Arena::prepareEmptyChunk(Chunk* chunk, ClearPolicy policy) const {
+#ifdef MYLIB_ARENA_HARDENED
+    // Released chunks are poisoned, any other byte means that someone wrote
+    // through a stale pointer after the release.
+    if (!chunk->isFilledWith(POISON))
+        throw stale_chunk_error("chunk was modified after it had been released");
+    chunk->fill(std::byte{0});
+    (void)policy;
+#else
+    // NOTE: If clearing was deferred, the position of a free chunk marks how many bytes
+    // were used by the previous owner, and have to be cleared now. Acquiring without clearing
+    // carries them over in the dirty size, so a later clear doesn't stop at the new owner's position.
+    auto* chunk_header = reinterpret_cast<MemBlock::ChunkHeader*>(chunk);
+    chunk_header->dirty_size = std::max(chunk_header->dirty_size, chunk->m_pos);
+    if (policy != ClearPolicy::NO_CLEAR) {
+        clearMemory(chunk->m_start, chunk_header->dirty_size);
+        chunk_header->dirty_size = 0;
+    }
+    chunk->m_pos = 0;
+#endif
+}
+
+Chunk* Arena::tagChunk(Chunk* chunk) const noexcept {
+    reinterpret_cast<MemBlock::ChunkHeader*>(chunk)->epoch = m_epoch;
+    return chunk;
 }
 
 std::uint64_t Arena::emptyChunksCount() const {
@@ -131,27 +492,237 @@ std::uint64_t Arena::totalBlocks() const {
     return m_blocks.size();
 }
 
-Arena::MemBlock::MemBlock(std::uint64_t size) {
+std::uint64_t Arena::reservedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return reservedSizeLocked();
+}
+
+std::uint64_t Arena::reservedSizeLocked() const noexcept {
+    std::uint64_t reserved_size = 0;
+    for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
+        reserved_size += itr->get()->m_cap;
+    }
+    return reserved_size;
+}
+
+std::uint64_t Arena::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return trimLocked(true);
+}
+
+void Arena::setTrimPolicy(const TrimPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options.trim_policy = policy;
+    trimLocked(false);
+}
+
+TrimPolicy Arena::trimPolicy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options.trim_policy;
+}
+
+void Arena::setMaxReservedSize(std::uint64_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options.max_reserved_size = size;
+}
+
+std::uint64_t Arena::maxReservedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options.max_reserved_size;
+}
+
+std::uint64_t Arena::trimLocked(bool force) {
+    // NOTE: The first block is kept, so an arena which is used again after trimming
+    // doesn't have to allocate a new block of the default size.
+    if (m_persistent || (m_blocks.size() < 2)) {
+        return 0;
+    }
+    const bool by_policy = force || m_options.trim_policy.isEnabled();
+    // NOTE: Called on every release, so with nothing to trim it shouldn't walk the blocks.
+    if (!by_policy && !m_dedicated_blocks_count) {
+        return 0;
+    }
+
+    std::uint64_t retained_bytes = 0;
+    for (auto itr = std::next(m_blocks.begin()); itr != m_blocks.end(); itr++) {
+        if (itr->get()->isEmpty()) 
+            retained_bytes += itr->get()->m_cap;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::uint64_t released_bytes = 0;
+    for (auto itr = std::next(m_blocks.begin()); itr != m_blocks.end();) {
+        MemBlock* block = itr->get();
+        // Dedicated blocks are released as soon as their chunk is, regardless of the policy.
+        if (block->isEmpty() && 
+            (force || block->m_dedicated ||
+             (by_policy && (retained_bytes > m_options.trim_policy.retained_bytes)) || 
+             (by_policy && (now - block->m_empty_since >= m_options.trim_policy.grace_period)))) {
+            retained_bytes -= block->m_cap;
+            released_bytes += block->m_cap;
+            m_dedicated_blocks_count -= block->m_dedicated ? 1 : 0;
+            itr = m_blocks.erase(itr);
+            m_blocks_count -= 1;
+            continue;
+        }
+        itr++;
+    }
+    return released_bytes;
+}
+
+bool Arena::contains(const Chunk* chunk) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return findBlockLocked(chunk) != nullptr;
+}
+
+void Arena::sync() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto itr = m_blocks.begin(); itr != m_blocks.end(); itr++) {
+        itr->get()->sync();
+    }
+}
+
+void Arena::setRoot(std::uint32_t slot, Chunk* chunk) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_persistent)
+        throw std::logic_error("roots are only supported by persistent arenas");
+    if (slot >= ROOTS_COUNT)
+        throw std::out_of_range(fmt::format("root slot {} is out of range", slot));
+    m_blocks.front()->m_file_header->roots[slot] = chunk;
+}
+
+Chunk* Arena::root(std::uint32_t slot) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_persistent)
+        throw std::logic_error("roots are only supported by persistent arenas");
+    if (slot >= ROOTS_COUNT)
+        throw std::out_of_range(fmt::format("root slot {} is out of range", slot));
+    return m_blocks.front()->m_file_header->roots[slot];
+}
+
+Arena::MemBlock::MemBlock(std::uint64_t size, std::int32_t numa_node, BackingMemory backing)
+: m_numa_node(numa_node), m_backing(backing) {
     std::uint64_t arena_size = sizeof(Arena::MemBlock); 
     std::uint64_t new_size = size + arena_size;
     std::uint64_t rem = new_size % PAGE_SIZE; 
     new_size += (rem == 0 ? 0 : PAGE_SIZE - rem);
-    m_ptr = static_cast<std::byte*>(MemBlock::allocMemory(new_size));
+    m_ptr = static_cast<std::byte*>(MemBlock::allocMemory(new_size, numa_node, backing));
     m_cap = new_size;
     m_pos = 0;
 }
 
+Arena::MemBlock::MemBlock(const std::filesystem::path& path, std::uint64_t size) {
+    // NOTE: The file header occupies the first page(s) of the file, chunks are placed right after it.
+    // +-------------+--------+-----------+--------+-----------+--------------------------------+
+    // | file header | chunk  |   chunk   | chunk  |   chunk   |          empty space           |
+    // |             | header |   data    | header |   data    |                                |
+    // +-------------+--------+-----------+--------+-----------+--------------------------------+
+    // ^             ^
+    // |             |
+    // m_file_header m_ptr
+    std::uint64_t header_size = sizeof(FileHeader);
+    header_size += (header_size % PAGE_SIZE == 0) ? 0 : PAGE_SIZE - (header_size % PAGE_SIZE);
+    std::uint64_t new_size = size + header_size;
+    std::uint64_t rem = new_size % PAGE_SIZE;
+    new_size += (rem == 0 ? 0 : PAGE_SIZE - rem);
+
+    bool created = false;
+    auto* memory = static_cast<std::byte*>(MemBlock::mapFile(path, new_size, created));
+    m_file_header = reinterpret_cast<FileHeader*>(memory);
+    m_ptr = memory + header_size;
+    m_cap = new_size - header_size;
+
+    if (created) {
+        // Freshly created files are zero-filled by the OS, there is no need to clear them.
+        m_file_header->magic = FILE_MAGIC;
+        m_file_header->version = FILE_VERSION;
+        m_file_header->mapping_size = new_size;
+        sync();
+        return;
+    }
+
+    m_pos = m_file_header->pos;
+    m_dirty_pos = m_file_header->dirty_pos;
+    m_total_chunks_count = m_file_header->total_chunks_count;
+    m_empty_chunks_count = m_file_header->empty_chunks_count;
+    m_chunks = m_file_header->chunks;
+    if (m_file_header->base != memory) {
+        rebase(m_file_header->base);
+    }
+}
+
 Arena::MemBlock::~MemBlock() {
-    if (m_ptr) {
-        releaseMemory(m_ptr);
+    if (m_file_header) {
+        sync();
+        unmapFile(m_file_header, m_file_header->mapping_size);
+    }
+    else if (m_ptr) {
+        releaseMemory(m_ptr, m_cap, m_backing);
+    }
+}
+
+void Arena::MemBlock::sync() {
+    if (!m_file_header) return;
+    m_file_header->base = reinterpret_cast<std::byte*>(m_file_header);
+    m_file_header->pos = m_pos;
+    m_file_header->dirty_pos = m_dirty_pos;
+    m_file_header->total_chunks_count = m_total_chunks_count;
+    m_file_header->empty_chunks_count = m_empty_chunks_count;
+    m_file_header->chunks = m_chunks;
+#ifdef _WIN32
+    FlushViewOfFile(m_file_header, m_file_header->mapping_size);
+#else
+    msync(m_file_header, m_file_header->mapping_size, MS_SYNC);
+#endif
+}
+
+void Arena::MemBlock::rebase(std::byte* old_base) noexcept {
+    // The file was mapped at a different address, all the pointers stored in the file
+    // have to be shifted by the same offset. It only touches the chunk headers, not the data.
+    const std::ptrdiff_t delta = reinterpret_cast<std::byte*>(m_file_header) - old_base;
+    auto relocate = [delta](auto* ptr) {
+        using Ptr = decltype(ptr);
+        return ptr ? reinterpret_cast<Ptr>(reinterpret_cast<std::byte*>(ptr) + delta) : ptr;
+    };
+
+    for (auto& root : m_file_header->roots) {
+        root = relocate(root);
+    }
+
+    m_chunks = relocate(m_chunks);
+    if (m_chunks) {
+        for (auto* chunk_header = m_chunks;;) {
+            chunk_header->next = relocate(chunk_header->next);
+            chunk_header->prev = relocate(chunk_header->prev);
+            chunk_header->chunk.m_start += delta;
+            chunk_header = chunk_header->next;
+            if (chunk_header == m_chunks) {
+                break;
+            }
+        }
     }
+
+    sync();
 }
 
-Chunk* Arena::MemBlock::newChunk(std::uint64_t size) noexcept {
+Chunk* Arena::MemBlock::newChunk(std::uint64_t size, bool clear) noexcept {
     auto* chunk_pair = reinterpret_cast<Arena::MemBlock::ChunkHeader*>(m_ptr + m_pos);
-    std::byte* start = m_ptr + CHUNK_HEADER_SIZE;
+    std::byte* start = m_ptr + m_pos + CHUNK_HEADER_SIZE;
     std::uint64_t chunk_size = size - CHUNK_HEADER_SIZE;
+#ifdef MYLIB_ARENA_HARDENED
+    clear = true;
+#endif
+    // Memory below the dirty position was used by the chunks discarded by a rewind.
+    std::uint64_t dirty_size = 0;
+    if (m_pos + CHUNK_HEADER_SIZE < m_dirty_pos) {
+        dirty_size = std::min(chunk_size, m_dirty_pos - m_pos - CHUNK_HEADER_SIZE);
+    }
+    if (clear && dirty_size) {
+        clearMemory(start, dirty_size);
+        dirty_size = 0;
+    }
     chunk_pair->chunk = Chunk(start, chunk_size);
+    chunk_pair->dirty_size = dirty_size;
     chunk_pair->state = Arena::MemBlock::ChunkState::IN_USE;
     if (m_chunks) {
         chunk_pair->next = m_chunks;
@@ -171,35 +742,113 @@ Chunk* Arena::MemBlock::newChunk(std::uint64_t size) noexcept {
     return &chunk_pair->chunk;
 }
 
-bool Arena::MemBlock::freeChunk(Chunk* chunk) noexcept {
-    if (chunk && m_chunks) {
-        if (m_chunks == m_chunks->prev && (&m_chunks->chunk == chunk)) {
-            m_chunks->state = ChunkState::FREE;
-            m_chunks->chunk.reset();
-            m_empty_chunks_count += 1;
+bool Arena::MemBlock::freeChunk(Chunk* chunk, bool clear, bool quarantine) noexcept {
+    if (!chunk || !m_chunks || !contains(chunk)) {
+        return false;
+    }
+#ifdef MYLIB_ARENA_HARDENED
+    if (!isChunkHeader(chunk)) {
+        return false;
+    }
+#endif
+    // NOTE: A chunk is the first member of its header, so there is no need to walk the list to find it.
+    auto* chunk_header = reinterpret_cast<ChunkHeader*>(chunk);
+#ifndef MYLIB_ARENA_HARDENED
+    // Pointers into the chunk data may point at bytes which happen to look like an in-use header.
+    // Chunks are carved at PAGE_SIZE multiples from the start of the block, their data follows the header,
+    // and both neighbours on the chain link back to them, which a forged header can't fake.
+    const auto* ptr = reinterpret_cast<const std::byte*>(chunk);
+    if (((ptr - m_ptr) % PAGE_SIZE != 0) || (chunk->m_start != ptr + CHUNK_HEADER_SIZE) ||
+        !contains(&chunk_header->next->chunk) || !contains(&chunk_header->prev->chunk) ||
+        (chunk_header->next->prev != chunk_header) || (chunk_header->prev->next != chunk_header)) {
+        return false;
+    }
+#endif
+    if (chunk_header->state != ChunkState::IN_USE) {
+        return false;
+    }
+    releaseHeader(chunk_header, clear, quarantine);
+    return true;
+}
+
+bool Arena::MemBlock::isChunkHeader(const Chunk* chunk) const noexcept {
+    for (auto* chunk_header = m_chunks;;
+        chunk_header = chunk_header->next) {
+        if (chunk == &chunk_header->chunk) {
             return true;
         }
+        if (chunk_header == m_chunks->prev) {
+            return false;
+        }
+    }
+}
 
-        for (auto* chunk_header = m_chunks;;
-            chunk_header = chunk_header->next) {
-            if ((chunk == &chunk_header->chunk) && (chunk_header->state == ChunkState::IN_USE)) {
-                chunk_header->state = ChunkState::FREE;
-                chunk_header->chunk.reset();
-                m_empty_chunks_count += 1;
-                return true;
-            }
-
-            if (chunk_header == m_chunks->prev) {
-                break;
-            }
+void Arena::MemBlock::rewind() noexcept {
+#ifdef MYLIB_ARENA_HARDENED
+    // Bump the generations, so the handles to discarded chunks are detected as stale.
+    // Headers carved at the same addresses later keep the bumped generation.
+    if (m_chunks) {
+        for (auto* chunk_header = m_chunks;;) {
+            chunk_header->generation.fetch_add(1, std::memory_order_release);
+            chunk_header = chunk_header->next;
+            if (chunk_header == m_chunks) break;
         }
     }
-    
-    return false;
+#endif
+    m_dirty_pos = std::max(m_dirty_pos, m_pos);
+    m_pos = 0;
+    m_chunks = nullptr;
+    m_total_chunks_count = 0;
+    m_empty_chunks_count = 0;
+    m_empty_since = std::chrono::steady_clock::now();
+}
+
+bool Arena::MemBlock::isEmpty() const noexcept {
+    // Quarantined chunks are not counted as empty, so they keep the block alive.
+    return m_empty_chunks_count == m_total_chunks_count;
+}
+
+void Arena::MemBlock::releaseHeader(ChunkHeader* chunk_header, bool clear, bool quarantine) noexcept {
+#ifdef MYLIB_ARENA_HARDENED
+    // NOTE: Only the hardened handles compare generations, regular builds skip the atomic increment.
+    chunk_header->generation.fetch_add(1, std::memory_order_release);
+    chunk_header->chunk.fill(POISON);
+    (void)clear;
+#else
+    if (clear) {
+        Chunk& chunk = chunk_header->chunk;
+        clearMemory(chunk.m_start, std::max(chunk_header->dirty_size, chunk.m_pos));
+        chunk.m_pos = 0;
+        chunk_header->dirty_size = 0;
+    }
+#endif
+    if (quarantine) {
+        chunk_header->state = ChunkState::QUARANTINED;
+        return;
+    }
+    chunk_header->state = ChunkState::FREE;
+    m_empty_chunks_count += 1;
+    if (isEmpty())
+        m_empty_since = std::chrono::steady_clock::now();
+}
+
+void Arena::MemBlock::unquarantineChunk(Chunk* chunk) noexcept {
+    auto* chunk_header = reinterpret_cast<ChunkHeader*>(chunk);
+    if (chunk_header->state == ChunkState::QUARANTINED) {
+        chunk_header->state = ChunkState::FREE;
+        m_empty_chunks_count += 1;
+        if (isEmpty())
+            m_empty_since = std::chrono::steady_clock::now();
+    }
+}
+
+bool Arena::MemBlock::contains(const Chunk* chunk) const noexcept {
+    const auto* ptr = reinterpret_cast<const std::byte*>(chunk);
+    return (ptr >= m_ptr) && (ptr < m_ptr + m_pos);
 }
 
 std::optional<Chunk*> Arena::MemBlock::getEmptyChunk(std::uint64_t size) noexcept {
-    if (m_chunks) {
+    if (m_chunks && m_empty_chunks_count) {
         const std::uint64_t chunk_size = size - CHUNK_HEADER_SIZE;
         ChunkHeader* chunk_header = nullptr;
 
@@ -230,6 +879,39 @@ std::optional<Chunk*> Arena::MemBlock::getEmptyChunk(std::uint64_t size) noexcep
     return {}; 
 }
 
+std::uint64_t Arena::MemBlock::getEmptyChunks(std::uint64_t size, std::uint64_t count, Chunk** out) noexcept {
+    std::uint64_t taken = 0;
+    if (m_chunks && m_empty_chunks_count) {
+        const std::uint64_t chunk_size = size - CHUNK_HEADER_SIZE;
+        // NOTE: Unlike getEmptyChunk, the first fitting chunks are taken rather than the best fitting ones,
+        // so the list is traversed only once for the whole batch.
+        for (auto* cur_header = m_chunks; taken < count;
+            cur_header = cur_header->next) {
+            if ((cur_header->state == ChunkState::FREE) && 
+                (cur_header->chunk.size() >= chunk_size)) {
+                cur_header->state = ChunkState::IN_USE;
+                out[taken++] = &cur_header->chunk;
+            }
+
+            if (cur_header == m_chunks->prev) {
+                break;
+            }
+        }
+        m_empty_chunks_count -= taken;
+    }
+    return taken;
+}
+
+std::uint64_t Arena::MemBlock::newChunks(std::uint64_t size, std::uint64_t count, Chunk** out, bool clear) noexcept {
+    // Keep the same margin as getChunk, which only carves from blocks with more than size bytes left.
+    const std::uint64_t fits = (m_cap - m_pos) ? (m_cap - m_pos - 1) / size : 0;
+    const std::uint64_t carved = std::min(count, fits);
+    for (std::uint64_t i = 0; i < carved; i++) {
+        out[i] = newChunk(size, clear);
+    }
+    return carved;
+}
+
 std::uint64_t Arena::MemBlock::totalChunks() const noexcept {
     return m_total_chunks_count;
 }
@@ -242,23 +924,143 @@ std::uint64_t Arena::MemBlock::remainingSpace() const noexcept {
     return (m_cap - m_pos);
 }
 
-void* Arena::MemBlock::allocMemory(uint64_t size) {
+void* Arena::MemBlock::allocMemory(uint64_t size, std::int32_t numa_node, BackingMemory backing) {
+    if (backing == BackingMemory::HEAP) {
+        // Heap memory is only zero-filled by calloc, large requests are still served by fresh pages.
+        void* memory = std::calloc(1, size);
+        if (!memory) 
+            throw allocation_error(fmt::format("failed to allocate memory block of size {}", size).c_str());
+        return memory;
+    }
 #ifdef _WIN32
-    void *memory = VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    void *memory = nullptr;
+    const SIZE_T large_page_size = GetLargePageMinimum();
+    if ((backing == BackingMemory::HUGE_PAGES) && large_page_size && (size % large_page_size == 0)) {
+        // Requires the SeLockMemoryPrivilege, without it the allocation fails and regular pages are used.
+        memory = (numa_node < 0)
+            ? VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE)
+            : VirtualAllocExNuma(GetCurrentProcess(), 0, size, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE, numa_node);
+    }
+    if (!memory) {
+        memory = (numa_node < 0) 
+            ? VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE)
+            : VirtualAllocExNuma(GetCurrentProcess(), 0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE, numa_node);
+    }
 #else
-    void *memory = malloc(size);
-    std::memset(memory, 0, size);
+    // NOTE: Anonymous mappings are zero-filled by the OS and committed lazily on the first touch,
+    // so there is no need to clear the block, which would fault in every page up front.
+    void *memory = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        memory = nullptr;
+    }
+# ifdef MADV_HUGEPAGE
+    // Transparent huge pages don't have to be reserved up front, the advice is ignored if they're disabled.
+    if (memory && (backing == BackingMemory::HUGE_PAGES)) {
+        madvise(memory, size, MADV_HUGEPAGE);
+    }
+# endif
+    if (memory && (numa_node >= 0)) {
+        // The memory has to be bound before it's touched for the first time, 
+        // since pages are placed on the node of the thread which touches them first.
+# ifdef SYS_mbind
+        {
+            constexpr std::uint64_t MASK_BITS = sizeof(unsigned long)*8;
+            unsigned long node_mask[1024 / MASK_BITS]{};
+            if (static_cast<std::uint64_t>(numa_node) < 1024) {
+                node_mask[numa_node / MASK_BITS] = 1ul << (numa_node % MASK_BITS);
+                // Failures are ignored, the memory is still usable, just not bound.
+                syscall(SYS_mbind, memory, size, MPOL_PREFERRED_MODE, node_mask, 1024ul, 0u);
+            }
+        }
+# endif
+    }
 #endif
     if (!memory) 
         throw allocation_error(fmt::format("failed to allocate memory block of size {}", size).c_str());
     return memory;
 }
 
-void Arena::MemBlock::releaseMemory(void *memory) {
+void Arena::MemBlock::releaseMemory(void *memory, std::uint64_t size, BackingMemory backing) {
+    if (backing == BackingMemory::HEAP) {
+        std::free(memory);
+        return;
+    }
 #ifdef _WIN32
     VirtualFree(memory, 0, MEM_RELEASE);
 #else
-    free(memory);
+    munmap(memory, size);
+#endif
+}
+
+void* Arena::MemBlock::mapFile(const std::filesystem::path& path, std::uint64_t& size, bool& created) {
+    FileHeader header{};
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ|GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw allocation_error(fmt::format("failed to open file {}", path.string()).c_str());
+    LARGE_INTEGER file_size{};
+    GetFileSizeEx(file, &file_size);
+    created = (file_size.QuadPart == 0);
+    if (!created) {
+        DWORD read = 0;
+        if (!ReadFile(file, &header, sizeof(header), &read, nullptr) || (read != sizeof(header)) || (header.magic != FILE_MAGIC) || (header.version != FILE_VERSION)) {
+            CloseHandle(file);
+            throw allocation_error(fmt::format("file {} is not a persistent arena of version {}", path.string(), FILE_VERSION).c_str());
+        }
+        if (static_cast<std::uint64_t>(file_size.QuadPart) < header.mapping_size) {
+            CloseHandle(file);
+            throw allocation_error(fmt::format("file {} is truncated, expected {} bytes", path.string(), header.mapping_size).c_str());
+        }
+        size = header.mapping_size;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    void* memory = nullptr;
+    if (mapping) {
+        memory = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, header.base);
+        if (!memory && header.base)
+            memory = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, nullptr);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDWR|O_CREAT, 0644);
+    if (fd == -1)
+        throw allocation_error(fmt::format("failed to open file {}", path.string()).c_str());
+    struct stat file_stat{};
+    fstat(fd, &file_stat);
+    created = (file_stat.st_size == 0);
+    if (!created) {
+        if ((pread(fd, &header, sizeof(header), 0) != sizeof(header)) || (header.magic != FILE_MAGIC) || (header.version != FILE_VERSION)) {
+            close(fd);
+            throw allocation_error(fmt::format("file {} is not a persistent arena of version {}", path.string(), FILE_VERSION).c_str());
+        }
+        // NOTE: Accessing the mapping past the end of the file raises SIGBUS, rather than failing here.
+        if (static_cast<std::uint64_t>(file_stat.st_size) < header.mapping_size) {
+            close(fd);
+            throw allocation_error(fmt::format("file {} is truncated, expected {} bytes", path.string(), header.mapping_size).c_str());
+        }
+        size = header.mapping_size;
+    }
+    else if (ftruncate(fd, size) == -1) {
+        close(fd);
+        throw allocation_error(fmt::format("failed to resize file {} to {}", path.string(), size).c_str());
+    }
+    // The previous base address is only a hint, if it's occupied the kernel picks another one
+    // and the caller relocates the pointers.
+    void* memory = mmap(header.base, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) memory = nullptr;
+#endif
+    if (!memory)
+        throw allocation_error(fmt::format("failed to map file {} of size {}", path.string(), size).c_str());
+    return memory;
+}
+
+void Arena::MemBlock::unmapFile(void* memory, std::uint64_t size) {
+#ifdef _WIN32
+    UnmapViewOfFile(memory);
+#else
+    munmap(memory, size);
 #endif
 }
 
@@ -273,20 +1075,30 @@ void Chunk::copy(const Chunk* src_chunk) {
     m_pos = src_chunk->m_pos;
 }
 
-void Chunk::pop(std::uint64_t size) { 
-    if (m_pos < size)
-        throw std::length_error(fmt::format("the size to be deducted {} exceeds the current size {}", size, m_pos));
-    m_pos -= size;
+void Chunk::throwPopUnderflow(std::uint64_t size) const {
+    throw std::length_error(fmt::format("the size to be deducted {} exceeds the current size {}", size, m_pos));
 }
 
 void Chunk::reset() noexcept { 
-    std::memset(m_start, 0, m_pos); 
+    clearMemory(m_start, m_pos); 
     m_pos = 0;
 }
 
-void Chunk::doesFit(std::uint64_t size) const {
-    if ((m_pos + size) > m_size)
-        throw std::length_error(fmt::format("not enough space to insert an object of size {}", size));
+void Chunk::fill(std::byte value) noexcept {
+    std::memset(m_start, static_cast<int>(value), m_size);
+    m_pos = 0;
+}
+
+bool Chunk::isFilledWith(std::byte value) const noexcept {
+    for (std::uint64_t i = 0; i < m_size; i++) {
+        if (m_start[i] != value)
+            return false;
+    }
+    return true;
+}
+
+void Chunk::throwNoSpace(std::uint64_t size) const {
+    throw std::length_error(fmt::format("not enough space to insert an object of size {}", size));
 }
 
 } // namespace mylib
\ No newline at end of file
@@ -1,13 +1,105 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <mutex>
 #include <memory> // std::unique_ptr
 #include <optional> // std::optional
+#include <span>
+#include <filesystem> // std::filesystem::path
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Marks the functions which only run on error paths, so they are neither inlined into the callers
+// nor laid out next to the hot code.
+#if defined(_MSC_VER) && !defined(__clang__)
+# define MYLIB_COLD __declspec(noinline)
+#else
+# define MYLIB_COLD [[gnu::cold, gnu::noinline]]
+#endif
 
 namespace mylib
 {
+class ChunkHandle;
+
+/**
+ * Controls when the memory of released chunks is cleared.
+ * Chunks handed out to requests with any policy but NO_CLEAR are always zeroed,
+ * the policy only decides whether the cost is paid by the releasing or by the acquiring side.
+*/
+enum class ClearPolicy : std::uint8_t {
+    NO_CLEAR,         // Memory is never cleared, acquired chunks may contain stale data.
+    CLEAR_ON_RELEASE, // Used bytes are cleared when the chunk is released.
+    CLEAR_ON_ACQUIRE  // Used bytes are cleared when the chunk is handed out again.
+};
+
+/**
+ * Controls when memory blocks without chunks in use are returned to the OS.
+ * The first memory block of an arena, and the memory blocks of a persistent arena are never released.
+ * The default policy never releases blocks automatically, only on an explicit Arena::trim call.
+*/
+struct TrimPolicy {
+    // Empty blocks are released once they stayed empty for this long. 
+    // NOTE: The time is only checked when the arena is called, there is no background thread.
+    std::chrono::steady_clock::duration grace_period = std::chrono::steady_clock::duration::max();
+
+    // Empty blocks are released while their total size exceeds this threshold.
+    std::uint64_t retained_bytes = std::numeric_limits<std::uint64_t>::max();
+
+    bool isEnabled() const noexcept {
+        return (grace_period != std::chrono::steady_clock::duration::max()) || 
+               (retained_bytes != std::numeric_limits<std::uint64_t>::max());
+    }
+};
+
+/**
+ * Kind of memory the arena's blocks are allocated from.
+*/
+enum class BackingMemory : std::uint8_t {
+    ANONYMOUS,  // Anonymous pages from the OS (mmap/VirtualAlloc), committed on the first touch.
+    HUGE_PAGES, // The same, but backed by huge pages where available, falls back to ANONYMOUS otherwise.
+    HEAP        // The C heap, for platforms or sandboxes where mapping memory directly is restricted.
+};
+
+/**
+ * Sizing and behaviour of an arena, the defaults match Arena::Arena(std::uint64_t).
+ * The arena grows by block_size first, and every next memory block is growth_factor times larger 
+ * than the previous one, up to max_block_size. E.g. setting block_size to initial_size and growth_factor to 2
+ * makes small arenas grow in proportion to their use, rather than jumping to a gigabyte.
+*/
+struct ArenaOptions {
+    std::uint64_t initial_size = 1024*1024*1024u;
+    std::uint64_t block_size = 1024*1024*1024u;
+    double        growth_factor = 1.0;
+    std::uint64_t max_block_size = 1024*1024*1024u;
+
+    // Chunks of this size and larger, which don't fit into the existing blocks, get a memory block of their own.
+    // It doesn't advance the growth, and it's returned to the OS as soon as the chunk is released.
+    std::uint64_t dedicated_block_threshold = std::numeric_limits<std::uint64_t>::max();
+
+    BackingMemory backing = BackingMemory::ANONYMOUS;
+    std::int32_t  numa_node = -1;
+    ClearPolicy   clear_policy = ClearPolicy::CLEAR_ON_RELEASE;
+    TrimPolicy    trim_policy{};
+    std::uint64_t max_reserved_size = std::numeric_limits<std::uint64_t>::max();
+};
+
+/**
+ * Thrown in hardened builds (MYLIB_ARENA_HARDENED) when a released chunk is accessed,
+ * released twice, or written to after it was released.
+*/
+class stale_chunk_error : public std::logic_error {
+public:
+    explicit stale_chunk_error(const std::string& msg)
+    : std::logic_error(msg)
+    {}
+};
+
 class Chunk {
 public:
     /**
@@ -24,24 +116,35 @@ public:
     }
 
     /**
-     * The same as the function above, but the object is std::move(ed) into the memory.
+     * The same as the function above, but the object is forwarded, so rvalues are std::move(ed) into the memory.
      * @throw std::length_error If not enough space for placing the object. 
      * @param obj An object to be moved.
      * @param size Object's size.
     */
     template<typename Object>
     void push(Object&& obj) {
-        doesFit(sizeof(obj));
-        *reinterpret_cast<Object*>(m_start + m_pos) = std::move(obj);
-        m_pos += sizeof(obj);
+        using Type = std::remove_cvref_t<Object>;
+        doesFit(sizeof(Type));
+        *reinterpret_cast<Type*>(m_start + m_pos) = std::forward<Object>(obj);
+        m_pos += sizeof(Type);
     }
 
+    /**
+     * Mark bytes which were written directly into the memory, e.g. by a read call, as occupied.
+     * @throw std::length_error If not enough space left in the chunk.
+     * @param size Number of bytes written starting at end().
+    */
+    void advance(std::uint64_t size) { doesFit(size); m_pos += size; }
+
     /**
      * Pop element from the memory by decrementing the position.
      * @throw std::length_error If trying to pop on an empty chunk. 
      * @param size Size of the previously inserted object.
     */
-    void pop(std::uint64_t size);
+    void pop(std::uint64_t size) {
+        if (m_pos < size) [[unlikely]] throwPopUnderflow(size);
+        m_pos -= size;
+    }
 
     /**
      * @return A pointer to the beginning of the memory chunk. 
@@ -72,7 +175,8 @@ public:
     void copy(const Chunk* src_chunk);
 
     /**
-     * 
+     * Clear the used bytes and rewind the position to the beginning of the chunk.
+     * Large chunks are cleared with non-temporal stores, so the clearing doesn't evict the caches.
     */
     void reset() noexcept;
 
@@ -80,7 +184,17 @@ private:
     friend class Arena;
 
     Chunk(std::byte* start, std::uint64_t size) noexcept;
-    void doesFit(std::uint64_t size) const;
+
+    // NOTE: Only the comparison is inlined into push and advance, the messages are formatted 
+    // by the out of line throw functions, so the callers don't carry any of the fmt code.
+    void doesFit(std::uint64_t size) const {
+        if (size > m_size - m_pos) [[unlikely]] throwNoSpace(size);
+    }
+
+    [[noreturn]] MYLIB_COLD void throwNoSpace(std::uint64_t size) const;
+    [[noreturn]] MYLIB_COLD void throwPopUnderflow(std::uint64_t size) const;
+    void fill(std::byte value) noexcept;
+    bool isFilledWith(std::byte value) const noexcept;
 
     std::byte*    m_start;
     std::uint64_t m_size;
@@ -94,42 +208,94 @@ class Arena {
         */
         enum class ChunkState : std::uint8_t {
             IN_USE,
-            FREE
+            FREE,
+            QUARANTINED
         };
         
         /**
-         * 
+         * In hardened builds the generation is incremented every time the chunk is released,
+         * so handles acquired before the release can be detected as stale.
+         * The epoch is the arena's epoch at the time the chunk was acquired.
+         * The dirty size is how many bytes at the beginning of the chunk may still hold data left by
+         * the previous owners, since acquisitions with NO_CLEAR rewind the position without clearing them.
         */
         struct ChunkHeader {
-            Chunk        chunk;
-            ChunkState   state;
-            ChunkHeader* next;
-            ChunkHeader* prev;
+            Chunk                      chunk;
+            ChunkState                 state;
+            std::atomic<std::uint32_t> generation;
+            std::uint32_t              epoch;
+            std::uint64_t              dirty_size;
+            ChunkHeader*               next;
+            ChunkHeader*               prev;
+        };
+
+    public:
+        constexpr static std::uint32_t ROOTS_COUNT{16u};
+
+    private:
+        /**
+         * Placed at the beginning of a file-backed memory block, followed by the chunks.
+         * Holds a snapshot of the block's bookkeeping, written on sync and read back on reopen.
+         * The base address is used to relocate pointers if the file cannot be mapped at the same address.
+        */
+        struct FileHeader {
+            std::uint64_t magic;
+            std::uint64_t version;
+            std::byte*    base;
+            std::uint64_t mapping_size;
+            std::uint64_t pos;
+            std::uint64_t total_chunks_count;
+            std::uint64_t empty_chunks_count;
+            std::uint64_t dirty_pos;
+            ChunkHeader*  chunks;
+            Chunk*        roots[ROOTS_COUNT];
         };
+
     public:
-        explicit MemBlock(std::uint64_t size);
+        explicit MemBlock(std::uint64_t size, std::int32_t numa_node=-1, BackingMemory backing=BackingMemory::ANONYMOUS);
+        MemBlock(const std::filesystem::path& path, std::uint64_t size);
         ~MemBlock();
 
         MemBlock(const MemBlock&) = delete;
         MemBlock& operator=(const MemBlock&) = delete;
         
-        Chunk*                newChunk(std::uint64_t size) noexcept;
-        bool                  freeChunk(Chunk* chunk) noexcept;
+        Chunk*                newChunk(std::uint64_t size, bool clear) noexcept;
+        bool                  freeChunk(Chunk* chunk, bool clear, bool quarantine=false) noexcept;
+        void                  unquarantineChunk(Chunk* chunk) noexcept;
+        bool                  contains(const Chunk* chunk) const noexcept;
         std::optional<Chunk*> getEmptyChunk(std::uint64_t size) noexcept;
+        std::uint64_t         getEmptyChunks(std::uint64_t size, std::uint64_t count, Chunk** out) noexcept;
+        std::uint64_t         newChunks(std::uint64_t size, std::uint64_t count, Chunk** out, bool clear) noexcept;
+        void                  rewind() noexcept;
+        bool                  isEmpty() const noexcept;
         std::uint64_t         totalChunks() const noexcept;
         std::uint64_t         emptyChunksCount() const noexcept;
         std::uint64_t         remainingSpace() const noexcept;
+        void                  sync();
 
     private:
         friend class Arena;
 
-        static void* allocMemory(std::uint64_t size);
-        static void  releaseMemory(void* memory);
+        static void* allocMemory(std::uint64_t size, std::int32_t numa_node, BackingMemory backing);
+        static void  releaseMemory(void* memory, std::uint64_t size, BackingMemory backing);
+        static void* mapFile(const std::filesystem::path& path, std::uint64_t& size, bool& created);
+        static void  unmapFile(void* memory, std::uint64_t size);
 
+        void rebase(std::byte* old_base) noexcept;
+        bool isChunkHeader(const Chunk* chunk) const noexcept;
+        void releaseHeader(ChunkHeader* chunk_header, bool clear, bool quarantine) noexcept;
+
+        FileHeader*   m_file_header = nullptr;
+        std::int32_t  m_numa_node = -1;
+        BackingMemory m_backing = BackingMemory::ANONYMOUS;
+        bool          m_dedicated = false;
         std::uint64_t m_pos = 0;
+        // Bytes below this position may hold data of chunks which were discarded by a rewind.
+        std::uint64_t m_dirty_pos = 0;
         std::uint64_t m_cap = 0;
         std::uint64_t m_total_chunks_count = 0;
-        std::uint64_t m_empty_chunks_count = 0; 
+        std::uint64_t m_empty_chunks_count = 0;
+        std::chrono::steady_clock::time_point m_empty_since = std::chrono::steady_clock::now();
         std::byte*    m_ptr = nullptr;
         ChunkHeader*  m_chunks = nullptr;
     };
@@ -138,9 +304,40 @@ public:
     constexpr static std::uint64_t CHUNK_HEADER_SIZE{sizeof(MemBlock::ChunkHeader)};
     constexpr static std::uint64_t PAGE_SIZE{1024u};
     constexpr static std::uint64_t DEFAULT_ALLOC_SIZE{1024*1024*1024u};
+    // Chunks of this size and larger are cleared with non-temporal stores, bypassing the caches.
+    constexpr static std::uint64_t NON_TEMPORAL_CLEAR_SIZE{256*1024u};
+    constexpr static std::uint64_t UNLIMITED_SIZE{std::numeric_limits<std::uint64_t>::max()};
     
+    constexpr static std::uint32_t ROOTS_COUNT{MemBlock::ROOTS_COUNT};
+
     Arena(std::uint64_t size=DEFAULT_ALLOC_SIZE);
 
+    /**
+     * @throw std::invalid_argument If the growth factor is less than 1, or any of the block sizes is 0.
+    */
+    explicit Arena(const ArenaOptions& options);
+
+    /**
+     * Create a persistent arena backed by a memory-mapped file, or reopen it if the file exists.
+     * Chunks live directly in the file, so data pushed into them survives restarts without any parsing.
+     * A persistent arena consists of a single memory block and doesn't grow.
+     * The snapshot on disk is consistent after a call to sync() or after the arena is destroyed.
+     * Only trivially copyable data without pointers can be stored, since the file might be
+     * mapped at a different address on reopen.
+     * @param path File to map.
+     * @param size Capacity of a new file, ignored when reopening an existing one.
+    */
+    explicit Arena(const std::filesystem::path& path, std::uint64_t size=DEFAULT_ALLOC_SIZE);
+
+    /**
+     * Create an arena whose memory blocks, including the ones allocated when growing,
+     * are bound to a NUMA node. The binding is a preference, if the node runs out of memory,
+     * or the platform doesn't support NUMA policies, memory is taken from other nodes.
+     * @param size Size of the first memory block.
+     * @param numa_node Node to bind the memory to, -1 for no binding.
+    */
+    Arena(std::uint64_t size, std::int32_t numa_node);
+
     Arena(const Arena&) = delete;
     Arena& operator=(const Arena&) = delete;
     
@@ -149,14 +346,213 @@ public:
 
     Chunk*        getChunk(std::uint64_t size, Chunk* old_chunk=nullptr);
     void          releaseChunk(Chunk* chunk);
+
+    /**
+     * The same as above, but override the arena's clear policy for a single request.
+     * Acquiring with ClearPolicy::NO_CLEAR skips clearing the memory left by the previous owner.
+     * Releasing with anything but ClearPolicy::CLEAR_ON_RELEASE defers clearing to the next acquisition.
+    */
+    Chunk*        getChunk(std::uint64_t size, ClearPolicy policy, Chunk* old_chunk=nullptr);
+    void          releaseChunk(Chunk* chunk, ClearPolicy policy);
+
+    /**
+     * Acquire count chunks of the same size under a single lock. Free chunks are collected
+     * in one pass over each block, and the rest are carved from a block back to back.
+     * If any acquisition fails, the chunks acquired so far are released before rethrowing.
+     * @param out Array of at least count pointers to store the chunks into.
+     * @throw allocation_error If a new memory block cannot be allocated.
+     * @throw std::length_error If a persistent arena runs out of space.
+    */
+    void          getChunks(std::uint64_t size, std::uint64_t count, Chunk** out);
+
+    /**
+     * Release a group of chunks under a single lock, null pointers are skipped.
+    */
+    void          releaseChunks(std::span<Chunk* const> chunks);
+
+    /**
+     * Release all the chunks at once by rewinding every memory block to its beginning,
+     * which takes O(blocks) time rather than walking the chunks. Memory blocks are kept,
+     * and all the pointers and handles to the chunks acquired before the call become invalid.
+     * Roots of a persistent arena are cleared as well.
+     * The memory is cleared lazily, when chunks are carved from it again.
+    */
+    void          reset();
+
+    /**
+     * Chunks are tagged with the epoch which is current at the time they are acquired, 
+     * so a group of chunks with the same lifetime, e.g. everything allocated while processing a batch,
+     * can be released with a single retireEpoch call. Chunks acquired before the first call to beginEpoch have epoch 0.
+     * @return The new current epoch.
+    */
+    std::uint32_t beginEpoch();
+    std::uint32_t currentEpoch() const;
+
+    /**
+     * Release all the chunks of the epoch which are still in use. Memory blocks which only hold chunks 
+     * of this epoch are rewound like in reset, instead of releasing their chunks one by one.
+     * @return Number of released chunks.
+    */
+    std::uint64_t retireEpoch(std::uint32_t epoch);
+
+    /**
+     * Set the default clear policy, ClearPolicy::CLEAR_ON_RELEASE unless changed.
+    */
+    void          setClearPolicy(ClearPolicy policy);
+    ClearPolicy   clearPolicy() const;
+
+    /**
+     * The same as getChunk, but the chunk is wrapped into a generational handle.
+     * In hardened builds accessing the chunk through a handle after it was released throws stale_chunk_error.
+    */
+    ChunkHandle   getChunkHandle(std::uint64_t size);
+    void          releaseChunk(const ChunkHandle& handle);
+
+    /**
+     * Keep up to count released chunks out of circulation before they can be reused,
+     * so stale pointers have a longer window to be caught writing into poisoned memory.
+     * Quarantined chunks are not counted as empty. 0 disables the quarantine.
+    */
+    void          setQuarantineSize(std::uint64_t count);
     std::uint64_t emptyChunksCount() const;
     std::uint64_t totalChunks() const;
     std::uint64_t totalBlocks() const;
 
+    /**
+     * @return Total size of all the memory blocks reserved by the arena.
+    */
+    std::uint64_t reservedSize() const;
+
+    /**
+     * Release all the memory blocks without chunks in use, except the first one, regardless of the trim policy.
+     * @return Number of bytes returned to the OS.
+    */
+    std::uint64_t trim();
+
+    /**
+     * Set the policy for releasing empty memory blocks automatically, it's applied when chunks are released.
+    */
+    void          setTrimPolicy(const TrimPolicy& policy);
+    TrimPolicy    trimPolicy() const;
+
+    /**
+     * Limit the total size of the memory blocks, UNLIMITED_SIZE by default.
+     * When a new block would exceed the limit, empty blocks are trimmed first, 
+     * and the new block is shrunk to the remaining space if possible.
+     * Requests which still don't fit throw std::length_error, the arena stays intact.
+    */
+    void          setMaxReservedSize(std::uint64_t size);
+    std::uint64_t maxReservedSize() const;
+
+    /**
+     * @return true if the chunk was carved out of one of the arena's memory blocks.
+    */
+    bool          contains(const Chunk* chunk) const;
+    std::int32_t  numaNode() const noexcept { return m_options.numa_node; }
+    bool          isPersistent() const noexcept { return m_persistent; }
+
+    /**
+     * Flush the bookkeeping and the content of a persistent arena to its file.
+    */
+    void          sync();
+
+    /**
+     * Roots are slots in a persistent arena's file used to find chunks after reopening.
+     * @throw std::logic_error If the arena is not persistent.
+     * @throw std::out_of_range If slot is greater or equal to ROOTS_COUNT.
+    */
+    void          setRoot(std::uint32_t slot, Chunk* chunk);
+    Chunk*        root(std::uint32_t slot) const;
+
 private:
+    friend class ChunkHandle;
+
+    // Poison pattern written over released chunks in hardened builds.
+    constexpr static std::byte POISON{0xdd};
+
+    static std::uint32_t chunkGeneration(const Chunk* chunk) noexcept {
+        return reinterpret_cast<const MemBlock::ChunkHeader*>(chunk)->generation.load(std::memory_order_acquire);
+    }
+
+    // Size of the chunk and its header rounded up to PAGE_SIZE.
+    static std::uint64_t allocationSize(std::uint64_t size) noexcept;
+
+    // The old chunk passed to getChunk may live in any memory block, not necessarily
+    // the one the new chunk was carved from. Expects m_mutex to be held by the caller.
+    void      freeChunkLocked(Chunk* chunk, ClearPolicy policy);
+    Chunk*    getChunkLocked(std::uint64_t size, ClearPolicy policy, Chunk* old_chunk);
+    void      getChunksLocked(std::uint64_t total_size, std::uint64_t count, Chunk** out, ClearPolicy policy);
+    MemBlock* newBlockLocked(std::uint64_t size, bool dedicated=false);
+    std::uint64_t trimLocked(bool force);
+    std::uint64_t reservedSizeLocked() const noexcept;
+    MemBlock* findBlockLocked(const Chunk* chunk) const noexcept;
+    void      quarantineLocked(Chunk* chunk) noexcept;
+    void      prepareEmptyChunk(Chunk* chunk, ClearPolicy policy) const;
+    Chunk*    tagChunk(Chunk* chunk) const noexcept;
+
+    bool                                 m_persistent = false;
+    ArenaOptions                         m_options;
+    std::uint64_t                        m_next_block_size = 0;
+    std::uint32_t                        m_epoch = 0;
     std::uint64_t                        m_blocks_count = 0;
+    std::uint64_t                        m_dedicated_blocks_count = 0;
     std::list<std::unique_ptr<MemBlock>> m_blocks;
+    std::vector<Chunk*>                  m_quarantine;
+    std::uint64_t                        m_quarantine_head = 0;
+    std::uint64_t                        m_quarantine_count = 0;
     mutable std::mutex                   m_mutex;
 };
 
+/**
+ * Chunk reference with a generation captured at acquisition. In hardened builds (MYLIB_ARENA_HARDENED)
+ * every access compares it with the chunk's current generation, in regular builds the handle
+ * is just a pointer and the checks are compiled away.
+*/
+class ChunkHandle {
+public:
+    ChunkHandle() noexcept = default;
+
+    /**
+     * @throw stale_chunk_error In hardened builds, if the chunk was released since the handle was acquired.
+    */
+    Chunk* get() const {
+#ifdef MYLIB_ARENA_HARDENED
+        if (m_chunk && (Arena::chunkGeneration(m_chunk) != m_generation))
+            throw stale_chunk_error("access to a released chunk through a stale handle");
+#endif
+        return m_chunk;
+    }
+
+    Chunk* operator->() const { return get(); }
+
+    explicit operator bool() const noexcept { return m_chunk != nullptr; }
+
+    /**
+     * @return false if the chunk was released since the handle was acquired,
+     * always true for non-empty handles in regular builds.
+    */
+    bool isValid() const noexcept {
+#ifdef MYLIB_ARENA_HARDENED
+        return m_chunk && (Arena::chunkGeneration(m_chunk) == m_generation);
+#else
+        return m_chunk != nullptr;
+#endif
+    }
+
+private:
+    friend class Arena;
+
+    explicit ChunkHandle(Chunk* chunk) noexcept
+    : m_chunk(chunk) 
+#ifdef MYLIB_ARENA_HARDENED
+    , m_generation(Arena::chunkGeneration(chunk))
+#endif
+    {}
+
+    Chunk*        m_chunk = nullptr;
+#ifdef MYLIB_ARENA_HARDENED
+    std::uint32_t m_generation = 0;
+#endif
+};
+
 } // namespace mylib
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "arena_resource.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace mylib
+{
+
+ArenaResource::ArenaResource(Arena* arena, std::uint64_t chunk_size) noexcept
+: m_arena(arena), m_chunk_size(chunk_size) {}
+
+ArenaResource::~ArenaResource() {
+    release();
+}
+
+void ArenaResource::release() noexcept {
+    // NOTE: Chunks are linked into an intrusive list, the first bytes of every chunk
+    // hold a pointer to the previously acquired chunk, so no extra memory is required to track them.
+    while (m_chunks) {
+        Chunk* prev = *reinterpret_cast<Chunk**>(m_chunks->begin());
+        m_arena->releaseChunk(m_chunks);
+        m_chunks = prev;
+    }
+    m_current = nullptr;
+    m_allocated_bytes = 0;
+    m_free_lists.fill(nullptr);
+}
+
+void* ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    std::uint64_t index = sizeClassIndex(bytes, alignment);
+    if (index == SIZE_CLASSES_COUNT) {
+        return bump(bytes, alignment);
+    }
+
+    if (FreeNode* node = m_free_lists[index]) {
+        m_free_lists[index] = node->next;
+        return node;
+    }
+
+    const std::uint64_t class_size = MIN_SIZE_CLASS << index;
+    return bump(class_size, std::min<std::uint64_t>(class_size, alignof(std::max_align_t)));
+}
+
+void ArenaResource::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) {
+    std::uint64_t index = sizeClassIndex(bytes, alignment);
+    if (!ptr || (index == SIZE_CLASSES_COUNT)) {
+        return;
+    }
+    auto* node = static_cast<FreeNode*>(ptr);
+    node->next = m_free_lists[index];
+    m_free_lists[index] = node;
+}
+
+bool ArenaResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+std::uint64_t ArenaResource::sizeClassIndex(std::size_t bytes, std::size_t alignment) noexcept {
+    // Blocks of a size class are aligned by min(class size, alignof(std::max_align_t)),
+    // over-aligned requests bypass the free lists.
+    std::uint64_t class_size = std::bit_ceil(std::max<std::uint64_t>(bytes, MIN_SIZE_CLASS));
+    if ((class_size > MAX_SIZE_CLASS) ||
+        (alignment > std::min<std::uint64_t>(class_size, alignof(std::max_align_t)))) {
+        return SIZE_CLASSES_COUNT;
+    }
+    return std::countr_zero(class_size) - std::countr_zero(MIN_SIZE_CLASS);
+}
+
+void* ArenaResource::bump(std::uint64_t bytes, std::uint64_t alignment) {
+    auto padding = [](Chunk* chunk, std::uint64_t alignment) {
+        std::uint64_t rem = reinterpret_cast<std::uintptr_t>(chunk->end()) % alignment;
+        return (rem == 0) ? 0 : (alignment - rem);
+    };
+
+    if (!m_current || (m_current->remainingSpace() < bytes + padding(m_current, alignment))) {
+        // Allocations larger than a quarter of the regular chunk get a dedicated chunk,
+        // so they don't waste the rest of the current one.
+        const std::uint64_t required = bytes + alignment + sizeof(Chunk*);
+        if (required > m_chunk_size / 4) {
+            Chunk* chunk = newChunk(required);
+            chunk->advance(padding(chunk, alignment));
+            void* ptr = chunk->end();
+            chunk->advance(bytes);
+            return ptr;
+        }
+        m_current = newChunk(m_chunk_size);
+    }
+
+    m_current->advance(padding(m_current, alignment));
+    void* ptr = m_current->end();
+    m_current->advance(bytes);
+    return ptr;
+}
+
+Chunk* ArenaResource::newChunk(std::uint64_t size) {
+    Chunk* chunk = m_arena->getChunk(size);
+    chunk->push<Chunk*>(m_chunks);
+    m_chunks = chunk;
+    m_allocated_bytes += chunk->size();
+    return chunk;
+}
+
+} // namespace mylib
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "arena.h"
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+
+namespace mylib
+{
+/**
+ * Polymorphic memory resource which carves allocations out of arena chunks with a bump pointer.
+ * Deallocated blocks of small sizes are kept in per size class free lists and reused by the
+ * following allocations of the same class, larger blocks are only returned to the arena on release().
+ * The resource itself is not thread-safe, similar to a chunk it's meant to be owned by a single thread,
+ * whereas the arena underneath can be shared.
+*/
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    constexpr static std::uint64_t DEFAULT_CHUNK_SIZE{64u*1024u};
+    constexpr static std::uint64_t MIN_SIZE_CLASS{8u};
+    constexpr static std::uint64_t MAX_SIZE_CLASS{4096u};
+    constexpr static std::uint64_t SIZE_CLASSES_COUNT{10u}; // 8, 16, ..., 4096
+
+    explicit ArenaResource(Arena* arena, std::uint64_t chunk_size=DEFAULT_CHUNK_SIZE) noexcept;
+    ~ArenaResource() override;
+
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+
+    /**
+     * Return all the chunks to the arena, invalidating every allocation made through this resource.
+    */
+    void release() noexcept;
+
+    Arena* arena() const noexcept { return m_arena; }
+
+    /**
+     * @return Total number of bytes taken from the arena chunks, including the free lists.
+    */
+    std::uint64_t allocatedBytes() const noexcept { return m_allocated_bytes; }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void  do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    static std::uint64_t sizeClassIndex(std::size_t bytes, std::size_t alignment) noexcept;
+    void*                bump(std::uint64_t bytes, std::uint64_t alignment);
+    Chunk*               newChunk(std::uint64_t size);
+
+    Arena*                                      m_arena;
+    std::uint64_t                               m_chunk_size;
+    std::uint64_t                               m_allocated_bytes = 0;
+    Chunk*                                      m_current = nullptr;
+    Chunk*                                      m_chunks = nullptr;
+    std::array<FreeNode*, SIZE_CLASSES_COUNT>   m_free_lists{};
+};
+
+/**
+ * Standard allocator over ArenaResource, can be plugged into any STL container,
+ * e.g. std::vector<int, ArenaAllocator<int>>.
+*/
+template<class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(ArenaResource* resource) noexcept
+    : m_resource(resource) {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs) noexcept
+    : m_resource(rhs.resource()) {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(m_resource->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept { m_resource->deallocate(ptr, n*sizeof(T), alignof(T)); }
+
+    ArenaResource* resource() const noexcept { return m_resource; }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& rhs) const noexcept { return m_resource == rhs.resource(); }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const noexcept { return !(*this == rhs); }
+
+private:
+    ArenaResource* m_resource;
+};
+
+} // namespace mylib
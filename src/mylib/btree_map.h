@@ -0,0 +1,685 @@
+#pragma once
+
+#include "arena.h"
+#include "growing_array.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+# include <immintrin.h>
+#endif
+
+namespace mylib
+{
+namespace detail
+{
+template<class Key, class Compare>
+constexpr bool SIMD_SEARCHABLE = std::is_same_v<Compare, std::less<Key>> && std::is_integral_v<Key> &&
+                                 !std::is_same_v<Key, bool> && ((sizeof(Key) == 4) || (sizeof(Key) == 8));
+
+/**
+ * Number of keys less than key (lower bound), or less or equal to key if OR_EQUAL is set (upper bound).
+ * Keys are sorted, so counting them gives the same position as a binary search, but without any branches,
+ * and a node's worth of keys is compared a vector at a time. Unsigned keys are compared as signed ones
+ * with the sign bit flipped, since SSE2 and AVX2 only have signed comparisons. 64-bit keys use AVX2
+ * when it is enabled at compile time (MYLIB_AVX2), and a 64-bit comparison emulated with SSE2 otherwise.
+*/
+template<bool OR_EQUAL, class Key>
+std::uint32_t countBelow(const Key* keys, std::uint32_t count, Key key) noexcept {
+    std::uint32_t i = 0;
+    std::uint32_t result = 0;
+    if constexpr (sizeof(Key) == 4) {
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i flip = _mm_set1_epi32(std::is_unsigned_v<Key> ? std::numeric_limits<std::int32_t>::min() : 0);
+        const __m128i needle = _mm_xor_si128(_mm_set1_epi32(static_cast<std::int32_t>(key)), flip);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i lane = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), flip);
+            const __m128i mask = OR_EQUAL ? _mm_cmpgt_epi32(lane, needle) : _mm_cmpgt_epi32(needle, lane);
+            const auto matches = static_cast<std::uint32_t>(std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask)))));
+            result += OR_EQUAL ? (4 - matches) : matches;
+        }
+#endif
+    }
+    else {
+#if defined(__AVX2__)
+        const __m256i flip = _mm256_set1_epi64x(std::is_unsigned_v<Key> ? std::numeric_limits<std::int64_t>::min() : 0);
+        const __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<std::int64_t>(key)), flip);
+        for (; i + 4 <= count; i += 4) {
+            const __m256i lane = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+            const __m256i mask = OR_EQUAL ? _mm256_cmpgt_epi64(lane, needle) : _mm256_cmpgt_epi64(needle, lane);
+            const auto matches = static_cast<std::uint32_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(mask)))));
+            result += OR_EQUAL ? (4 - matches) : matches;
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        // SSE2 has no 64-bit comparison, it's composed of 32-bit ones. The high halves decide unless they're equal,
+        // then the low halves do, compared as unsigned by flipping their sign bits as well.
+        const std::int64_t low_flip = std::int64_t{1} << 31;
+        const __m128i flip = _mm_set1_epi64x(std::is_unsigned_v<Key> ? (std::numeric_limits<std::int64_t>::min() | low_flip) : low_flip);
+        const __m128i needle = _mm_xor_si128(_mm_set1_epi64x(static_cast<std::int64_t>(key)), flip);
+        for (; i + 2 <= count; i += 2) {
+            const __m128i lane = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), flip);
+            const __m128i lhs = OR_EQUAL ? lane : needle;
+            const __m128i rhs = OR_EQUAL ? needle : lane;
+            const __m128i greater = _mm_cmpgt_epi32(lhs, rhs);
+            const __m128i equal = _mm_cmpeq_epi32(lhs, rhs);
+            const __m128i mask = _mm_or_si128(_mm_shuffle_epi32(greater, _MM_SHUFFLE(3, 3, 1, 1)),
+                                              _mm_and_si128(_mm_shuffle_epi32(equal, _MM_SHUFFLE(3, 3, 1, 1)),
+                                                            _mm_shuffle_epi32(greater, _MM_SHUFFLE(2, 2, 0, 0))));
+            const auto matches = static_cast<std::uint32_t>(std::popcount(static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(mask)))));
+            result += OR_EQUAL ? (2 - matches) : matches;
+        }
+#endif
+    }
+    // NOTE: Without the intrinsics this loop is still branchless, and compilers vectorize it.
+    for (; i < count; i++) {
+        result += OR_EQUAL ? static_cast<std::uint32_t>(!(key < keys[i])) : static_cast<std::uint32_t>(keys[i] < key);
+    }
+    return result;
+}
+} // namespace detail
+
+/**
+ * Ordered map implemented as a B+tree. Elements are stored in the leaves only, and the leaves are linked,
+ * so a range scan walks contiguous arrays of keys and values rather than chasing a pointer per element.
+ * Nodes are multiples of a cache line, NODE_SIZE bytes unless the keys or values are too large to fit a few,
+ * and are carved from arena chunks (slabs), thus there is no allocation per element.
+ * Nodes are searched with SIMD comparisons for integral keys ordered by std::less, and with std::lower_bound otherwise.
+ * Erasing doesn't rebalance the tree, a node is only freed once it becomes empty.
+ * Keys and values are relocated with memmove, so both have to be trivially copyable.
+ * Any insertion or erasure invalidates the iterators.
+*/
+template<class Key, class Value, class Compare = std::less<Key>>
+class BTreeMap {
+    static_assert(std::is_trivially_copyable_v<Key>, "keys have to be trivially copyable");
+    static_assert(std::is_trivially_copyable_v<Value>, "values have to be trivially copyable");
+
+public:
+    constexpr static std::uint64_t CACHE_LINE_SIZE{64u};
+    constexpr static std::uint64_t NODE_SIZE{512u};
+    constexpr static std::uint64_t SLAB_SIZE{64u*1024u};
+
+private:
+    struct Node {
+        std::uint16_t count; // Number of keys.
+        bool          leaf;
+    };
+
+    constexpr static std::uint64_t LEAF_CAPACITY{
+        std::max<std::uint64_t>(3, (NODE_SIZE - sizeof(Node) - 2*sizeof(void*)) / (sizeof(Key) + sizeof(Value)))
+    };
+    constexpr static std::uint64_t INNER_CAPACITY{
+        std::max<std::uint64_t>(3, (NODE_SIZE - sizeof(Node) - sizeof(void*)) / (sizeof(Key) + sizeof(void*)))
+    };
+    static_assert(LEAF_CAPACITY <= std::numeric_limits<std::uint16_t>::max());
+    static_assert(INNER_CAPACITY <= std::numeric_limits<std::uint16_t>::max());
+
+    // Keys and values are kept in raw storage, so they don't have to be default constructible.
+    struct alignas(CACHE_LINE_SIZE) Leaf : Node {
+        Leaf* prev;
+        Leaf* next;
+        alignas(Key)   std::byte key_bytes[sizeof(Key)*LEAF_CAPACITY];
+        alignas(Value) std::byte value_bytes[sizeof(Value)*LEAF_CAPACITY];
+
+        Key*   keys() noexcept { return std::launder(reinterpret_cast<Key*>(key_bytes)); }
+        Value* values() noexcept { return std::launder(reinterpret_cast<Value*>(value_bytes)); }
+    };
+
+    // keys[i] is the smallest key of the subtree children[i + 1].
+    struct alignas(CACHE_LINE_SIZE) Inner : Node {
+        alignas(Key) std::byte key_bytes[sizeof(Key)*INNER_CAPACITY];
+        Node*                  children[INNER_CAPACITY + 1];
+
+        Key* keys() noexcept { return std::launder(reinterpret_cast<Key*>(key_bytes)); }
+    };
+
+    constexpr static std::uint64_t NODE_SLOT_SIZE{std::max(sizeof(Leaf), sizeof(Inner))};
+    // Nodes of large values don't fit into SLAB_SIZE, even a single one, since a leaf holds at least 3 values.
+    constexpr static std::uint64_t SLAB_CHUNK_SIZE{std::max<std::uint64_t>(SLAB_SIZE, sizeof(Chunk*) + CACHE_LINE_SIZE + NODE_SLOT_SIZE)};
+    constexpr static std::uint64_t MAX_DEPTH{64u};
+
+    // Nodes from the root down to a leaf, with the index of the child taken at each level.
+    struct Path {
+        Inner*        nodes[MAX_DEPTH];
+        std::uint16_t slots[MAX_DEPTH];
+        std::uint64_t depth = 0;
+    };
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    template<bool CONST>
+    class Iterator {
+        using value_reference = std::conditional_t<CONST, const Value&, Value&>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const Key&, value_reference>;
+
+        Iterator() noexcept = default;
+
+        template<bool RHS_CONST, class = std::enable_if_t<CONST && !RHS_CONST>>
+        Iterator(const Iterator<RHS_CONST>& rhs) noexcept
+        : m_leaf(rhs.m_leaf), m_index(rhs.m_index) {}
+
+        const Key&      key() const noexcept { return m_leaf->keys()[m_index]; }
+        value_reference value() const noexcept { return m_leaf->values()[m_index]; }
+        reference       operator*() const noexcept { return reference(key(), value()); }
+
+        Iterator& operator++() noexcept {
+            if (++m_index == m_leaf->count) {
+                m_leaf = m_leaf->next;
+                m_index = 0;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept { Iterator tmp = *this; ++(*this); return tmp; }
+
+        template<bool RHS_CONST>
+        bool operator==(const Iterator<RHS_CONST>& rhs) const noexcept {
+            return (m_leaf == rhs.m_leaf) && (m_index == rhs.m_index);
+        }
+
+    private:
+        friend class BTreeMap;
+        template<bool> friend class Iterator;
+
+        Iterator(Leaf* leaf, std::uint32_t index) noexcept
+        : m_leaf(leaf), m_index(index) {}
+
+        Leaf*         m_leaf = nullptr;
+        std::uint32_t m_index = 0;
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit BTreeMap(Arena* arena, Compare compare=Compare{}) noexcept
+    : m_arena(arena), m_compare(std::move(compare)) {}
+
+    ~BTreeMap() noexcept { releaseSlabs(); }
+
+    BTreeMap(const BTreeMap&) = delete;
+    BTreeMap& operator=(const BTreeMap&) = delete;
+
+    BTreeMap(BTreeMap&& rhs) noexcept
+    : m_arena(rhs.m_arena), m_compare(std::move(rhs.m_compare)) { take(rhs); }
+
+    BTreeMap& operator=(BTreeMap&& rhs) noexcept {
+        if (this == &rhs) return *this;
+        releaseSlabs();
+        m_arena = rhs.m_arena;
+        m_compare = std::move(rhs.m_compare);
+        take(rhs);
+        return *this;
+    }
+
+    /**
+     * Insert the element if there is no element with the same key.
+     * @return Iterator to the element with the key, and whether the insertion took place.
+    */
+    std::pair<iterator, bool> insert(const Key& key, const Value& value) {
+        return insertImpl(key, value, false);
+    }
+
+    /**
+     * Insert the element, or assign value to the element which already has the key.
+    */
+    std::pair<iterator, bool> insert_or_assign(const Key& key, const Value& value) {
+        return insertImpl(key, value, true);
+    }
+
+    /**
+     * @return Value of the element with the key, a value-initialized element is inserted if there is none.
+    */
+    Value& operator[](const Key& key) {
+        return insertImpl(key, Value{}, false).first.value();
+    }
+
+    /**
+     * @throw std::out_of_range If there is no element with the key.
+    */
+    Value& at(const Key& key) {
+        iterator itr = find(key);
+        if (itr == end())
+            throw std::out_of_range("key is not in the map");
+        return itr.value();
+    }
+
+    const Value& at(const Key& key) const {
+        return const_cast<BTreeMap*>(this)->at(key);
+    }
+
+    iterator find(const Key& key) noexcept {
+        iterator itr = lower_bound(key);
+        return ((itr != end()) && !m_compare(key, itr.key())) ? itr : end();
+    }
+
+    const_iterator find(const Key& key) const noexcept { return const_cast<BTreeMap*>(this)->find(key); }
+    bool           contains(const Key& key) const noexcept { return find(key) != end(); }
+
+    /**
+     * @return Iterator to the first element whose key is not less than key.
+    */
+    iterator lower_bound(const Key& key) noexcept {
+        if (!m_root) return end();
+        Leaf* leaf = findLeaf(key, nullptr);
+        return normalize(leaf, lowerBound(leaf->keys(), leaf->count, key));
+    }
+
+    /**
+     * @return Iterator to the first element whose key is greater than key.
+    */
+    iterator upper_bound(const Key& key) noexcept {
+        if (!m_root) return end();
+        Leaf* leaf = findLeaf(key, nullptr);
+        return normalize(leaf, upperBound(leaf->keys(), leaf->count, key));
+    }
+
+    const_iterator lower_bound(const Key& key) const noexcept { return const_cast<BTreeMap*>(this)->lower_bound(key); }
+    const_iterator upper_bound(const Key& key) const noexcept { return const_cast<BTreeMap*>(this)->upper_bound(key); }
+
+    /**
+     * Invoke f(key, value) for every element with a key in [from, to) in ascending order.
+     * Faster than iterating from lower_bound, since the elements of a leaf are visited in a tight loop.
+    */
+    template<class F>
+    void scan(const Key& from, const Key& to, F&& f) const {
+        if (!m_root) return;
+        Leaf* leaf = const_cast<BTreeMap*>(this)->findLeaf(from, nullptr);
+        std::uint32_t index = lowerBound(leaf->keys(), leaf->count, from);
+        while (leaf) {
+            const Key* keys = leaf->keys();
+            const Value* values = leaf->values();
+            for (; index < leaf->count; index++) {
+                if (!m_compare(keys[index], to)) return;
+                f(keys[index], values[index]);
+            }
+            leaf = leaf->next;
+            index = 0;
+        }
+    }
+
+    /**
+     * @return Number of elements erased, 0 or 1.
+    */
+    std::size_t erase(const Key& key) noexcept {
+        if (!m_root) return 0;
+        Path path;
+        Leaf* leaf = findLeaf(key, &path);
+        const std::uint32_t index = lowerBound(leaf->keys(), leaf->count, key);
+        if ((index == leaf->count) || m_compare(key, leaf->keys()[index])) return 0;
+
+        removeAt(leaf->keys(), leaf->count, index);
+        removeAt(leaf->values(), leaf->count, index);
+        leaf->count -= 1;
+        m_size -= 1;
+        if (!leaf->count && (leaf != m_root)) {
+            removeLeaf(leaf, path);
+        }
+        return 1;
+    }
+
+    /**
+     * Replace the content with the elements of sorted, which have to be in strictly ascending order by key.
+     * The tree is built bottom-up with full leaves, which is much faster than inserting the elements one by one,
+     * and gives the most compact tree for read-mostly data.
+     * @throw std::invalid_argument If the keys are not in strictly ascending order.
+    */
+    void bulk_load(const GrowingArray<std::pair<Key, Value>>& sorted) {
+        const std::pair<Key, Value>* elements = sorted.data();
+        const std::uint64_t count = sorted.size();
+        for (std::uint64_t i = 1; i < count; i++) {
+            if (!m_compare(elements[i - 1].first, elements[i].first))
+                throw std::invalid_argument(fmt::format("keys are not in strictly ascending order at index {}", i));
+        }
+
+        clear();
+        if (!count) return;
+
+        // Spread the elements evenly, so the last node of a level isn't left almost empty.
+        std::vector<Node*> level;
+        std::vector<Key> first_keys;
+        const std::uint64_t leaves_count = (count + LEAF_CAPACITY - 1) / LEAF_CAPACITY;
+        Leaf* prev = nullptr;
+        std::uint64_t next_element = 0;
+        for (std::uint64_t i = 0; i < leaves_count; i++) {
+            const std::uint64_t leaf_count = count / leaves_count + ((i < count % leaves_count) ? 1 : 0);
+            Leaf* leaf = newLeaf();
+            for (std::uint64_t j = 0; j < leaf_count; j++) {
+                new (leaf->keys() + j) Key(elements[next_element + j].first);
+                new (leaf->values() + j) Value(elements[next_element + j].second);
+            }
+            leaf->count = static_cast<std::uint16_t>(leaf_count);
+            leaf->prev = prev;
+            if (prev) prev->next = leaf;
+            else m_first = leaf;
+            prev = leaf;
+            next_element += leaf_count;
+            level.push_back(leaf);
+            first_keys.push_back(leaf->keys()[0]);
+        }
+
+        while (level.size() > 1) {
+            std::vector<Node*> parents;
+            std::vector<Key> parent_first_keys;
+            const std::uint64_t fanout = INNER_CAPACITY + 1;
+            const std::uint64_t parents_count = (level.size() + fanout - 1) / fanout;
+            std::uint64_t next_child = 0;
+            for (std::uint64_t i = 0; i < parents_count; i++) {
+                const std::uint64_t children_count = level.size() / parents_count + ((i < level.size() % parents_count) ? 1 : 0);
+                Inner* inner = newInner();
+                for (std::uint64_t j = 0; j < children_count; j++) {
+                    inner->children[j] = level[next_child + j];
+                    if (j) new (inner->keys() + j - 1) Key(first_keys[next_child + j]);
+                }
+                inner->count = static_cast<std::uint16_t>(children_count - 1);
+                parents.push_back(inner);
+                parent_first_keys.push_back(first_keys[next_child]);
+                next_child += children_count;
+            }
+            level = std::move(parents);
+            first_keys = std::move(parent_first_keys);
+        }
+        m_root = level.front();
+        m_size = count;
+    }
+
+    // NOTE: The root leaf is kept when the last element is erased, hence the check.
+    iterator       begin() noexcept { return m_size ? iterator(m_first, 0) : end(); }
+    iterator       end() noexcept { return iterator(); }
+    const_iterator begin() const noexcept { return m_size ? const_iterator(m_first, 0) : end(); }
+    const_iterator end() const noexcept { return const_iterator(); }
+
+    std::size_t size() const noexcept { return m_size; }
+    bool        empty() const noexcept { return m_size == 0; }
+
+    /**
+     * @return Number of levels, 0 for an empty map.
+    */
+    std::uint64_t height() const noexcept {
+        std::uint64_t height = 0;
+        for (Node* node = m_root; node; node = node->leaf ? nullptr : static_cast<Inner*>(node)->children[0]) {
+            height += 1;
+        }
+        return height;
+    }
+
+    /**
+     * Remove all the elements, and return the slabs to the arena.
+    */
+    void clear() noexcept {
+        releaseSlabs();
+        m_root = nullptr;
+        m_first = nullptr;
+        m_free_nodes = nullptr;
+        m_carve_pos = m_carve_end = nullptr;
+        m_size = 0;
+    }
+
+private:
+    std::uint32_t lowerBound(const Key* keys, std::uint32_t count, const Key& key) const noexcept {
+        if constexpr (detail::SIMD_SEARCHABLE<Key, Compare>) {
+            return detail::countBelow<false>(keys, count, key);
+        }
+        else {
+            return static_cast<std::uint32_t>(std::lower_bound(keys, keys + count, key, m_compare) - keys);
+        }
+    }
+
+    std::uint32_t upperBound(const Key* keys, std::uint32_t count, const Key& key) const noexcept {
+        if constexpr (detail::SIMD_SEARCHABLE<Key, Compare>) {
+            return detail::countBelow<true>(keys, count, key);
+        }
+        else {
+            return static_cast<std::uint32_t>(std::upper_bound(keys, keys + count, key, m_compare) - keys);
+        }
+    }
+
+    // An index past the end of a leaf points to the first element of the next leaf.
+    static iterator normalize(Leaf* leaf, std::uint32_t index) noexcept {
+        if (index < leaf->count) return iterator(leaf, index);
+        return leaf->next ? iterator(leaf->next, 0) : iterator();
+    }
+
+    Leaf* findLeaf(const Key& key, Path* path) noexcept {
+        Node* node = m_root;
+        while (!node->leaf) {
+            auto* inner = static_cast<Inner*>(node);
+            const std::uint32_t slot = upperBound(inner->keys(), inner->count, key);
+            if (path) {
+                path->nodes[path->depth] = inner;
+                path->slots[path->depth] = static_cast<std::uint16_t>(slot);
+                path->depth += 1;
+            }
+            node = inner->children[slot];
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    std::pair<iterator, bool> insertImpl(const Key& key, const Value& value, bool assign) {
+        if (!m_root) {
+            m_first = newLeaf();
+            m_root = m_first;
+        }
+
+        Path path;
+        Leaf* leaf = findLeaf(key, &path);
+        std::uint32_t index = lowerBound(leaf->keys(), leaf->count, key);
+        if ((index < leaf->count) && !m_compare(key, leaf->keys()[index])) {
+            if (assign) leaf->values()[index] = value;
+            return {iterator(leaf, index), false};
+        }
+
+        if (leaf->count == LEAF_CAPACITY) {
+            // Split in half, and insert into the half the key belongs to.
+            Leaf* right = newLeaf();
+            const std::uint32_t left_count = static_cast<std::uint32_t>(LEAF_CAPACITY / 2);
+            const std::uint32_t right_count = static_cast<std::uint32_t>(LEAF_CAPACITY) - left_count;
+            std::memcpy(right->keys(), leaf->keys() + left_count, sizeof(Key)*right_count);
+            std::memcpy(right->values(), leaf->values() + left_count, sizeof(Value)*right_count);
+            leaf->count = static_cast<std::uint16_t>(left_count);
+            right->count = static_cast<std::uint16_t>(right_count);
+
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next) leaf->next->prev = right;
+            leaf->next = right;
+
+            insertIntoParent(path, right->keys()[0], right);
+            if (index > left_count) {
+                leaf = right;
+                index -= left_count;
+            }
+        }
+
+        insertAt(leaf->keys(), leaf->count, index, key);
+        insertAt(leaf->values(), leaf->count, index, value);
+        leaf->count += 1;
+        m_size += 1;
+        return {iterator(leaf, index), true};
+    }
+
+    // Link the node which was split off the right of path's last child, going up while the parents are full.
+    void insertIntoParent(Path& path, Key separator, Node* right) {
+        while (path.depth) {
+            path.depth -= 1;
+            Inner* inner = path.nodes[path.depth];
+            const std::uint32_t slot = path.slots[path.depth];
+            if (inner->count < INNER_CAPACITY) {
+                insertAt(inner->keys(), inner->count, slot, separator);
+                insertAt(inner->children, inner->count + 1, slot + 1, right);
+                inner->count += 1;
+                return;
+            }
+
+            // Insert into temporary arrays one element larger, and split those,
+            // the middle key moves up to the parent.
+            alignas(Key) std::byte key_bytes[sizeof(Key)*(INNER_CAPACITY + 1)];
+            Node* children[INNER_CAPACITY + 2];
+            Key* keys = std::launder(reinterpret_cast<Key*>(key_bytes));
+            std::memcpy(keys, inner->keys(), sizeof(Key)*INNER_CAPACITY);
+            std::memcpy(children, inner->children, sizeof(Node*)*(INNER_CAPACITY + 1));
+            insertAt(keys, INNER_CAPACITY, slot, separator);
+            insertAt(children, INNER_CAPACITY + 1, slot + 1, right);
+
+            const std::uint32_t left_count = static_cast<std::uint32_t>((INNER_CAPACITY + 1) / 2);
+            const std::uint32_t right_count = static_cast<std::uint32_t>(INNER_CAPACITY) - left_count;
+            Inner* sibling = newInner();
+            std::memcpy(inner->keys(), keys, sizeof(Key)*left_count);
+            std::memcpy(inner->children, children, sizeof(Node*)*(left_count + 1));
+            std::memcpy(sibling->keys(), keys + left_count + 1, sizeof(Key)*right_count);
+            std::memcpy(sibling->children, children + left_count + 1, sizeof(Node*)*(right_count + 1));
+            inner->count = static_cast<std::uint16_t>(left_count);
+            sibling->count = static_cast<std::uint16_t>(right_count);
+
+            std::memcpy(&separator, keys + left_count, sizeof(Key));
+            right = sibling;
+        }
+
+        // The root was split, grow the tree by a level.
+        Inner* root = newInner();
+        new (root->keys()) Key(separator);
+        root->children[0] = m_root;
+        root->children[1] = right;
+        root->count = 1;
+        m_root = root;
+    }
+
+    // Unlink an empty leaf, and remove the parents which are left without children.
+    void removeLeaf(Leaf* leaf, Path& path) noexcept {
+        if (leaf->prev) leaf->prev->next = leaf->next;
+        else m_first = leaf->next;
+        if (leaf->next) leaf->next->prev = leaf->prev;
+        freeNode(leaf);
+
+        while (path.depth) {
+            path.depth -= 1;
+            Inner* inner = path.nodes[path.depth];
+            const std::uint32_t slot = path.slots[path.depth];
+            if (inner->count) {
+                // The key on the left of the removed child goes with it, the first child loses the key on its right.
+                removeAt(inner->keys(), inner->count, slot ? slot - 1 : 0);
+                removeAt(inner->children, inner->count + 1, slot);
+                inner->count -= 1;
+                break;
+            }
+            freeNode(inner);
+            if (!path.depth) {
+                // The last leaf under the root was removed, the map is empty.
+                m_root = nullptr;
+                return;
+            }
+        }
+
+        // Collapse the root while it's left with a single child.
+        while (!m_root->leaf && !static_cast<Inner*>(m_root)->count) {
+            Node* child = static_cast<Inner*>(m_root)->children[0];
+            freeNode(m_root);
+            m_root = child;
+        }
+    }
+
+    template<class T>
+    static void insertAt(T* items, std::uint32_t count, std::uint32_t index, const T& item) noexcept {
+        std::memmove(items + index + 1, items + index, sizeof(T)*(count - index));
+        std::memcpy(items + index, &item, sizeof(T));
+    }
+
+    template<class T>
+    static void removeAt(T* items, std::uint32_t count, std::uint32_t index) noexcept {
+        std::memmove(items + index, items + index + 1, sizeof(T)*(count - index - 1));
+    }
+
+    Leaf* newLeaf() {
+        auto* leaf = new (allocateNode()) Leaf;
+        leaf->count = 0;
+        leaf->leaf = true;
+        leaf->prev = leaf->next = nullptr;
+        return leaf;
+    }
+
+    Inner* newInner() {
+        auto* inner = new (allocateNode()) Inner;
+        inner->count = 0;
+        inner->leaf = false;
+        return inner;
+    }
+
+    void* allocateNode() {
+        if (m_free_nodes) {
+            FreeNode* node = m_free_nodes;
+            m_free_nodes = node->next;
+            return node;
+        }
+        if (m_carve_pos + NODE_SLOT_SIZE > m_carve_end) {
+            // NOTE: Slabs are linked into a list through their first bytes, nodes start at the next cache line.
+            Chunk* slab = m_arena->getChunk(SLAB_CHUNK_SIZE);
+            *reinterpret_cast<Chunk**>(slab->begin()) = m_slabs;
+            m_slabs = slab;
+            auto start = reinterpret_cast<std::uintptr_t>(slab->begin() + sizeof(Chunk*));
+            start = (start + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+            m_carve_pos = reinterpret_cast<std::byte*>(start);
+            m_carve_end = slab->begin() + slab->size();
+        }
+        void* node = m_carve_pos;
+        m_carve_pos += NODE_SLOT_SIZE;
+        return node;
+    }
+
+    void freeNode(Node* node) noexcept {
+        auto* free_node = reinterpret_cast<FreeNode*>(node);
+        free_node->next = m_free_nodes;
+        m_free_nodes = free_node;
+    }
+
+    void releaseSlabs() noexcept {
+        while (m_slabs) {
+            Chunk* prev = *reinterpret_cast<Chunk**>(m_slabs->begin());
+            m_arena->releaseChunk(m_slabs);
+            m_slabs = prev;
+        }
+    }
+
+    void take(BTreeMap& rhs) noexcept {
+        m_root = rhs.m_root; m_first = rhs.m_first; m_size = rhs.m_size;
+        m_slabs = rhs.m_slabs; m_free_nodes = rhs.m_free_nodes;
+        m_carve_pos = rhs.m_carve_pos; m_carve_end = rhs.m_carve_end;
+        rhs.m_root = nullptr; rhs.m_first = nullptr; rhs.m_size = 0;
+        rhs.m_slabs = nullptr; rhs.m_free_nodes = nullptr;
+        rhs.m_carve_pos = rhs.m_carve_end = nullptr;
+    }
+
+    Arena*                     m_arena;
+    [[no_unique_address]] Compare m_compare;
+    Node*                      m_root = nullptr;
+    Leaf*                      m_first = nullptr;
+    std::size_t                m_size = 0;
+    Chunk*                     m_slabs = nullptr;
+    FreeNode*                  m_free_nodes = nullptr;
+    std::byte*                 m_carve_pos = nullptr;
+    std::byte*                 m_carve_end = nullptr;
+};
+
+} // namespace mylib
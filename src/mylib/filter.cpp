@@ -0,0 +1,411 @@
+#include "filter.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <xmmintrin.h>
+#endif
+#if defined(__AVX2__)
+# include <immintrin.h>
+#endif
+
+namespace
+{
+constexpr std::uint64_t BLOOM_MAGIC{0x314d4f4f4c424c4dull};  // "MLBLOOM1"
+constexpr std::uint64_t CUCKOO_MAGIC{0x314f4b4355434c4dull}; // "MLCUCKO1"
+
+// Batch operations hash a group of keys and prefetch all their buckets before touching any of them.
+constexpr std::size_t BATCH_GROUP_SIZE{16u};
+
+// Odd constants spreading 32 bits of the hash over the eight words of a block.
+alignas(32) constexpr std::uint32_t BLOOM_SALTS[mylib::BloomFilter::HASHES_COUNT]{
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du, 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+// Fingerprints are packed into four 16-bit lanes of a bucket.
+constexpr std::uint64_t LANES_LOW{0x0001000100010001ull};
+constexpr std::uint64_t LANES_HIGH{0x8000800080008000ull};
+constexpr std::uint64_t LANE_BITS{16u};
+constexpr std::uint64_t LANE_MASK{0xffffu};
+
+// The finalizer of MurmurHash3, so that keys which differ in a few bits land in unrelated buckets.
+std::uint64_t mix(std::uint64_t key) noexcept {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+void prefetch(const void* address) noexcept {
+#if defined(__SSE2__) || defined(_M_X64)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+// Sets the high bit of every lane which is zero. Lanes above a zero lane may be reported as well,
+// because of the borrow, but the lowest reported lane is always exact.
+std::uint64_t zeroLanes(std::uint64_t bucket) noexcept {
+    return (bucket - LANES_LOW) & ~bucket & LANES_HIGH;
+}
+
+std::uint64_t lowestLane(std::uint64_t lanes) noexcept {
+    return static_cast<std::uint64_t>(std::countr_zero(lanes)) / LANE_BITS;
+}
+
+std::uint64_t withLane(std::uint64_t bucket, std::uint64_t lane, std::uint64_t fingerprint) noexcept {
+    const std::uint64_t shift = lane*LANE_BITS;
+    return (bucket & ~(LANE_MASK << shift)) | (fingerprint << shift);
+}
+
+std::uint64_t fingerprintOf(std::uint64_t hash) noexcept {
+    const std::uint64_t fingerprint = (hash >> 32) & LANE_MASK;
+    return fingerprint ? fingerprint : 1; // Zero marks an empty slot.
+}
+}
+
+namespace mylib
+{
+namespace detail
+{
+FilterStorage::FilterStorage(Arena* arena, std::uint64_t magic, std::uint64_t buckets_count, std::uint64_t bucket_size)
+: m_arena(arena) {
+    allocate(buckets_count*bucket_size);
+    m_header->magic = magic;
+    m_header->buckets_count = buckets_count;
+}
+
+FilterStorage::FilterStorage(Arena* arena, std::uint64_t magic, std::uint64_t bucket_size, std::span<const std::byte> bytes)
+: m_arena(arena) {
+    FilterHeader header;
+    if (bytes.size() < sizeof(header))
+        throw std::invalid_argument(fmt::format("{} bytes are too few for a filter", bytes.size()));
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != magic)
+        throw std::invalid_argument("the bytes don't hold a filter of this kind");
+    // NOTE: Divided rather than multiplied, a corrupted count would overflow.
+    const std::uint64_t buckets_size = bytes.size() - sizeof(header);
+    if ((header.buckets_count == 0) || (header.buckets_count > buckets_size / bucket_size) ||
+        (header.buckets_count*bucket_size != buckets_size))
+        throw std::invalid_argument(fmt::format("{} buckets don't match {} bytes", header.buckets_count, bytes.size()));
+    allocate(bytes.size() - sizeof(header));
+    std::memcpy(m_header, bytes.data(), bytes.size());
+}
+
+FilterStorage::~FilterStorage() {
+    release();
+}
+
+FilterStorage::FilterStorage(FilterStorage&& rhs) noexcept
+: m_arena(rhs.m_arena), m_chunk(std::exchange(rhs.m_chunk, nullptr)), m_header(std::exchange(rhs.m_header, nullptr)),
+  m_buckets_size(std::exchange(rhs.m_buckets_size, 0)) {}
+
+FilterStorage& FilterStorage::operator=(FilterStorage&& rhs) noexcept {
+    if (this == &rhs) return *this;
+    release();
+    m_arena = rhs.m_arena;
+    m_chunk = std::exchange(rhs.m_chunk, nullptr);
+    m_header = std::exchange(rhs.m_header, nullptr);
+    m_buckets_size = std::exchange(rhs.m_buckets_size, 0);
+    return *this;
+}
+
+std::span<const std::byte> FilterStorage::bytes() const noexcept {
+    return std::span<const std::byte>(reinterpret_cast<const std::byte*>(m_header), sizeof(FilterHeader) + m_buckets_size);
+}
+
+void FilterStorage::allocate(std::uint64_t buckets_size) {
+    // NOTE: Chunk memory is only aligned to the chunk header, the slack lets the header start at a cache line.
+    m_chunk = m_arena->getChunk(FILTER_ALIGNMENT + sizeof(FilterHeader) + buckets_size);
+    const auto begin = reinterpret_cast<std::uintptr_t>(m_chunk->begin());
+    const auto aligned = (begin + FILTER_ALIGNMENT - 1) & ~static_cast<std::uintptr_t>(FILTER_ALIGNMENT - 1);
+    m_chunk->advance((aligned - begin) + sizeof(FilterHeader) + buckets_size);
+    m_header = reinterpret_cast<FilterHeader*>(aligned);
+    m_buckets_size = buckets_size;
+    // Chunks acquired with ClearPolicy::NO_CLEAR may hold stale bytes.
+    std::memset(static_cast<void*>(m_header), 0, sizeof(FilterHeader) + buckets_size);
+}
+
+void FilterStorage::release() noexcept {
+    if (m_chunk) m_arena->releaseChunk(m_chunk);
+    m_chunk = nullptr;
+    m_header = nullptr;
+}
+} // namespace detail
+
+namespace
+{
+// The block is picked with a 32x32 bit multiplication.
+constexpr std::uint64_t MAX_BLOOM_BLOCKS_COUNT{1ull << 32};
+
+std::uint64_t bloomBlocksCount(std::uint64_t expected_items, double false_positive_rate) {
+    if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0))
+        throw std::invalid_argument(fmt::format("false positive rate {} is out of (0, 1)", false_positive_rate));
+    // The optimal number of bits per key of a classic Bloom filter, plus a margin for the uneven load of the blocks.
+    const double ln2 = std::log(2.0);
+    const double bits_per_key = 1.1 * -std::log(false_positive_rate) / (ln2*ln2);
+    const auto bits = static_cast<std::uint64_t>(std::ceil(static_cast<double>(std::max<std::uint64_t>(expected_items, 1u)) * bits_per_key));
+    const std::uint64_t blocks_count = std::max<std::uint64_t>(1u, (bits + BloomFilter::BLOCK_SIZE*8 - 1) / (BloomFilter::BLOCK_SIZE*8));
+    if (blocks_count > MAX_BLOOM_BLOCKS_COUNT)
+        throw std::length_error(fmt::format("{} blocks are too many for a Bloom filter", blocks_count));
+    return blocks_count;
+}
+}
+
+BloomFilter::BloomFilter(Arena* arena, std::uint64_t expected_items, double false_positive_rate)
+: m_storage(arena, BLOOM_MAGIC, bloomBlocksCount(expected_items, false_positive_rate), BLOCK_SIZE) {}
+
+BloomFilter::BloomFilter(Arena* arena, std::span<const std::byte> bytes)
+: m_storage(arena, BLOOM_MAGIC, BLOCK_SIZE, bytes) {
+    if (m_storage.header()->buckets_count > MAX_BLOOM_BLOCKS_COUNT)
+        throw std::invalid_argument(fmt::format("{} blocks are too many for a Bloom filter", m_storage.header()->buckets_count));
+}
+
+BloomFilter BloomFilter::read(BinaryReader& reader, Arena* arena) {
+    GrowingArray<std::byte> bytes = reader.readArray<std::byte>(arena);
+    return BloomFilter(arena, std::span<const std::byte>(bytes.data(), bytes.size()));
+}
+
+std::uint64_t* BloomFilter::blockOf(std::uint64_t hash) const noexcept {
+    const std::uint64_t index = ((hash >> 32) * m_storage.header()->buckets_count) >> 32;
+    return reinterpret_cast<std::uint64_t*>(m_storage.buckets() + index*BLOCK_SIZE);
+}
+
+void BloomFilter::insert(std::uint64_t key) noexcept {
+    insertHash(mix(key));
+}
+
+bool BloomFilter::contains(std::uint64_t key) const noexcept {
+    return containsHash(mix(key));
+}
+
+void BloomFilter::insertHash(std::uint64_t hash) noexcept {
+    std::uint64_t* block = blockOf(hash);
+    const auto low = static_cast<std::uint32_t>(hash);
+#if defined(__AVX2__)
+    const __m256i positions = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(low)),
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(BLOOM_SALTS))), 26);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i low_bits = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(positions)));
+    const __m256i high_bits = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(positions, 1)));
+    auto* words = reinterpret_cast<__m256i*>(block);
+    _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), low_bits));
+    _mm256_store_si256(words + 1, _mm256_or_si256(_mm256_load_si256(words + 1), high_bits));
+#else
+    for (std::uint64_t i = 0; i < HASHES_COUNT; i++) {
+        block[i] |= 1ull << ((low * BLOOM_SALTS[i]) >> 26);
+    }
+#endif
+    m_storage.header()->items_count += 1;
+}
+
+bool BloomFilter::containsHash(std::uint64_t hash) const noexcept {
+    const std::uint64_t* block = blockOf(hash);
+    const auto low = static_cast<std::uint32_t>(hash);
+#if defined(__AVX2__)
+    const __m256i positions = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(low)),
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(BLOOM_SALTS))), 26);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i low_bits = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(positions)));
+    const __m256i high_bits = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(positions, 1)));
+    const auto* words = reinterpret_cast<const __m256i*>(block);
+    return _mm256_testc_si256(_mm256_load_si256(words), low_bits) && _mm256_testc_si256(_mm256_load_si256(words + 1), high_bits);
+#else
+    bool found = true;
+    for (std::uint64_t i = 0; i < HASHES_COUNT; i++) {
+        found &= ((block[i] >> ((low * BLOOM_SALTS[i]) >> 26)) & 1) != 0;
+    }
+    return found;
+#endif
+}
+
+void BloomFilter::insert(std::span<const std::uint64_t> keys) noexcept {
+    std::uint64_t hashes[BATCH_GROUP_SIZE];
+    for (std::size_t begin = 0; begin < keys.size(); begin += BATCH_GROUP_SIZE) {
+        const std::size_t count = std::min(BATCH_GROUP_SIZE, keys.size() - begin);
+        for (std::size_t i = 0; i < count; i++) {
+            hashes[i] = mix(keys[begin + i]);
+            prefetch(blockOf(hashes[i]));
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            insertHash(hashes[i]);
+        }
+    }
+}
+
+std::uint64_t BloomFilter::contains(std::span<const std::uint64_t> keys, std::span<bool> results) const noexcept {
+    std::uint64_t hashes[BATCH_GROUP_SIZE];
+    std::uint64_t found = 0;
+    for (std::size_t begin = 0; begin < keys.size(); begin += BATCH_GROUP_SIZE) {
+        const std::size_t count = std::min(BATCH_GROUP_SIZE, keys.size() - begin);
+        for (std::size_t i = 0; i < count; i++) {
+            hashes[i] = mix(keys[begin + i]);
+            prefetch(blockOf(hashes[i]));
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            results[begin + i] = containsHash(hashes[i]);
+            found += results[begin + i];
+        }
+    }
+    return found;
+}
+
+void BloomFilter::clear() noexcept {
+    std::memset(m_storage.buckets(), 0, m_storage.bucketsSize());
+    m_storage.header()->items_count = 0;
+}
+
+namespace
+{
+std::uint64_t cuckooBucketsCount(std::uint64_t capacity) {
+    const double buckets = std::ceil(static_cast<double>(std::max<std::uint64_t>(capacity, 1u)) / (CuckooFilter::SLOTS_PER_BUCKET * 0.95));
+    return std::bit_ceil(static_cast<std::uint64_t>(buckets));
+}
+}
+
+CuckooFilter::CuckooFilter(Arena* arena, std::uint64_t capacity)
+: m_storage(arena, CUCKOO_MAGIC, cuckooBucketsCount(capacity), sizeof(std::uint64_t)) {}
+
+CuckooFilter::CuckooFilter(Arena* arena, std::span<const std::byte> bytes)
+: m_storage(arena, CUCKOO_MAGIC, sizeof(std::uint64_t), bytes) {
+    if (!std::has_single_bit(bucketsCount()))
+        throw std::invalid_argument(fmt::format("{} buckets is not a power of two", bucketsCount()));
+}
+
+CuckooFilter CuckooFilter::read(BinaryReader& reader, Arena* arena) {
+    GrowingArray<std::byte> bytes = reader.readArray<std::byte>(arena);
+    return CuckooFilter(arena, std::span<const std::byte>(bytes.data(), bytes.size()));
+}
+
+std::uint64_t CuckooFilter::alternateIndex(std::uint64_t index, std::uint64_t fingerprint) const noexcept {
+    // XOR keeps it symmetric, the alternate of the alternate bucket is the original one.
+    return (index ^ (fingerprint * 0x5bd1e995u)) & (bucketsCount() - 1);
+}
+
+bool CuckooFilter::insert(std::uint64_t key) noexcept {
+    // NOTE: A fingerprint which couldn't be placed is kept aside, the filter is full until something is erased.
+    detail::FilterHeader* header = m_storage.header();
+    if (header->victim_fingerprint) return false;
+    const std::uint64_t hash = mix(key);
+    insertFingerprint(hash & (bucketsCount() - 1), fingerprintOf(hash));
+    header->items_count += 1;
+    return true;
+}
+
+bool CuckooFilter::insertFingerprint(std::uint64_t index, std::uint64_t fingerprint) noexcept {
+    std::uint64_t* table = buckets();
+    for (std::uint64_t candidate : {index, alternateIndex(index, fingerprint)}) {
+        if (const std::uint64_t empty = zeroLanes(table[candidate])) {
+            table[candidate] = withLane(table[candidate], lowestLane(empty), fingerprint);
+            return true;
+        }
+    }
+
+    // Both buckets are full, kick a random fingerprint out to its alternate bucket.
+    for (std::uint64_t kick = 0; kick < MAX_KICKS; kick++) {
+        m_random ^= m_random << 13; m_random ^= m_random >> 7; m_random ^= m_random << 17;
+        const std::uint64_t lane = m_random % SLOTS_PER_BUCKET;
+        const std::uint64_t victim = (table[index] >> (lane*LANE_BITS)) & LANE_MASK;
+        table[index] = withLane(table[index], lane, fingerprint);
+        fingerprint = victim;
+        index = alternateIndex(index, fingerprint);
+        if (const std::uint64_t empty = zeroLanes(table[index])) {
+            table[index] = withLane(table[index], lowestLane(empty), fingerprint);
+            return true;
+        }
+    }
+    m_storage.header()->victim_index = index;
+    m_storage.header()->victim_fingerprint = fingerprint;
+    return false;
+}
+
+bool CuckooFilter::containsFingerprint(std::uint64_t index, std::uint64_t fingerprint) const noexcept {
+    const std::uint64_t* table = buckets();
+    const std::uint64_t pattern = fingerprint * LANES_LOW;
+    const std::uint64_t alternate = alternateIndex(index, fingerprint);
+    const detail::FilterHeader* header = m_storage.header();
+    return zeroLanes(table[index] ^ pattern) || zeroLanes(table[alternate] ^ pattern) ||
+           ((header->victim_fingerprint == fingerprint) && ((header->victim_index == index) || (header->victim_index == alternate)));
+}
+
+bool CuckooFilter::contains(std::uint64_t key) const noexcept {
+    return containsHash(mix(key));
+}
+
+bool CuckooFilter::containsHash(std::uint64_t hash) const noexcept {
+    return containsFingerprint(hash & (bucketsCount() - 1), fingerprintOf(hash));
+}
+
+bool CuckooFilter::erase(std::uint64_t key) noexcept {
+    const std::uint64_t hash = mix(key);
+    const std::uint64_t index = hash & (bucketsCount() - 1);
+    const std::uint64_t fingerprint = fingerprintOf(hash);
+    const std::uint64_t alternate = alternateIndex(index, fingerprint);
+    detail::FilterHeader* header = m_storage.header();
+    std::uint64_t* table = buckets();
+
+    bool erased = false;
+    for (std::uint64_t candidate : {index, alternate}) {
+        if (const std::uint64_t found = zeroLanes(table[candidate] ^ (fingerprint * LANES_LOW))) {
+            table[candidate] = withLane(table[candidate], lowestLane(found), 0);
+            erased = true;
+            break;
+        }
+    }
+    if (!erased && (header->victim_fingerprint == fingerprint) && ((header->victim_index == index) || (header->victim_index == alternate))) {
+        header->victim_fingerprint = 0;
+        erased = true;
+    }
+    if (!erased) return false;
+
+    header->items_count -= 1;
+    // There is room now, give the victim another chance.
+    if (const std::uint64_t victim = std::exchange(header->victim_fingerprint, 0)) {
+        insertFingerprint(header->victim_index, victim);
+    }
+    return true;
+}
+
+std::uint64_t CuckooFilter::insert(std::span<const std::uint64_t> keys) noexcept {
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (!insert(keys[i])) return i;
+    }
+    return keys.size();
+}
+
+std::uint64_t CuckooFilter::contains(std::span<const std::uint64_t> keys, std::span<bool> results) const noexcept {
+    const std::uint64_t mask = bucketsCount() - 1;
+    std::uint64_t hashes[BATCH_GROUP_SIZE];
+    std::uint64_t found = 0;
+    for (std::size_t begin = 0; begin < keys.size(); begin += BATCH_GROUP_SIZE) {
+        const std::size_t count = std::min(BATCH_GROUP_SIZE, keys.size() - begin);
+        for (std::size_t i = 0; i < count; i++) {
+            hashes[i] = mix(keys[begin + i]);
+            const std::uint64_t index = hashes[i] & mask;
+            prefetch(buckets() + index);
+            prefetch(buckets() + alternateIndex(index, fingerprintOf(hashes[i])));
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            results[begin + i] = containsHash(hashes[i]);
+            found += results[begin + i];
+        }
+    }
+    return found;
+}
+
+void CuckooFilter::clear() noexcept {
+    std::memset(m_storage.buckets(), 0, m_storage.bucketsSize());
+    m_storage.header()->items_count = 0;
+    m_storage.header()->victim_fingerprint = 0;
+}
+
+} // namespace mylib
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "arena.h"
+#include "serialization.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace mylib
+{
+namespace detail
+{
+/**
+ * Filters live in a single chunk. The header is placed at a cache line boundary,
+ * and the buckets follow it, so a bucket never straddles two cache lines.
+ * Serialization writes the header and the buckets as they are.
+*/
+struct FilterHeader {
+    std::uint64_t magic;
+    std::uint64_t buckets_count;
+    std::uint64_t items_count;
+    std::uint64_t victim_index;       // CuckooFilter only.
+    std::uint64_t victim_fingerprint; // CuckooFilter only, 0 if there is no victim.
+    std::uint64_t reserved[3];
+};
+
+constexpr std::uint64_t FILTER_ALIGNMENT{64u};
+static_assert(sizeof(FilterHeader) == FILTER_ALIGNMENT);
+
+/**
+ * Owns the chunk holding a filter header and its buckets.
+*/
+class FilterStorage {
+public:
+    FilterStorage(Arena* arena, std::uint64_t magic, std::uint64_t buckets_count, std::uint64_t bucket_size);
+
+    /**
+     * Copy a filter exported with bytes().
+     * @throw std::invalid_argument If the bytes don't hold a filter with the given magic,
+     * or its buckets count doesn't match the size of the bytes.
+    */
+    FilterStorage(Arena* arena, std::uint64_t magic, std::uint64_t bucket_size, std::span<const std::byte> bytes);
+    ~FilterStorage();
+
+    FilterStorage(FilterStorage&& rhs) noexcept;
+    FilterStorage& operator=(FilterStorage&& rhs) noexcept;
+
+    FilterHeader*       header() const noexcept { return m_header; }
+    std::byte*          buckets() const noexcept { return reinterpret_cast<std::byte*>(m_header + 1); }
+    std::uint64_t       bucketsSize() const noexcept { return m_buckets_size; }
+    std::span<const std::byte> bytes() const noexcept;
+
+private:
+    void allocate(std::uint64_t buckets_size);
+    void release() noexcept;
+
+    Arena*        m_arena;
+    Chunk*        m_chunk = nullptr;
+    FilterHeader* m_header = nullptr;
+    std::uint64_t m_buckets_size = 0;
+};
+} // namespace detail
+
+/**
+ * Blocked Bloom filter. Every key maps to a single 64-byte block, one cache line, and sets one bit
+ * in each of its eight 64-bit words. The bit positions come from multiplying 32 bits of the hash by eight
+ * odd constants, which is a single AVX2 multiplication, so both insert and lookup touch exactly one cache line.
+ * Keys are 64-bit values, usually hashes, they are mixed again so that sequential integers work as well.
+ * No false negatives; not thread-safe for concurrent inserts.
+*/
+class BloomFilter {
+public:
+    constexpr static std::uint64_t BLOCK_SIZE{64u};
+    constexpr static std::uint64_t HASHES_COUNT{8u};
+
+    /**
+     * @param expected_items Number of keys the filter is sized for.
+     * @param false_positive_rate Desired probability of a false positive once expected_items keys are inserted.
+    */
+    BloomFilter(Arena* arena, std::uint64_t expected_items, double false_positive_rate=0.01);
+
+    /**
+     * Restore a filter from its raw bytes, see bytes().
+     * @throw std::invalid_argument If the bytes don't hold a Bloom filter.
+    */
+    BloomFilter(Arena* arena, std::span<const std::byte> bytes);
+
+    void insert(std::uint64_t key) noexcept;
+    bool contains(std::uint64_t key) const noexcept;
+
+    /**
+     * Batch versions, the keys are processed in small groups, and the blocks of a whole group are prefetched up front.
+    */
+    void insert(std::span<const std::uint64_t> keys) noexcept;
+
+    /**
+     * @param results Receives the result for every key, has to be at least as long as keys.
+     * @return Number of keys which may be present.
+    */
+    std::uint64_t contains(std::span<const std::uint64_t> keys, std::span<bool> results) const noexcept;
+
+    void clear() noexcept;
+
+    /**
+     * @return Number of keys inserted, including duplicates.
+    */
+    std::uint64_t size() const noexcept { return m_storage.header()->items_count; }
+    std::uint64_t blocksCount() const noexcept { return m_storage.header()->buckets_count; }
+    std::uint64_t memoryUsage() const noexcept { return m_storage.bucketsSize(); }
+
+    /**
+     * @return The header and the bit array, valid until the filter is modified.
+    */
+    std::span<const std::byte> bytes() const noexcept { return m_storage.bytes(); }
+
+    /**
+     * Queue the filter into a binary stream, it has to stay unmodified until the writer flushes.
+    */
+    void write(BinaryWriter& writer) const { writer.write(bytes()); }
+
+    /**
+     * @throw serialization_error If the next record is not an array of bytes.
+     * @throw std::invalid_argument If the record doesn't hold a Bloom filter.
+    */
+    static BloomFilter read(BinaryReader& reader, Arena* arena);
+
+private:
+    std::uint64_t* blockOf(std::uint64_t hash) const noexcept;
+    void           insertHash(std::uint64_t hash) noexcept;
+    bool           containsHash(std::uint64_t hash) const noexcept;
+
+    detail::FilterStorage m_storage;
+};
+
+/**
+ * Cuckoo filter with 16-bit fingerprints and buckets of four slots, each bucket is a single 64-bit word.
+ * A key can be stored in one of two buckets, the second one is derived from the first one and the fingerprint,
+ * so fingerprints can be moved between buckets without the original key. Unlike a Bloom filter, keys can be erased.
+ * Slots are matched with SWAR arithmetic on the whole bucket at once.
+ * The false positive rate is about 8/65536 while the filter is close to full.
+ * NOTE: Only keys which were inserted may be erased, erasing any other key may remove a colliding fingerprint.
+*/
+class CuckooFilter {
+public:
+    constexpr static std::uint64_t SLOTS_PER_BUCKET{4u};
+    constexpr static std::uint64_t MAX_KICKS{500u};
+
+    /**
+     * @param capacity Number of keys the filter has to hold, the buckets are sized for a 95% load.
+    */
+    CuckooFilter(Arena* arena, std::uint64_t capacity);
+
+    /**
+     * Restore a filter from its raw bytes, see bytes().
+     * @throw std::invalid_argument If the bytes don't hold a cuckoo filter.
+    */
+    CuckooFilter(Arena* arena, std::span<const std::byte> bytes);
+
+    /**
+     * @return false if the filter is full, the key is not inserted in that case.
+    */
+    bool insert(std::uint64_t key) noexcept;
+    bool contains(std::uint64_t key) const noexcept;
+
+    /**
+     * @return true if a fingerprint of the key was found and removed.
+    */
+    bool erase(std::uint64_t key) noexcept;
+
+    /**
+     * @return Number of keys inserted before the filter became full.
+    */
+    std::uint64_t insert(std::span<const std::uint64_t> keys) noexcept;
+
+    /**
+     * @param results Receives the result for every key, has to be at least as long as keys.
+     * @return Number of keys which may be present.
+    */
+    std::uint64_t contains(std::span<const std::uint64_t> keys, std::span<bool> results) const noexcept;
+
+    void clear() noexcept;
+
+    std::uint64_t size() const noexcept { return m_storage.header()->items_count; }
+    std::uint64_t bucketsCount() const noexcept { return m_storage.header()->buckets_count; }
+    std::uint64_t capacity() const noexcept { return bucketsCount()*SLOTS_PER_BUCKET; }
+    double        loadFactor() const noexcept { return static_cast<double>(size()) / static_cast<double>(capacity()); }
+    std::uint64_t memoryUsage() const noexcept { return m_storage.bucketsSize(); }
+
+    /**
+     * @return The header and the buckets, valid until the filter is modified.
+    */
+    std::span<const std::byte> bytes() const noexcept { return m_storage.bytes(); }
+
+    /**
+     * Queue the filter into a binary stream, it has to stay unmodified until the writer flushes.
+    */
+    void write(BinaryWriter& writer) const { writer.write(bytes()); }
+
+    /**
+     * @throw serialization_error If the next record is not an array of bytes.
+     * @throw std::invalid_argument If the record doesn't hold a cuckoo filter.
+    */
+    static CuckooFilter read(BinaryReader& reader, Arena* arena);
+
+private:
+    std::uint64_t* buckets() const noexcept { return reinterpret_cast<std::uint64_t*>(m_storage.buckets()); }
+    std::uint64_t  alternateIndex(std::uint64_t index, std::uint64_t fingerprint) const noexcept;
+    bool           insertFingerprint(std::uint64_t index, std::uint64_t fingerprint) noexcept;
+    bool           containsFingerprint(std::uint64_t index, std::uint64_t fingerprint) const noexcept;
+    bool           containsHash(std::uint64_t hash) const noexcept;
+
+    detail::FilterStorage m_storage;
+    std::uint64_t         m_random = 0x9e3779b97f4a7c15ull; // Picks the slots to kick out.
+};
+
+} // namespace mylib
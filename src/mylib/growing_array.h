@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cassert>
 #include <stdexcept>
+#include <type_traits>
 
 namespace mylib
 {
@@ -38,6 +39,19 @@ public:
     explicit GrowingArray(Arena* arena) noexcept
      : m_arena(arena), m_chunk(nullptr), m_size(0), m_cap(0) {}
 
+    /**
+     * Adopt a chunk which already holds the elements, e.g. a root of a persistent arena.
+     * Only trivially copyable objects can be adopted, since their bytes are used as is.
+    */
+    GrowingArray(Arena* arena, Chunk* chunk) noexcept
+     : m_arena(arena), m_chunk(chunk), m_size(0), m_cap(0) {
+        static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be adopted");
+        if (m_chunk) {
+            m_size = (m_chunk->end() - m_chunk->begin()) / sizeof(Object);
+            m_cap = m_chunk->size() / sizeof(Object);
+        }
+    }
+
     /**
      * 
     */
@@ -125,6 +139,17 @@ public:
     */
     void pop_back() { validateIndex(m_size - 1); m_chunk->pop(sizeof(Object)); m_size -= 1; }
 
+    /**
+     * @return A pointer to the contiguous storage of the elements, or nullptr if nothing was allocated yet.
+    */
+    const Object* data() const noexcept { return m_chunk ? reinterpret_cast<const Object*>(m_chunk->begin()) : nullptr; }
+    Object*       data() noexcept { return m_chunk ? reinterpret_cast<Object*>(m_chunk->begin()) : nullptr; }
+
+    /**
+     * @return The arena the elements are allocated from, e.g. for scratch space of the same lifetime.
+    */
+    Arena* arena() const noexcept { return m_arena; }
+
     /**
      * 
     */
@@ -150,6 +175,13 @@ public:
     */
     void clear() noexcept { if (m_chunk) { m_chunk->reset(); } m_size = 0; }
 
+    /**
+     * Detach the underlying chunk without releasing it, the array becomes empty.
+     * Used to keep the elements in a persistent arena, see Arena::setRoot.
+     * @return The chunk holding the elements, or nullptr if the array has never allocated.
+    */
+    Chunk* release() noexcept { Chunk* chunk = m_chunk; m_chunk = nullptr; m_size = m_cap = 0; return chunk; }
+
     /**
      *
     */
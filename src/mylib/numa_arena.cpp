@@ -0,0 +1,157 @@
+#include "numa_arena.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+# undef max
+# undef min
+#else
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+// Parses the highest node number out of a list like "0-1,3".
+std::uint32_t parseNodesCount(const std::string& list) {
+    std::uint32_t highest = 0;
+    std::uint32_t value = 0;
+    for (char c : list) {
+        if (c >= '0' && c <= '9') {
+            value = value*10 + static_cast<std::uint32_t>(c - '0');
+        }
+        else {
+            highest = std::max(highest, value);
+            value = 0;
+        }
+    }
+    return std::max(highest, value) + 1;
+}
+#endif
+}
+
+namespace mylib
+{
+
+NumaTopology NumaTopology::detect() {
+    NumaTopology topology;
+#ifdef _WIN32
+    ULONG highest_node = 0;
+    if (GetNumaHighestNodeNumber(&highest_node))
+        topology.nodes_count = static_cast<std::uint32_t>(highest_node) + 1;
+#else
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (online && std::getline(online, list) && !list.empty())
+        topology.nodes_count = parseNodesCount(list);
+#endif
+    return topology;
+}
+
+NumaTopology NumaTopology::simulate(std::uint32_t nodes_count, std::function<std::uint32_t()> current_node) {
+    NumaTopology topology;
+    topology.nodes_count = nodes_count ? nodes_count : 1;
+    topology.simulated = true;
+    topology.current_node = std::move(current_node);
+    return topology;
+}
+
+NumaArena::NumaArena(std::uint64_t size, NumaTopology topology)
+: m_topology(std::move(topology)) {
+    // Binding is pointless on a single node, and impossible for simulated nodes.
+    const bool bind = !m_topology.simulated && (m_topology.nodes_count > 1);
+    m_nodes.reserve(m_topology.nodes_count);
+    for (std::uint32_t node = 0; node < m_topology.nodes_count; node++) {
+        m_nodes.push_back(std::make_unique<Node>(size, bind ? static_cast<std::int32_t>(node) : -1));
+    }
+}
+
+Chunk* NumaArena::getChunk(std::uint64_t size, Chunk* old_chunk) {
+    Chunk* chunk = getChunkOnNode(currentNode(), size);
+    if (old_chunk) {
+        chunk->copy(old_chunk);
+        releaseChunk(old_chunk);
+    }
+    return chunk;
+}
+
+Chunk* NumaArena::getChunkOnNode(std::uint32_t node, std::uint64_t size) {
+    Arena* arena = nodeArena(node);
+    m_nodes[node]->chunk_requests.fetch_add(1, std::memory_order_relaxed);
+    return arena->getChunk(size);
+}
+
+void NumaArena::releaseChunk(Chunk* chunk) {
+    if (!chunk) return;
+    // Most of the chunks are released on the node they were acquired on, so check it first.
+    const std::uint32_t current = currentNode();
+    if (m_nodes[current]->arena.contains(chunk)) {
+        m_nodes[current]->arena.releaseChunk(chunk);
+        return;
+    }
+    for (auto& node : m_nodes) {
+        if (node->arena.contains(chunk)) {
+            node->remote_releases.fetch_add(1, std::memory_order_relaxed);
+            node->arena.releaseChunk(chunk);
+            return;
+        }
+    }
+}
+
+Arena* NumaArena::local() {
+    return &m_nodes[currentNode()]->arena;
+}
+
+Arena* NumaArena::nodeArena(std::uint32_t node) {
+    if (node >= m_nodes.size())
+        throw std::out_of_range(fmt::format("node {} is out of range", node));
+    return &m_nodes[node]->arena;
+}
+
+std::uint32_t NumaArena::currentNode() const {
+    std::uint32_t node = 0;
+    if (m_topology.current_node) {
+        node = m_topology.current_node();
+    }
+    else if (m_topology.nodes_count > 1) {
+#ifdef _WIN32
+        PROCESSOR_NUMBER processor{};
+        USHORT node_number = 0;
+        GetCurrentProcessorNumberEx(&processor);
+        if (GetNumaProcessorNodeEx(&processor, &node_number))
+            node = node_number;
+#elif defined(SYS_getcpu)
+        unsigned cpu = 0, cpu_node = 0;
+        if (syscall(SYS_getcpu, &cpu, &cpu_node, nullptr) == 0)
+            node = cpu_node;
+#endif
+    }
+    return node % m_topology.nodes_count;
+}
+
+std::vector<NumaNodeStats> NumaArena::stats() const {
+    std::vector<NumaNodeStats> stats;
+    stats.reserve(m_nodes.size());
+    for (std::uint32_t i = 0; i < m_nodes.size(); i++) {
+        const Node& node = *m_nodes[i];
+        stats.push_back(NumaNodeStats{
+            .node = i,
+            .blocks = node.arena.totalBlocks(),
+            .total_chunks = node.arena.totalChunks(),
+            .empty_chunks = node.arena.emptyChunksCount(),
+            .reserved_bytes = node.arena.reservedSize(),
+            .chunk_requests = node.chunk_requests.load(std::memory_order_relaxed),
+            .remote_releases = node.remote_releases.load(std::memory_order_relaxed),
+        });
+    }
+    return stats;
+}
+
+} // namespace mylib
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "arena.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mylib
+{
+/**
+ * Description of the NUMA nodes the arena distributes memory across.
+ * A simulated topology routes requests with a user-supplied function and doesn't bind memory,
+ * which allows to exercise the multi-node code paths on a single-node machine.
+*/
+struct NumaTopology {
+    std::uint32_t                   nodes_count = 1;
+    bool                            simulated = false;
+    std::function<std::uint32_t()>  current_node;
+
+    /**
+     * Query the nodes of the current machine, falls back to a single node if unavailable.
+    */
+    static NumaTopology detect();
+
+    static NumaTopology simulate(std::uint32_t nodes_count, std::function<std::uint32_t()> current_node);
+};
+
+struct NumaNodeStats {
+    std::uint32_t node;
+    std::uint64_t blocks;
+    std::uint64_t total_chunks;
+    std::uint64_t empty_chunks;
+    std::uint64_t reserved_bytes;
+    std::uint64_t chunk_requests;
+    std::uint64_t remote_releases;
+};
+
+/**
+ * Arena with a separate list of memory blocks per NUMA node. Blocks are bound to their node,
+ * and chunks are served from the node of the calling thread, so threads on different sockets
+ * don't read each other's memory remotely, nor contend for the same mutex.
+ * Chunks can be released from any thread, they are returned to the node they were taken from.
+*/
+class NumaArena {
+public:
+    explicit NumaArena(std::uint64_t size=Arena::DEFAULT_ALLOC_SIZE, NumaTopology topology=NumaTopology::detect());
+
+    NumaArena(const NumaArena&) = delete;
+    NumaArena& operator=(const NumaArena&) = delete;
+
+    /**
+     * Acquire a chunk from the calling thread's node, see Arena::getChunk.
+     * The old chunk is copied and released even if it belongs to another node.
+    */
+    Chunk*        getChunk(std::uint64_t size, Chunk* old_chunk=nullptr);
+
+    /**
+     * Acquire a chunk from the given node.
+     * @throw std::out_of_range If node is greater or equal to nodesCount().
+    */
+    Chunk*        getChunkOnNode(std::uint32_t node, std::uint64_t size);
+
+    void          releaseChunk(Chunk* chunk);
+
+    /**
+     * @return The arena of the calling thread's node, e.g. for containers which are built on a single thread.
+    */
+    Arena*        local();
+    Arena*        nodeArena(std::uint32_t node);
+
+    std::uint32_t nodesCount() const noexcept { return m_topology.nodes_count; }
+    std::uint32_t currentNode() const;
+    bool          isSimulated() const noexcept { return m_topology.simulated; }
+
+    std::vector<NumaNodeStats> stats() const;
+
+private:
+    struct Node {
+        Node(std::uint64_t size, std::int32_t numa_node)
+        : arena(size, numa_node) {}
+
+        Arena                      arena;
+        std::atomic<std::uint64_t> chunk_requests{0};
+        std::atomic<std::uint64_t> remote_releases{0};
+    };
+
+    NumaTopology                       m_topology;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+};
+
+} // namespace mylib
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "arena.h"
+#include "growing_array.h"
+#include <fmt/core.h>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mylib
+{
+namespace detail
+{
+/**
+ * Heap algorithms over an implicit D-ary heap, the children of the element i are D*i + 1 ... D*i + D.
+ * Elements are moved into a hole instead of being swapped, and every element which lands at a new position
+ * is reported to track, so the indexed queue can keep the positions of its elements up to date.
+*/
+struct NoHeapTracking {
+    template<class Object>
+    void operator()(const Object&, std::size_t) const noexcept {}
+};
+
+// Heaps up to this size mostly stay in the cache, larger ones spend most of a sift in cache misses.
+constexpr std::size_t BRANCHLESS_HEAP_SIZE{1024u*1024u};
+
+template<std::size_t D, class Object, class Compare, class Track>
+void siftUp(Object* data, std::size_t index, const Compare& comp, Track&& track) {
+    Object value = std::move(data[index]);
+    while (index > 0) {
+        const std::size_t parent = (index - 1) / D;
+        if (!comp(data[parent], value)) break;
+        data[index] = std::move(data[parent]);
+        track(data[index], index);
+        index = parent;
+    }
+    data[index] = std::move(value);
+    track(data[index], index);
+}
+
+/**
+ * Pick the best of the D children of a full node. Which child wins is random for random keys,
+ * so in a heap which fits into the cache the children are compared pairwise in a tournament of log2(D) rounds,
+ * and the winners are selected arithmetically, a branch would be mispredicted half of the time.
+ * In larger heaps the branches win, the CPU speculates down the predicted child and overlaps its cache misses
+ * with the comparisons, while the selects have to wait for every load.
+*/
+template<std::size_t D, bool BRANCHLESS, class Object, class Compare>
+std::size_t bestChild(const Object* data, std::size_t first, const Compare& comp) {
+    if constexpr (BRANCHLESS && std::has_single_bit(D)) {
+        std::size_t winners[D];
+        for (std::size_t i = 0; i < D; i++) {
+            winners[i] = first + i;
+        }
+        for (std::size_t width = D; width > 1; width /= 2) {
+            for (std::size_t i = 0; i < width / 2; i++) {
+                const std::size_t lhs = winners[2*i];
+                const std::size_t rhs = winners[2*i + 1];
+                winners[i] = lhs + static_cast<std::size_t>(comp(data[lhs], data[rhs]))*(rhs - lhs);
+            }
+        }
+        return winners[0];
+    } else {
+        std::size_t best = first;
+        for (std::size_t child = first + 1; child < first + D; child++) {
+            if (comp(data[best], data[child])) best = child;
+        }
+        return best;
+    }
+}
+
+template<std::size_t D, bool BRANCHLESS, class Object, class Compare, class Track>
+void siftDown(Object* data, std::size_t size, std::size_t index, const Compare& comp, Track&& track) {
+    Object value = std::move(data[index]);
+    for (;;) {
+        const std::size_t first = index*D + 1;
+        if (first >= size) break;
+        std::size_t best = first;
+        // NOTE: Nodes with all D children take the loops with a constant trip count, which the compiler unrolls.
+        if (first + D <= size) {
+            best = bestChild<D, BRANCHLESS>(data, first, comp);
+        } else {
+            for (std::size_t child = first + 1; child < size; child++) {
+                if (comp(data[best], data[child])) best = child;
+            }
+        }
+        if (!comp(value, data[best])) break;
+        data[index] = std::move(data[best]);
+        track(data[index], index);
+        index = best;
+    }
+    data[index] = std::move(value);
+    track(data[index], index);
+}
+
+template<std::size_t D, class Object, class Compare, class Track>
+void siftDown(Object* data, std::size_t size, std::size_t index, const Compare& comp, Track&& track) {
+    if (size*sizeof(Object) <= BRANCHLESS_HEAP_SIZE) {
+        siftDown<D, true>(data, size, index, comp, track);
+    } else {
+        siftDown<D, false>(data, size, index, comp, track);
+    }
+}
+
+/**
+ * Build a heap bottom up, sifting down every node which has children, O(n) comparisons in total.
+*/
+template<std::size_t D, class Object, class Compare, class Track>
+void heapify(Object* data, std::size_t size, const Compare& comp, Track&& track) {
+    if (size < 2) return;
+    for (std::size_t index = (size - 2) / D + 1; index-- > 0;) {
+        siftDown<D>(data, size, index, comp, track);
+    }
+}
+} // namespace detail
+
+/**
+ * Priority queue stored as an implicit D-ary heap in a GrowingArray, so the whole heap is a single arena chunk.
+ * A wider heap is D times shallower than a binary one, thus a pop walks fewer levels, and the D children compared
+ * at every level sit next to each other, usually on the same cache line. Pushes only compare with the parents,
+ * which makes them cheaper with a wider heap too.
+ * The ordering follows std::priority_queue: top() is the largest element with respect to Compare,
+ * use std::greater for a min-heap, e.g. timers ordered by their deadlines.
+ * NOTE: GrowingArray copies the elements bytewise, so only trivially copyable objects can be stored.
+*/
+template<class Object, class Compare=std::less<Object>, std::size_t D=4>
+class PriorityQueue {
+    static_assert(D >= 2, "a heap has to have at least two children per node");
+    static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be stored");
+
+public:
+    using value_type = Object;
+
+    constexpr static std::size_t ARITY{D};
+
+    explicit PriorityQueue(Arena* arena, const Compare& comp=Compare()) noexcept
+    : m_heap(arena), m_comp(comp) {}
+
+    void push(const Object& value) {
+        m_heap.push_back(value);
+        detail::siftUp<D>(m_heap.data(), m_heap.size() - 1, m_comp, detail::NoHeapTracking{});
+    }
+
+    /**
+     * Push a group of values at once. If the group is at least as large as the queue,
+     * the values are appended as they are and the whole heap is rebuilt bottom up in O(n),
+     * smaller groups are sifted up one by one.
+    */
+    void push_bulk(std::span<const Object> values) {
+        const std::size_t old_size = m_heap.size();
+        for (const Object& value : values) {
+            m_heap.push_back(value);
+        }
+        if (values.size() >= old_size) {
+            detail::heapify<D>(m_heap.data(), m_heap.size(), m_comp, detail::NoHeapTracking{});
+            return;
+        }
+        for (std::size_t index = old_size; index < m_heap.size(); index++) {
+            detail::siftUp<D>(m_heap.data(), index, m_comp, detail::NoHeapTracking{});
+        }
+    }
+
+    /**
+     * @throw std::out_of_range If the queue is empty.
+    */
+    const Object& top() const { return m_heap.front(); }
+
+    /**
+     * Remove the top element.
+     * @throw std::out_of_range If the queue is empty.
+    */
+    void pop() {
+        if (m_heap.empty())
+            throw std::out_of_range("pop from an empty priority queue");
+        Object* data = m_heap.data();
+        const std::size_t last = m_heap.size() - 1;
+        data[0] = data[last];
+        m_heap.pop_back();
+        if (last > 1) detail::siftDown<D>(data, last, 0, m_comp, detail::NoHeapTracking{});
+    }
+
+    std::size_t size() const noexcept { return m_heap.size(); }
+    bool        empty() const noexcept { return m_heap.empty(); }
+    void        clear() noexcept { m_heap.clear(); }
+
+private:
+    GrowingArray<Object> m_heap;
+    Compare              m_comp;
+};
+
+/**
+ * PriorityQueue whose elements can be changed or erased after they were pushed, e.g. tasks of a scheduler
+ * which get rescheduled or cancelled. push returns a handle, and a separate array maps every handle
+ * to the element's position in the heap, which is updated whenever the element moves.
+ * update covers decrease-key in both directions: an element moves towards the top if it got a higher priority,
+ * and towards the leaves otherwise.
+ * NOTE: Handles of popped and erased elements are reused by the next pushes, a stale handle refers to another element.
+*/
+template<class Object, class Compare=std::less<Object>, std::size_t D=4>
+class IndexedPriorityQueue {
+    static_assert(D >= 2, "a heap has to have at least two children per node");
+    static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be stored");
+
+public:
+    using value_type = Object;
+    using Handle = std::uint64_t;
+
+    constexpr static std::size_t ARITY{D};
+
+    explicit IndexedPriorityQueue(Arena* arena, const Compare& comp=Compare()) noexcept
+    : m_heap(arena), m_positions(arena), m_free_handles(arena), m_comp(comp) {}
+
+    /**
+     * @return Handle of the element, valid until the element is popped or erased.
+    */
+    Handle push(const Object& value) {
+        Handle handle;
+        if (!m_free_handles.empty()) {
+            handle = m_free_handles.back();
+            m_free_handles.pop_back();
+        } else {
+            handle = m_positions.size();
+            m_positions.push_back(NPOS);
+        }
+        m_heap.push_back(Entry{value, handle});
+        detail::siftUp<D>(m_heap.data(), m_heap.size() - 1, entryCompare(), tracker());
+        return handle;
+    }
+
+    /**
+     * @throw std::out_of_range If the queue is empty.
+    */
+    const Object& top() const { return m_heap.front().value; }
+    Handle        topHandle() const { return m_heap.front().handle; }
+
+    /**
+     * Remove the top element, its handle becomes free.
+     * @throw std::out_of_range If the queue is empty.
+    */
+    void pop() {
+        if (m_heap.empty())
+            throw std::out_of_range("pop from an empty priority queue");
+        eraseAt(0);
+    }
+
+    /**
+     * @return true if the handle refers to an element in the queue.
+    */
+    bool contains(Handle handle) const noexcept {
+        return (handle < m_positions.size()) && (m_positions.data()[handle] != NPOS);
+    }
+
+    /**
+     * @throw std::out_of_range If the handle doesn't refer to an element in the queue.
+    */
+    const Object& value(Handle handle) const { return m_heap.data()[positionOf(handle)].value; }
+
+    /**
+     * Replace the element and restore the heap order, O(log_D n) for a move towards the top,
+     * O(D log_D n) towards the leaves.
+     * @throw std::out_of_range If the handle doesn't refer to an element in the queue.
+    */
+    void update(Handle handle, const Object& value) {
+        const std::size_t index = positionOf(handle);
+        Entry* data = m_heap.data();
+        const bool raised = m_comp(data[index].value, value);
+        data[index].value = value;
+        if (raised) detail::siftUp<D>(data, index, entryCompare(), tracker());
+        else detail::siftDown<D>(data, m_heap.size(), index, entryCompare(), tracker());
+    }
+
+    /**
+     * @throw std::out_of_range If the handle doesn't refer to an element in the queue.
+    */
+    void erase(Handle handle) { eraseAt(positionOf(handle)); }
+
+    std::size_t size() const noexcept { return m_heap.size(); }
+    bool        empty() const noexcept { return m_heap.empty(); }
+
+private:
+    constexpr static std::uint64_t NPOS{std::numeric_limits<std::uint64_t>::max()};
+
+    // The handle travels with the value, so a moved element updates its position without a lookup.
+    struct Entry {
+        Object value;
+        Handle handle;
+    };
+
+    auto entryCompare() const noexcept {
+        return [this](const Entry& lhs, const Entry& rhs) { return m_comp(lhs.value, rhs.value); };
+    }
+
+    auto tracker() noexcept {
+        return [positions = m_positions.data()](const Entry& entry, std::size_t index) { positions[entry.handle] = index; };
+    }
+
+    std::size_t positionOf(Handle handle) const {
+        if (!contains(handle))
+            throw std::out_of_range(fmt::format("handle {} doesn't refer to an element in the queue", handle));
+        return m_positions.data()[handle];
+    }
+
+    void eraseAt(std::size_t index) {
+        Entry* data = m_heap.data();
+        const Handle handle = data[index].handle;
+        const std::size_t last = m_heap.size() - 1;
+        m_free_handles.push_back(handle);
+        m_positions.data()[handle] = NPOS;
+        if (index == last) {
+            m_heap.pop_back();
+            return;
+        }
+        data[index] = data[last];
+        m_heap.pop_back();
+        // The last element may belong above or below the hole, it came from another subtree.
+        if ((index > 0) && m_comp(data[(index - 1) / D].value, data[index].value)) {
+            detail::siftUp<D>(data, index, entryCompare(), tracker());
+        } else {
+            detail::siftDown<D>(data, last, index, entryCompare(), tracker());
+        }
+    }
+
+    GrowingArray<Entry>         m_heap;
+    GrowingArray<std::uint64_t> m_positions; // Position of every handle in the heap, NPOS for free handles.
+    GrowingArray<Handle>        m_free_handles;
+    Compare                     m_comp;
+};
+
+} // namespace mylib
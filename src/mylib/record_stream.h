@@ -0,0 +1,304 @@
+#pragma once
+
+#include "arena.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mylib
+{
+namespace detail
+{
+/**
+ * Precedes every record. The payload starts offset bytes after the header,
+ * the next record starts right after the payload, rounded up to RecordStream::RECORD_ALIGNMENT.
+*/
+struct RecordHeader {
+    std::uint16_t tag;
+    std::uint16_t offset;
+    std::uint32_t size;
+};
+
+template<class T, class ...Types>
+constexpr std::uint16_t recordTag() noexcept {
+    constexpr bool matches[] = {std::is_same_v<T, Types>...};
+    for (std::uint16_t i = 0; i < sizeof...(Types); i++) {
+        if (matches[i]) return i;
+    }
+    return static_cast<std::uint16_t>(sizeof...(Types));
+}
+
+inline std::byte* alignUp(std::byte* ptr, std::uint64_t alignment) noexcept {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    return ptr + ((alignment - address % alignment) % alignment);
+}
+} // namespace detail
+
+/**
+ * Append-only stream of heterogeneous records stored back to back in a chain of arena chunks.
+ * Every record is a compact header with the type tag and the payload size, followed by the object
+ * placed at its natural alignment, so records are read in place without copying.
+ * When the current chunk is full, a new one is acquired and linked through the first bytes of the previous one,
+ * thus appending never moves the records which are already written, and references to them stay valid.
+ * The tag of a type is its index in Types, which have to be trivially copyable.
+*/
+template<class ...Types>
+class RecordStream {
+public:
+    constexpr static std::uint64_t RECORD_ALIGNMENT{alignof(detail::RecordHeader)};
+    constexpr static std::uint64_t MAX_ALIGNMENT{alignof(std::max_align_t)};
+    constexpr static std::uint64_t DEFAULT_CHUNK_SIZE{64u*1024u};
+
+    template<class T>
+    constexpr static std::uint16_t TAG_OF{detail::recordTag<T, Types...>()};
+
+private:
+    static_assert(sizeof...(Types) > 0, "at least one record type is required");
+    static_assert(sizeof...(Types) < std::numeric_limits<std::uint16_t>::max(), "too many record types");
+    static_assert((std::is_trivially_copyable_v<Types> && ...), "record types have to be trivially copyable");
+    static_assert(((alignof(Types) <= MAX_ALIGNMENT) && ...), "over-aligned record types are not supported");
+
+    // Every chunk starts with a pointer to the next chunk in the stream, followed by the records.
+    constexpr static std::uint64_t LINK_SIZE{sizeof(Chunk*)};
+
+public:
+    /**
+     * View of a single record inside the stream.
+    */
+    class Record {
+    public:
+        std::uint16_t    tag() const noexcept { return m_header->tag; }
+        std::uint32_t    size() const noexcept { return m_header->size; }
+        const std::byte* data() const noexcept { return reinterpret_cast<const std::byte*>(m_header) + m_header->offset; }
+
+        template<class T>
+        bool is() const noexcept { return tag() == TAG_OF<T>; }
+
+        /**
+         * @throw std::logic_error If the record holds an object of another type.
+        */
+        template<class T>
+        const T& as() const {
+            static_assert(TAG_OF<T> < sizeof...(Types), "type is not a part of the stream");
+            if (!is<T>())
+                throw std::logic_error(fmt::format("record has tag {}, but {} was requested", tag(), TAG_OF<T>));
+            return *std::launder(reinterpret_cast<const T*>(data()));
+        }
+
+        /**
+         * Invoke f with the object the record holds, cast to its actual type.
+        */
+        template<class F>
+        void visit(F&& f) const {
+            visitImpl(f, std::index_sequence_for<Types...>{});
+        }
+
+    private:
+        friend class RecordStream;
+
+        explicit Record(const detail::RecordHeader* header) noexcept
+        : m_header(header) {}
+
+        template<class F, std::size_t ...I>
+        void visitImpl(F& f, std::index_sequence<I...>) const {
+            // NOTE: Expands into a chain of comparisons which the compiler turns into a jump table.
+            (void)((tag() == I ? (f(*std::launder(reinterpret_cast<const Types*>(data()))), true) : false) || ...);
+        }
+
+        const detail::RecordHeader* m_header;
+    };
+
+    /**
+     * Forward iterator over the records, it follows the links between chunks.
+     * Dereferencing yields a Record by value.
+    */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Record;
+        using difference_type = std::ptrdiff_t;
+        using reference = Record;
+
+        iterator() noexcept = default;
+
+        Record operator*() const noexcept {
+            return Record(reinterpret_cast<const detail::RecordHeader*>(m_pos));
+        }
+
+        iterator& operator++() noexcept {
+            const auto* header = reinterpret_cast<const detail::RecordHeader*>(m_pos);
+            m_pos = detail::alignUp(m_pos + header->offset + header->size, RECORD_ALIGNMENT);
+            skipExhaustedChunks();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept { iterator tmp = *this; ++(*this); return tmp; }
+
+        bool operator==(const iterator& rhs) const noexcept { return m_pos == rhs.m_pos; }
+
+    private:
+        friend class RecordStream;
+
+        iterator(Chunk* chunk, std::byte* pos) noexcept
+        : m_chunk(chunk), m_pos(pos) { skipExhaustedChunks(); }
+
+        void skipExhaustedChunks() noexcept {
+            while (m_chunk && (m_pos >= m_chunk->end())) {
+                m_chunk = RecordStream::next(m_chunk);
+                m_pos = m_chunk ? (m_chunk->begin() + LINK_SIZE) : nullptr;
+            }
+        }
+
+        Chunk*     m_chunk = nullptr;
+        std::byte* m_pos = nullptr;
+    };
+
+    using const_iterator = iterator;
+
+    /**
+     * @param arena Arena to take chunks from.
+     * @param chunk_size Size of the chunks, records which don't fit into a chunk of this size get a larger one.
+    */
+    explicit RecordStream(Arena* arena, std::uint64_t chunk_size=DEFAULT_CHUNK_SIZE) noexcept
+    : m_arena(arena), m_chunk_size(chunk_size) {}
+
+    ~RecordStream() noexcept { clear(); }
+
+    RecordStream(const RecordStream&) = delete;
+    RecordStream& operator=(const RecordStream&) = delete;
+
+    RecordStream(RecordStream&& rhs) noexcept
+    : m_arena(rhs.m_arena), m_chunk_size(rhs.m_chunk_size), m_head(rhs.m_head), m_tail(rhs.m_tail),
+      m_size(rhs.m_size), m_chunks_count(rhs.m_chunks_count) {
+        rhs.m_head = rhs.m_tail = nullptr;
+        rhs.m_size = rhs.m_chunks_count = 0;
+    }
+
+    RecordStream& operator=(RecordStream&& rhs) noexcept {
+        if (this == &rhs) return *this;
+        clear();
+        m_arena = rhs.m_arena; m_chunk_size = rhs.m_chunk_size; m_head = rhs.m_head; m_tail = rhs.m_tail;
+        m_size = rhs.m_size; m_chunks_count = rhs.m_chunks_count;
+        rhs.m_head = rhs.m_tail = nullptr;
+        rhs.m_size = rhs.m_chunks_count = 0;
+        return *this;
+    }
+
+    /**
+     * Append a copy of value.
+     * @return Reference to the record's object, it stays valid until the stream is cleared.
+    */
+    template<class T>
+    T& push(const T& value) {
+        return emplace<T>(value);
+    }
+
+    /**
+     * Construct an object directly in the stream.
+    */
+    template<class T, class ...Args>
+    T& emplace(Args&&... args) {
+        static_assert(TAG_OF<T> < sizeof...(Types), "type is not a part of the stream");
+        std::byte* payload = append(TAG_OF<T>, sizeof(T), alignof(T));
+        return *new (payload) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Invoke f for every record with the object cast to its actual type.
+    */
+    template<class F>
+    void visit(F&& f) const {
+        for (Record record : *this) {
+            record.visit(f);
+        }
+    }
+
+    iterator begin() const noexcept { return m_head ? iterator(m_head, m_head->begin() + LINK_SIZE) : end(); }
+    iterator end() const noexcept { return iterator(); }
+
+    std::uint64_t size() const noexcept { return m_size; }
+    bool          empty() const noexcept { return m_size == 0; }
+    std::uint64_t chunksCount() const noexcept { return m_chunks_count; }
+
+    /**
+     * Release all the chunks back to the arena.
+    */
+    void clear() noexcept {
+        while (m_head) {
+            Chunk* chunk_next = next(m_head);
+            m_arena->releaseChunk(m_head);
+            m_head = chunk_next;
+        }
+        m_tail = nullptr;
+        m_size = 0;
+        m_chunks_count = 0;
+    }
+
+private:
+    static Chunk* next(Chunk* chunk) noexcept {
+        return *reinterpret_cast<Chunk**>(chunk->begin());
+    }
+
+    std::byte* append(std::uint16_t tag, std::uint64_t size, std::uint64_t alignment) {
+        if (size > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error(fmt::format("record of size {} is too large", size));
+
+        auto place = [size, alignment](Chunk* chunk) {
+            std::byte* header = chunk->end();
+            std::byte* payload = detail::alignUp(header + sizeof(detail::RecordHeader), alignment);
+            std::byte* record_end = detail::alignUp(payload + size, RECORD_ALIGNMENT);
+            return std::make_tuple(header, payload, record_end);
+        };
+
+        auto fits = [](Chunk* chunk, std::byte* record_end) {
+            return record_end <= chunk->begin() + chunk->size();
+        };
+
+        std::byte* header = nullptr;
+        std::byte* payload = nullptr;
+        std::byte* record_end = nullptr;
+        if (m_tail) {
+            std::tie(header, payload, record_end) = place(m_tail);
+        }
+        if (!m_tail || !fits(m_tail, record_end)) {
+            const std::uint64_t required = LINK_SIZE + sizeof(detail::RecordHeader) + alignment + size + RECORD_ALIGNMENT;
+            newChunk(std::max(m_chunk_size, required));
+            std::tie(header, payload, record_end) = place(m_tail);
+        }
+
+        new (header) detail::RecordHeader{tag, static_cast<std::uint16_t>(payload - header), static_cast<std::uint32_t>(size)};
+        m_tail->advance(record_end - header);
+        m_size += 1;
+        return payload;
+    }
+
+    void newChunk(std::uint64_t size) {
+        Chunk* chunk = m_arena->getChunk(size);
+        chunk->push<Chunk*>(nullptr);
+        if (m_tail) {
+            *reinterpret_cast<Chunk**>(m_tail->begin()) = chunk;
+        }
+        else {
+            m_head = chunk;
+        }
+        m_tail = chunk;
+        m_chunks_count += 1;
+    }
+
+    Arena*        m_arena;
+    std::uint64_t m_chunk_size;
+    Chunk*        m_head = nullptr;
+    Chunk*        m_tail = nullptr;
+    std::uint64_t m_size = 0;
+    std::uint64_t m_chunks_count = 0;
+};
+
+} // namespace mylib
@@ -0,0 +1,325 @@
+#include "rope.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifndef _WIN32
+# include <sys/uio.h>
+# include <cstddef>
+static_assert(sizeof(mylib::IoVec) == sizeof(iovec));
+static_assert(offsetof(mylib::IoVec, base) == offsetof(iovec, iov_base));
+static_assert(offsetof(mylib::IoVec, length) == offsetof(iovec, iov_len));
+#endif
+
+namespace mylib
+{
+Rope::Rope(Arena* arena, StringView str, std::uint64_t leaf_size)
+: m_arena(arena), m_leaf_size(leaf_size) {
+    m_root = newLeaves(str);
+}
+
+Rope::~Rope() { unref(m_root); }
+
+Rope::Rope(const Rope& rhs) noexcept
+: m_arena(rhs.m_arena), m_leaf_size(rhs.m_leaf_size), m_root(ref(rhs.m_root)) {}
+
+Rope& Rope::operator=(const Rope& rhs) noexcept {
+    Node* root = ref(rhs.m_root);
+    unref(m_root);
+    m_arena = rhs.m_arena;
+    m_leaf_size = rhs.m_leaf_size;
+    m_root = root;
+    return *this;
+}
+
+Rope::Rope(Rope&& rhs) noexcept
+: m_arena(rhs.m_arena), m_leaf_size(rhs.m_leaf_size), m_root(rhs.m_root) {
+    rhs.m_root = nullptr;
+}
+
+Rope& Rope::operator=(Rope&& rhs) noexcept {
+    if (this == &rhs) return *this;
+    unref(m_root);
+    m_arena = rhs.m_arena;
+    m_leaf_size = rhs.m_leaf_size;
+    m_root = rhs.m_root;
+    rhs.m_root = nullptr;
+    return *this;
+}
+
+std::uint64_t Rope::size() const noexcept { return lengthOf(m_root); }
+std::uint32_t Rope::depth() const noexcept { return depthOf(m_root); }
+
+char Rope::at(std::uint64_t pos) const {
+    if (pos >= size())
+        throw std::out_of_range(fmt::format("position {} is out of range, size {}", pos, size()));
+    const Node* node = m_root;
+    while (node->kind == Kind::CONCAT) {
+        if (pos < node->left->length) {
+            node = node->left;
+        }
+        else {
+            pos -= node->left->length;
+            node = node->right;
+        }
+    }
+    return node->data[pos];
+}
+
+Rope& Rope::append(StringView str) {
+    if (str.empty() || appendInPlace(str)) return *this;
+    m_root = join(m_root, newLeaves(str));
+    return *this;
+}
+
+Rope& Rope::append(const Rope& rope) {
+    m_root = join(m_root, ref(rope.m_root));
+    return *this;
+}
+
+Rope& Rope::insert(std::uint64_t pos, StringView str) {
+    validatePosition(pos);
+    if (pos == size()) return append(str);
+    // The inserted leaves never become the rightmost ones, so they are sized to their contents.
+    Rope inserted(m_arena, m_leaf_size);
+    inserted.m_root = newLeaves(str, false);
+    return insert(pos, inserted);
+}
+
+Rope& Rope::insert(std::uint64_t pos, const Rope& rope) {
+    validatePosition(pos);
+    // NOTE: The rope can be this one.
+    Node* inserted = ref(rope.m_root);
+    auto [left, right] = split(m_root, pos);
+    unref(m_root);
+    m_root = join(join(left, inserted), right);
+    return *this;
+}
+
+Rope& Rope::erase(std::uint64_t pos, std::uint64_t count) {
+    validatePosition(pos);
+    count = std::min(count, size() - pos);
+    if (!count) return *this;
+    auto [left, rest] = split(m_root, pos);
+    auto [erased, right] = split(rest, count);
+    unref(m_root);
+    unref(rest);
+    unref(erased);
+    m_root = join(left, right);
+    return *this;
+}
+
+Rope Rope::substr(std::uint64_t pos, std::uint64_t count) const {
+    validatePosition(pos);
+    count = std::min(count, size() - pos);
+    Rope result(m_arena, m_leaf_size);
+    auto [left, rest] = split(m_root, pos);
+    auto [middle, right] = split(rest, count);
+    unref(left);
+    unref(rest);
+    unref(right);
+    result.m_root = middle;
+    return result;
+}
+
+String Rope::flatten() const {
+    String str(size(), '\0');
+    char* data = str.data();
+    forEachPiece([&data](StringView piece) {
+        std::memcpy(data, piece.data(), piece.size());
+        data += piece.size();
+    });
+    return str;
+}
+
+std::vector<IoVec> Rope::ioVecs() const {
+    std::vector<IoVec> vecs;
+    forEachPiece([&vecs](StringView piece) { vecs.push_back(IoVec{piece.data(), piece.size()}); });
+    return vecs;
+}
+
+bool operator==(const Rope& lhs, const Rope& rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    if (lhs.m_root == rhs.m_root) return true;
+    // Compare piece by piece without flattening, the pieces of the two ropes don't have to line up.
+    std::vector<IoVec> rhs_pieces = rhs.ioVecs();
+    std::uint64_t index = 0;
+    std::uint64_t offset = 0;
+    bool equal = true;
+    lhs.forEachPiece([&](StringView piece) {
+        while (equal && !piece.empty()) {
+            const IoVec& other = rhs_pieces[index];
+            const std::uint64_t count = std::min<std::uint64_t>(piece.size(), other.length - offset);
+            equal = !std::memcmp(piece.data(), static_cast<const char*>(other.base) + offset, count);
+            piece.remove_prefix(count);
+            offset += count;
+            if (offset == other.length) {
+                index += 1;
+                offset = 0;
+            }
+        }
+    });
+    return equal;
+}
+
+Rope::Node* Rope::ref(Node* node) noexcept {
+    if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+void Rope::unref(Node* node) noexcept {
+    if (!node || (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)) return;
+    switch (node->kind) {
+    case Kind::LEAF:
+        node->arena->releaseChunk(node->chunk);
+        return;
+    case Kind::SLICE:
+        unref(node->base);
+        break;
+    case Kind::CONCAT:
+        unref(node->left);
+        unref(node->right);
+        break;
+    }
+    delete node;
+}
+
+Rope::Node* Rope::newLeaf(StringView str, bool spare) {
+    const std::uint64_t size = sizeof(Node) + str.size();
+    Chunk* chunk = m_arena->getChunk(spare ? std::max(m_leaf_size, size) : size);
+    auto* leaf = new (chunk->begin()) Node{};
+    leaf->kind = Kind::LEAF;
+    leaf->length = str.size();
+    leaf->chunk = chunk;
+    leaf->arena = m_arena;
+    leaf->data = reinterpret_cast<const char*>(chunk->begin() + sizeof(Node));
+    std::memcpy(chunk->begin() + sizeof(Node), str.data(), str.size());
+    return leaf;
+}
+
+// Pieces larger than a leaf are spread over several leaves, so that the rightmost one keeps some spare space
+// unless spare is false.
+Rope::Node* Rope::newLeaves(StringView str, bool spare) {
+    if (str.empty()) return nullptr;
+    const std::uint64_t capacity = m_leaf_size > sizeof(Node) ? m_leaf_size - sizeof(Node) : 1;
+    Node* root = nullptr;
+    while (!str.empty()) {
+        const std::uint64_t size = std::min<std::uint64_t>(str.size(), capacity);
+        root = join(root, newLeaf(StringView(str.data(), size), spare));
+        str.remove_prefix(size);
+    }
+    return root;
+}
+
+Rope::Node* Rope::newSlice(Node* node, std::uint64_t offset, std::uint64_t length) {
+    if ((offset == 0) && (length == node->length)) return ref(node);
+    auto* slice = new Node{};
+    slice->kind = Kind::SLICE;
+    slice->length = length;
+    slice->data = node->data + offset;
+    // Slices of slices refer to the leaf directly.
+    slice->base = ref(node->kind == Kind::SLICE ? node->base : node);
+    return slice;
+}
+
+Rope::Node* Rope::newConcat(Node* left, Node* right) {
+    auto* concat = new Node{};
+    concat->kind = Kind::CONCAT;
+    concat->left = left;
+    concat->right = right;
+    concat->length = left->length + right->length;
+    concat->depth = static_cast<std::uint8_t>(std::max(left->depth, right->depth) + 1);
+    return concat;
+}
+
+// AVL join, takes over the references to left and right. The result is balanced
+// if the inputs are, and only the nodes along one spine are created.
+Rope::Node* Rope::join(Node* left, Node* right) {
+    if (!left) return right;
+    if (!right) return left;
+    if (left->depth > right->depth + 1) {
+        Node* joined = balance(ref(left->left), join(ref(left->right), right));
+        unref(left);
+        return joined;
+    }
+    if (right->depth > left->depth + 1) {
+        Node* joined = balance(join(left, ref(right->left)), ref(right->right));
+        unref(right);
+        return joined;
+    }
+    return newConcat(left, right);
+}
+
+// Concatenate subtrees whose depths differ by at most two, rotating if they differ by two.
+Rope::Node* Rope::balance(Node* left, Node* right) {
+    if (left->depth > right->depth + 1) {
+        Node* result = nullptr;
+        if (left->left->depth >= left->right->depth) {
+            result = newConcat(ref(left->left), newConcat(ref(left->right), right));
+        }
+        else {
+            Node* inner = left->right;
+            result = newConcat(newConcat(ref(left->left), ref(inner->left)), newConcat(ref(inner->right), right));
+        }
+        unref(left);
+        return result;
+    }
+    if (right->depth > left->depth + 1) {
+        Node* result = nullptr;
+        if (right->right->depth >= right->left->depth) {
+            result = newConcat(newConcat(left, ref(right->left)), ref(right->right));
+        }
+        else {
+            Node* inner = right->left;
+            result = newConcat(newConcat(left, ref(inner->left)), newConcat(ref(inner->right), ref(right->right)));
+        }
+        unref(right);
+        return result;
+    }
+    return newConcat(left, right);
+}
+
+// Doesn't consume node, returns new references.
+std::pair<Rope::Node*, Rope::Node*> Rope::split(Node* node, std::uint64_t pos) {
+    if (!node) return {nullptr, nullptr};
+    if (pos == 0) return {nullptr, ref(node)};
+    if (pos >= node->length) return {ref(node), nullptr};
+    if (node->kind != Kind::CONCAT)
+        return {newSlice(node, 0, pos), newSlice(node, pos, node->length - pos)};
+
+    const std::uint64_t left_length = node->left->length;
+    if (pos < left_length) {
+        auto [left, right] = split(node->left, pos);
+        return {left, join(right, ref(node->right))};
+    }
+    auto [left, right] = split(node->right, pos - left_length);
+    return {join(ref(node->left), left), right};
+}
+
+bool Rope::appendInPlace(StringView str) noexcept {
+    // Only the nodes nobody else refers to can be modified, the leaf has to have enough spare space.
+    if (!m_root) return false;
+    Node* leaf = m_root;
+    while (true) {
+        if (leaf->refs.load(std::memory_order_acquire) != 1) return false;
+        if (leaf->kind != Kind::CONCAT) break;
+        leaf = leaf->right;
+    }
+    if ((leaf->kind != Kind::LEAF) || (leaf->chunk->size() - sizeof(Node) - leaf->length < str.size())) return false;
+
+    std::memcpy(leaf->chunk->begin() + sizeof(Node) + leaf->length, str.data(), str.size());
+    for (Node* node = m_root; node; node = (node->kind == Kind::CONCAT) ? node->right : nullptr) {
+        node->length += str.size();
+    }
+    return true;
+}
+
+void Rope::validatePosition(std::uint64_t pos) const {
+    if (pos > size())
+        throw std::out_of_range(fmt::format("position {} is out of range, size {}", pos, size()));
+}
+
+} // namespace mylib
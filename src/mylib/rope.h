@@ -0,0 +1,154 @@
+#pragma once
+
+#include "arena.h"
+#include "string.h"
+#include "string_view.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mylib
+{
+/**
+ * Buffer descriptor for scatter/gather output, has the same layout as POSIX struct iovec,
+ * so an array of them can be passed to writev directly.
+*/
+struct IoVec {
+    const void* base;
+    std::size_t length;
+};
+
+/**
+ * Immutable-structure string for building and editing large texts. The characters are stored in leaves,
+ * each of which occupies an arena chunk, and the leaves are joined by concatenation nodes into an AVL-balanced tree.
+ * Concatenation, insertion, erasure and substring take O(log n) time and share the untouched subtrees,
+ * so copies of a rope are O(1) and never duplicate the characters. Appending small pieces fills
+ * the rightmost leaf in place while it's not shared, thus building a payload by repeated appends is linear.
+ * Nodes are reference counted atomically, so ropes sharing nodes can be used from different threads,
+ * but a single rope is not thread-safe.
+*/
+class Rope {
+public:
+    constexpr static std::uint64_t DEFAULT_LEAF_SIZE{64u*1024u};
+
+    explicit Rope(Arena* arena, std::uint64_t leaf_size=DEFAULT_LEAF_SIZE) noexcept
+    : m_arena(arena), m_leaf_size(leaf_size) {}
+
+    Rope(Arena* arena, StringView str, std::uint64_t leaf_size=DEFAULT_LEAF_SIZE);
+    ~Rope();
+
+    Rope(const Rope& rhs) noexcept;
+    Rope& operator=(const Rope& rhs) noexcept;
+    Rope(Rope&& rhs) noexcept;
+    Rope& operator=(Rope&& rhs) noexcept;
+
+    std::uint64_t size() const noexcept;
+    bool          empty() const noexcept { return size() == 0; }
+
+    /**
+     * @return Height of the tree, 0 for an empty rope or a single leaf.
+    */
+    std::uint32_t depth() const noexcept;
+
+    /**
+     * @throw std::out_of_range If pos is not less than size().
+    */
+    char at(std::uint64_t pos) const;
+
+    Rope& append(StringView str);
+    Rope& append(const Rope& rope);
+    Rope& operator+=(StringView str) { return append(str); }
+    Rope& operator+=(const Rope& rope) { return append(rope); }
+
+    /**
+     * @throw std::out_of_range If pos is greater than size().
+    */
+    Rope& insert(std::uint64_t pos, StringView str);
+    Rope& insert(std::uint64_t pos, const Rope& rope);
+
+    /**
+     * Remove at most count characters starting at pos.
+     * @throw std::out_of_range If pos is greater than size().
+    */
+    Rope& erase(std::uint64_t pos, std::uint64_t count);
+
+    /**
+     * @return Rope of at most count characters starting at pos, sharing the leaves with this one.
+     * @throw std::out_of_range If pos is greater than size().
+    */
+    Rope substr(std::uint64_t pos, std::uint64_t count) const;
+
+    /**
+     * Copy the characters into a contiguous string.
+    */
+    String flatten() const;
+
+    /**
+     * Invoke f(StringView) for every contiguous piece of the rope in order.
+    */
+    template<class F>
+    void forEachPiece(F&& f) const {
+        if (!m_root) return;
+        std::vector<const Node*> stack{m_root};
+        while (!stack.empty()) {
+            const Node* node = stack.back();
+            stack.pop_back();
+            while (node->kind == Kind::CONCAT) {
+                stack.push_back(node->right);
+                node = node->left;
+            }
+            f(StringView(node->data, node->length));
+        }
+    }
+
+    /**
+     * Describe the pieces for scatter/gather output without copying, e.g. writev(fd, vecs.data(), vecs.size()).
+     * The descriptors are valid while the rope or any rope sharing its leaves is alive.
+    */
+    std::vector<IoVec> ioVecs() const;
+
+    friend bool operator==(const Rope& lhs, const Rope& rhs);
+
+private:
+    enum class Kind : std::uint8_t {
+        LEAF,   // Owns the chunk it's placed in, the characters follow the node.
+        SLICE,  // Part of a leaf.
+        CONCAT
+    };
+
+    struct Node {
+        std::atomic<std::uint32_t> refs{1};
+        Kind                       kind;
+        std::uint8_t               depth = 0;
+        std::uint64_t              length = 0;
+        const char*                data = nullptr;  // LEAF and SLICE.
+        Chunk*                     chunk = nullptr; // LEAF.
+        Arena*                     arena = nullptr; // LEAF, ropes from different arenas can be joined.
+        Node*                      base = nullptr;  // SLICE.
+        Node*                      left = nullptr;  // CONCAT.
+        Node*                      right = nullptr; // CONCAT.
+    };
+
+    static Node*         ref(Node* node) noexcept;
+    static void          unref(Node* node) noexcept;
+    static std::uint8_t  depthOf(const Node* node) noexcept { return node ? node->depth : 0; }
+    static std::uint64_t lengthOf(const Node* node) noexcept { return node ? node->length : 0; }
+
+    Node*        newLeaf(StringView str, bool spare=true);
+    Node*        newLeaves(StringView str, bool spare=true);
+    static Node* newSlice(Node* node, std::uint64_t offset, std::uint64_t length);
+    static Node* newConcat(Node* left, Node* right);
+    static Node* join(Node* left, Node* right);
+    static Node* balance(Node* left, Node* right);
+    static std::pair<Node*, Node*> split(Node* node, std::uint64_t pos);
+    bool         appendInPlace(StringView str) noexcept;
+    void         validatePosition(std::uint64_t pos) const;
+
+    Arena*        m_arena;
+    std::uint64_t m_leaf_size;
+    Node*         m_root = nullptr;
+};
+
+} // namespace mylib
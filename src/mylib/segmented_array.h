@@ -0,0 +1,322 @@
+#pragma once
+
+#include "arena.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mylib
+{
+namespace detail
+{
+// As many elements as fit into 64KiB, but at least one.
+template<class Object>
+constexpr std::size_t defaultSegmentSize() noexcept {
+    return std::bit_floor(std::max<std::size_t>(1u, (64u*1024u) / sizeof(Object)));
+}
+} // namespace detail
+
+/**
+ * Array made of fixed-size segments, each of which is an arena chunk of SEGMENT_SIZE elements,
+ * tracked by a directory of segment pointers. Appending never moves the elements, so pointers and references
+ * stay valid until the element is removed, and the cost of a push doesn't depend on the size of the array:
+ * only the directory, one pointer per segment, is reallocated when it runs out of space.
+ * Indexing is O(1), the segment is found by a shift and the position inside it by a mask.
+ * Unlike GrowingArray, the elements are not contiguous, use forEachSegment for bulk processing.
+*/
+template<class Object, std::size_t SegmentSize=detail::defaultSegmentSize<Object>()>
+class SegmentedArray {
+    static_assert(std::has_single_bit(SegmentSize), "segment size has to be a power of two");
+
+public:
+    using value_type = Object;
+
+    constexpr static std::size_t SEGMENT_SIZE{SegmentSize};
+    constexpr static std::size_t SEGMENT_SHIFT{static_cast<std::size_t>(std::countr_zero(SEGMENT_SIZE))};
+    constexpr static std::size_t SEGMENT_MASK{SEGMENT_SIZE - 1};
+    constexpr static std::size_t INITIAL_DIRECTORY_SIZE{64u};
+
+    template<bool CONST>
+    class basic_iterator;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    explicit SegmentedArray(Arena* arena) noexcept
+    : m_arena(arena) {}
+
+    ~SegmentedArray() noexcept {
+        truncate(0);
+        releaseDirectory();
+    }
+
+    SegmentedArray(const SegmentedArray& rhs)
+    : m_arena(rhs.m_arena) { init(rhs); }
+
+    SegmentedArray& operator=(const SegmentedArray& rhs) {
+        if (this == &rhs) return *this;
+        truncate(0);
+        init(rhs);
+        return *this;
+    }
+
+    SegmentedArray(SegmentedArray&& rhs) noexcept
+    : m_arena(rhs.m_arena) { steal(rhs); }
+
+    SegmentedArray& operator=(SegmentedArray&& rhs) noexcept {
+        if (this == &rhs) return *this;
+        truncate(0);
+        releaseDirectory();
+        m_arena = rhs.m_arena;
+        steal(rhs);
+        return *this;
+    }
+
+    /**
+     * @throw std::out_of_range If the index is not less than size().
+    */
+    Object& operator[](std::size_t index) { validateIndex(index); return at(index); }
+    const Object& operator[](std::size_t index) const { validateIndex(index); return at(index); }
+
+    void push_back(const Object& value) { emplace_back(value); }
+    void push_back(Object&& value) { emplace_back(std::move(value)); }
+
+    /**
+     * Construct an element at the end. A new segment is taken from the arena only when the last one is full,
+     * and the already constructed elements are never moved.
+    */
+    template<class ...Args>
+    Object& emplace_back(Args&&... args) {
+        if (((m_size & SEGMENT_MASK) == 0) && ((m_size >> SEGMENT_SHIFT) == m_segments_count)) [[unlikely]]
+            addSegment();
+        Object* object = ::new (static_cast<void*>(&at(m_size))) Object(std::forward<Args>(args)...);
+        m_size += 1;
+        return *object;
+    }
+
+    /**
+     * @throw std::out_of_range If the array is empty.
+    */
+    void pop_back() {
+        validateIndex(m_size - 1);
+        m_written = std::max(m_written, m_size);
+        m_size -= 1;
+        std::destroy_at(&at(m_size));
+    }
+
+    /**
+     * Destroy the elements starting at the given size, and release the segments past the new size,
+     * including the reserved ones, back to the arena in one call. Shrinking never touches the remaining elements.
+     * With the default clear policy the arena clears the released elements right away,
+     * ClearPolicy::CLEAR_ON_ACQUIRE defers that to the next user of the memory.
+    */
+    void truncate(std::size_t new_size) noexcept {
+        if (new_size > m_size) return;
+        if constexpr (!std::is_trivially_destructible_v<Object>) {
+            for (std::size_t i = new_size; i < m_size; i++) {
+                std::destroy_at(&at(i));
+            }
+        }
+        const std::size_t written = std::max(m_written, m_size);
+        m_size = new_size;
+        m_written = written;
+        const std::size_t used = (m_size + SEGMENT_MASK) >> SEGMENT_SHIFT;
+        if (used < m_segments_count) {
+            // NOTE: Only the bytes which ever held elements are marked as used, so the arena doesn't clear
+            // the reserved segments which were never written to.
+            for (std::size_t i = used; i < m_segments_count; i++) {
+                const std::size_t begin = i << SEGMENT_SHIFT;
+                if (begin >= written) break;
+                m_chunks[i]->advance(sizeof(Object)*std::min(SEGMENT_SIZE, written - begin));
+            }
+            m_arena->releaseChunks(std::span<Chunk* const>(m_chunks + used, m_segments_count - used));
+            m_segments_count = used;
+            m_written = std::min(written, capacity());
+        }
+    }
+
+    /**
+     * Allocate the segments for at least new_cap elements up front.
+    */
+    void reserve(std::size_t new_cap) {
+        while (capacity() < new_cap) {
+            addSegment();
+        }
+    }
+
+    Object& front() { validateIndex(0); return at(0); }
+    const Object& front() const { validateIndex(0); return at(0); }
+    Object& back() { validateIndex(m_size - 1); return at(m_size - 1); }
+    const Object& back() const { validateIndex(m_size - 1); return at(m_size - 1); }
+
+    std::size_t size() const noexcept { return m_size; }
+    std::size_t capacity() const noexcept { return m_segments_count << SEGMENT_SHIFT; }
+    std::size_t segmentsCount() const noexcept { return m_segments_count; }
+    bool        empty() const noexcept { return m_size == 0; }
+
+    /**
+     * Destroy all the elements and release all the segments, the directory is kept.
+    */
+    void clear() noexcept { truncate(0); }
+
+    /**
+     * Invoke f(std::span<Object>) for every segment in order, the last span ends at size().
+    */
+    template<class F>
+    void forEachSegment(F&& f) {
+        for (std::size_t pos = 0; pos < m_size; pos += SEGMENT_SIZE) {
+            f(std::span<Object>(m_segments[pos >> SEGMENT_SHIFT], std::min(SEGMENT_SIZE, m_size - pos)));
+        }
+    }
+
+    template<class F>
+    void forEachSegment(F&& f) const {
+        for (std::size_t pos = 0; pos < m_size; pos += SEGMENT_SIZE) {
+            f(std::span<const Object>(m_segments[pos >> SEGMENT_SHIFT], std::min(SEGMENT_SIZE, m_size - pos)));
+        }
+    }
+
+    iterator       begin() noexcept { return iterator(this, 0); }
+    iterator       end() noexcept { return iterator(this, m_size); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, m_size); }
+
+private:
+    Object& at(std::size_t index) const noexcept {
+        return m_segments[index >> SEGMENT_SHIFT][index & SEGMENT_MASK];
+    }
+
+    void addSegment() {
+        if (m_segments_count == m_directory_size) growDirectory();
+        Chunk* chunk = m_arena->getChunk(sizeof(Object)*SEGMENT_SIZE);
+        m_chunks[m_segments_count] = chunk;
+        m_segments[m_segments_count] = reinterpret_cast<Object*>(chunk->begin());
+        m_segments_count += 1;
+    }
+
+    // The directory is two arrays, the segment pointers for indexing, and the chunks for releasing them.
+    void growDirectory() {
+        const std::size_t new_size = m_directory_size ? m_directory_size*2 : INITIAL_DIRECTORY_SIZE;
+        Chunk* chunks = m_arena->getChunk(sizeof(Chunk*)*new_size);
+        Chunk* segments = nullptr;
+        try {
+            segments = m_arena->getChunk(sizeof(Object*)*new_size);
+        } catch (...) {
+            m_arena->releaseChunk(chunks);
+            throw;
+        }
+        chunks->advance(chunks->size());
+        segments->advance(segments->size());
+        std::copy_n(m_chunks, m_segments_count, reinterpret_cast<Chunk**>(chunks->begin()));
+        std::copy_n(m_segments, m_segments_count, reinterpret_cast<Object**>(segments->begin()));
+        releaseDirectory();
+        m_chunks_chunk = chunks;
+        m_segments_chunk = segments;
+        m_chunks = reinterpret_cast<Chunk**>(chunks->begin());
+        m_segments = reinterpret_cast<Object**>(segments->begin());
+        m_directory_size = std::min(chunks->size() / sizeof(Chunk*), segments->size() / sizeof(Object*));
+    }
+
+    void releaseDirectory() noexcept {
+        if (!m_chunks_chunk) return;
+        Chunk* const directory[] = {m_chunks_chunk, m_segments_chunk};
+        m_arena->releaseChunks(directory);
+        m_chunks_chunk = m_segments_chunk = nullptr;
+        m_chunks = nullptr;
+        m_segments = nullptr;
+        m_directory_size = 0;
+    }
+
+    void steal(SegmentedArray& rhs) noexcept {
+        m_chunks_chunk = rhs.m_chunks_chunk; m_segments_chunk = rhs.m_segments_chunk;
+        m_chunks = rhs.m_chunks; m_segments = rhs.m_segments;
+        m_directory_size = rhs.m_directory_size; m_segments_count = rhs.m_segments_count; m_size = rhs.m_size;
+        m_written = rhs.m_written;
+        rhs.m_chunks_chunk = rhs.m_segments_chunk = nullptr;
+        rhs.m_chunks = nullptr; rhs.m_segments = nullptr;
+        rhs.m_directory_size = rhs.m_segments_count = rhs.m_size = rhs.m_written = 0;
+    }
+
+    void init(const SegmentedArray& rhs) {
+        reserve(rhs.m_size);
+        for (std::size_t i = 0; i < rhs.m_size; i++) {
+            ::new (static_cast<void*>(&at(i))) Object(rhs.at(i));
+            m_size += 1;
+        }
+    }
+
+    void validateIndex(std::size_t index) const {
+        if (index >= m_size)
+            throw std::out_of_range(fmt::format("index {} is out of range", index));
+    }
+
+    Arena*      m_arena;
+    Chunk*      m_chunks_chunk = nullptr;
+    Chunk*      m_segments_chunk = nullptr;
+    Chunk**     m_chunks = nullptr;
+    Object**    m_segments = nullptr;
+    std::size_t m_directory_size = 0;
+    std::size_t m_segments_count = 0;
+    std::size_t m_size = 0;
+    std::size_t m_written = 0; // High-water mark of m_size, updated when the array shrinks.
+};
+
+template<class Object, std::size_t SegmentSize>
+template<bool CONST>
+class SegmentedArray<Object, SegmentSize>::basic_iterator {
+    using array_type = std::conditional_t<CONST, const SegmentedArray, SegmentedArray>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Object;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<CONST, const Object*, Object*>;
+    using reference = std::conditional_t<CONST, const Object&, Object&>;
+
+    basic_iterator() noexcept = default;
+
+    // iterator converts to const_iterator.
+    template<bool OTHER_CONST, class = std::enable_if_t<CONST && !OTHER_CONST>>
+    basic_iterator(const basic_iterator<OTHER_CONST>& rhs) noexcept
+    : m_array(rhs.m_array), m_index(rhs.m_index) {}
+
+    reference operator*() const noexcept { return m_array->at(m_index); }
+    pointer   operator->() const noexcept { return &m_array->at(m_index); }
+    reference operator[](difference_type n) const noexcept { return m_array->at(m_index + n); }
+
+    basic_iterator& operator++() noexcept { m_index++; return *this; }
+    basic_iterator  operator++(int) noexcept { basic_iterator tmp = *this; m_index++; return tmp; }
+    basic_iterator& operator--() noexcept { m_index--; return *this; }
+    basic_iterator  operator--(int) noexcept { basic_iterator tmp = *this; m_index--; return tmp; }
+    basic_iterator& operator+=(difference_type n) noexcept { m_index += n; return *this; }
+    basic_iterator& operator-=(difference_type n) noexcept { m_index -= n; return *this; }
+
+    friend basic_iterator operator+(basic_iterator itr, difference_type n) noexcept { return itr += n; }
+    friend basic_iterator operator+(difference_type n, basic_iterator itr) noexcept { return itr += n; }
+    friend basic_iterator operator-(basic_iterator itr, difference_type n) noexcept { return itr -= n; }
+    friend difference_type operator-(const basic_iterator& lhs, const basic_iterator& rhs) noexcept {
+        return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index);
+    }
+
+    bool operator==(const basic_iterator& rhs) const noexcept { return m_index == rhs.m_index; }
+    auto operator<=>(const basic_iterator& rhs) const noexcept { return m_index <=> rhs.m_index; }
+
+private:
+    friend class SegmentedArray<Object, SegmentSize>;
+    template<bool> friend class basic_iterator;
+
+    basic_iterator(array_type* array, std::size_t index) noexcept
+    : m_array(array), m_index(index) {}
+
+    array_type* m_array = nullptr;
+    std::size_t m_index = 0;
+};
+
+} // namespace mylib
@@ -0,0 +1,258 @@
+#include "serialization.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+# undef max
+# undef min
+#else
+# include <fcntl.h>
+# include <limits.h>
+# include <sys/uio.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::byte ZERO_PADDING[mylib::detail::PAYLOAD_ALIGNMENT]{};
+
+// A single read/write call is limited to less than 2Gib on most platforms.
+constexpr std::uint64_t MAX_IO_SIZE{1024u*1024u*1024u};
+
+std::uint64_t alignmentPadding(std::uint64_t offset, std::uint64_t alignment) noexcept {
+    std::uint64_t rem = offset % alignment;
+    return (rem == 0) ? 0 : (alignment - rem);
+}
+
+void closeFile(std::intptr_t file) noexcept {
+#ifdef _WIN32
+    CloseHandle(reinterpret_cast<HANDLE>(file));
+#else
+    close(static_cast<int>(file));
+#endif
+}
+}
+
+namespace mylib
+{
+
+BinaryWriter::BinaryWriter(const std::filesystem::path& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw serialization_error(fmt::format("failed to open file {}", path.string()));
+    m_file = reinterpret_cast<std::intptr_t>(file);
+#else
+    m_file = open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (m_file == -1)
+        throw serialization_error(fmt::format("failed to open file {}", path.string()));
+#endif
+    m_stream_header = detail::StreamHeader{detail::STREAM_MAGIC, detail::STREAM_VERSION};
+    queue(&m_stream_header, sizeof(m_stream_header));
+}
+
+BinaryWriter::~BinaryWriter() {
+    try {
+        flush();
+    } catch (const serialization_error&) {
+        // Destructors cannot throw, call flush() explicitly to handle the errors.
+    }
+    closeFile(m_file);
+}
+
+void BinaryWriter::write(const String& str) {
+    append(detail::RecordKind::STRING, sizeof(char), str.size(), str.data(), str.size());
+}
+
+void BinaryWriter::flush() {
+    writeSegments();
+    m_records_count = 0;
+    m_segments_count = 0;
+}
+
+void BinaryWriter::append(detail::RecordKind kind, std::uint32_t element_size, std::uint64_t count,
+                          const void* data, std::uint64_t size) {
+    if (m_records_count == BATCH_SIZE) {
+        flush();
+    }
+
+    auto& header = m_headers[m_records_count++];
+    header = detail::RecordHeader{kind, element_size, count, size};
+    queue(&header, sizeof(header));
+    if (kind == detail::RecordKind::ARRAY) {
+        queue(ZERO_PADDING, alignmentPadding(m_offset, detail::PAYLOAD_ALIGNMENT));
+    }
+    queue(data, size);
+    queue(ZERO_PADDING, alignmentPadding(m_offset, detail::RECORD_ALIGNMENT));
+}
+
+void BinaryWriter::queue(const void* data, std::uint64_t size) noexcept {
+    if (!size) return;
+    m_segments[m_segments_count++] = Segment{data, size};
+    m_offset += size;
+}
+
+void BinaryWriter::writeSegments() {
+#ifdef _WIN32
+    HANDLE file = reinterpret_cast<HANDLE>(m_file);
+    for (std::uint64_t i = 0; i < m_segments_count; i++) {
+        auto* data = static_cast<const std::byte*>(m_segments[i].data);
+        std::uint64_t remaining = m_segments[i].size;
+        while (remaining) {
+            DWORD written = 0;
+            DWORD size = static_cast<DWORD>(std::min(remaining, MAX_IO_SIZE));
+            if (!WriteFile(file, data, size, &written, nullptr))
+                throw serialization_error(fmt::format("failed to write {} bytes", size));
+            data += written;
+            remaining -= written;
+        }
+    }
+#else
+    // NOTE: writev might write only a part of the segments, in which case we advance
+    // through the iovec array and continue from the first partially written segment.
+    iovec iov[MAX_SEGMENTS_COUNT];
+    std::uint64_t count = 0;
+    for (std::uint64_t i = 0; i < m_segments_count; i++) {
+        iov[count++] = iovec{const_cast<void*>(m_segments[i].data), m_segments[i].size};
+    }
+
+    iovec* cur = iov;
+    while (count) {
+        int iov_count = static_cast<int>(std::min<std::uint64_t>(count, IOV_MAX));
+        ssize_t written = ::writev(static_cast<int>(m_file), cur, iov_count);
+        if (written == -1)
+            throw serialization_error(fmt::format("failed to write {} segments", iov_count));
+        std::uint64_t remaining = static_cast<std::uint64_t>(written);
+        while (count && remaining >= cur->iov_len) {
+            remaining -= cur->iov_len;
+            cur++;
+            count--;
+        }
+        if (count) {
+            cur->iov_base = static_cast<std::byte*>(cur->iov_base) + remaining;
+            cur->iov_len -= remaining;
+        }
+    }
+#endif
+}
+
+BinaryReader::BinaryReader(const std::filesystem::path& path)
+: m_buffer(std::make_unique<std::byte[]>(BUFFER_SIZE)) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw serialization_error(fmt::format("failed to open file {}", path.string()));
+    m_file = reinterpret_cast<std::intptr_t>(file);
+#else
+    m_file = open(path.c_str(), O_RDONLY);
+    if (m_file == -1)
+        throw serialization_error(fmt::format("failed to open file {}", path.string()));
+# ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(static_cast<int>(m_file), 0, 0, POSIX_FADV_SEQUENTIAL);
+# endif
+#endif
+    detail::StreamHeader header{};
+    try {
+        readExact(&header, sizeof(header));
+    } catch (const serialization_error&) {
+        header.magic = 0;
+    }
+    if ((header.magic != detail::STREAM_MAGIC) || (header.version != detail::STREAM_VERSION)) {
+        closeFile(m_file);
+        throw serialization_error(fmt::format("file {} is not a binary stream", path.string()));
+    }
+}
+
+BinaryReader::~BinaryReader() {
+    closeFile(m_file);
+}
+
+String BinaryReader::readString() {
+    detail::RecordHeader header = readHeader(detail::RecordKind::STRING, sizeof(char));
+    String str(header.count, '\0');
+    readExact(str.data(), header.payload_size);
+    skip(padding(detail::RECORD_ALIGNMENT));
+    return str;
+}
+
+bool BinaryReader::eof() {
+    if (m_buffer_pos == m_buffer_size) {
+        m_buffer_pos = 0;
+        m_buffer_size = readFile(m_buffer.get(), BUFFER_SIZE);
+    }
+    return m_buffer_size == 0;
+}
+
+detail::RecordHeader BinaryReader::readHeader(detail::RecordKind kind, std::uint32_t element_size) {
+    detail::RecordHeader header{};
+    readExact(&header, sizeof(header));
+    if (header.kind != kind)
+        throw serialization_error(fmt::format("unexpected record kind {}", static_cast<std::uint32_t>(header.kind)));
+    if ((header.element_size != element_size) || (header.count*element_size != header.payload_size))
+        throw serialization_error(fmt::format("element size mismatch, expected {} got {}", element_size, header.element_size));
+    return header;
+}
+
+std::uint64_t BinaryReader::padding(std::uint64_t alignment) const noexcept {
+    return alignmentPadding(m_offset, alignment);
+}
+
+void BinaryReader::readExact(void* dst, std::uint64_t size) {
+    auto* out = static_cast<std::byte*>(dst);
+    m_offset += size;
+    while (size) {
+        if (m_buffer_pos < m_buffer_size) {
+            std::uint64_t count = std::min(size, m_buffer_size - m_buffer_pos);
+            std::memcpy(out, m_buffer.get() + m_buffer_pos, count);
+            m_buffer_pos += count;
+            out += count;
+            size -= count;
+            continue;
+        }
+
+        // Large payloads bypass the buffer and go straight into the destination memory.
+        std::uint64_t count = 0;
+        if (size >= BUFFER_SIZE) {
+            count = readFile(out, size);
+            out += count;
+            size -= count;
+        }
+        else {
+            m_buffer_pos = 0;
+            m_buffer_size = count = readFile(m_buffer.get(), BUFFER_SIZE);
+        }
+        if (!count)
+            throw serialization_error(fmt::format("unexpected end of stream, {} bytes are missing", size));
+    }
+}
+
+void BinaryReader::skip(std::uint64_t size) {
+    std::byte discard[detail::PAYLOAD_ALIGNMENT];
+    readExact(discard, size);
+}
+
+std::uint64_t BinaryReader::readFile(void* dst, std::uint64_t size) {
+    auto* out = static_cast<std::byte*>(dst);
+    std::uint64_t total = 0;
+    while (total < size) {
+        std::uint64_t count = std::min(size - total, MAX_IO_SIZE);
+#ifdef _WIN32
+        DWORD read = 0;
+        if (!ReadFile(reinterpret_cast<HANDLE>(m_file), out + total, static_cast<DWORD>(count), &read, nullptr))
+            throw serialization_error(fmt::format("failed to read {} bytes", count));
+#else
+        ssize_t read = ::read(static_cast<int>(m_file), out + total, count);
+        if (read == -1)
+            throw serialization_error(fmt::format("failed to read {} bytes", count));
+#endif
+        if (read == 0) break;
+        total += static_cast<std::uint64_t>(read);
+    }
+    return total;
+}
+
+} // namespace mylib
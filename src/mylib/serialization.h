@@ -0,0 +1,182 @@
+#pragma once
+
+#include "arena.h"
+#include "growing_array.h"
+#include "string.h"
+#include <array>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mylib
+{
+class serialization_error : public std::runtime_error {
+public:
+    explicit serialization_error(const std::string& msg)
+    : std::runtime_error(msg)
+    {}
+};
+
+namespace detail
+{
+/**
+ * Binary stream layout. A stream header is followed by a sequence of records,
+ * each record consists of a header and a raw payload. Array payloads are aligned
+ * by PAYLOAD_ALIGNMENT within the stream, so they can be used directly when the file is mapped,
+ * string payloads are only padded to the record header alignment.
+ * +--------+--------+-----+--------------------+--------+-----------+---+--------+-----
+ * | stream | record | pad |   array payload    | record |  string   |pad| record | ...
+ * | header | header |     |                    | header |  payload  |   | header |
+ * +--------+--------+-----+--------------------+--------+-----------+---+--------+-----
+*/
+enum class RecordKind : std::uint32_t {
+    ARRAY = 1,
+    STRING = 2
+};
+
+struct StreamHeader {
+    std::uint64_t magic;
+    std::uint64_t version;
+};
+
+struct RecordHeader {
+    RecordKind    kind;
+    std::uint32_t element_size;
+    std::uint64_t count;
+    std::uint64_t payload_size;
+};
+
+constexpr std::uint64_t STREAM_MAGIC{0x4d414552544c4d42ull}; // "BMLTREAM"
+constexpr std::uint64_t STREAM_VERSION{1u};
+constexpr std::uint64_t PAYLOAD_ALIGNMENT{64u};
+constexpr std::uint64_t RECORD_ALIGNMENT{alignof(RecordHeader)};
+}
+
+/**
+ * Writes containers into a binary stream without per-element encoding.
+ * Payloads are written straight from the containers' memory, records are queued and
+ * flushed in batches with a single vectored write. The containers have to stay alive
+ * and unmodified until the next flush() call, or the writer's destruction.
+*/
+class BinaryWriter {
+public:
+    constexpr static std::uint64_t BATCH_SIZE{64u};
+    // Stream header, plus a record header, payload and two paddings per record.
+    constexpr static std::uint64_t MAX_SEGMENTS_COUNT{BATCH_SIZE*4 + 1};
+
+    explicit BinaryWriter(const std::filesystem::path& path);
+    ~BinaryWriter();
+
+    BinaryWriter(const BinaryWriter&) = delete;
+    BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+    /**
+     * Queue an array, only trivially copyable objects can be written as raw bytes.
+    */
+    template<class Object>
+    void write(const GrowingArray<Object>& array) {
+        static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be serialized");
+        append(detail::RecordKind::ARRAY, sizeof(Object), array.size(), array.data(), array.size()*sizeof(Object));
+    }
+
+    /**
+     * Queue a contiguous range of objects as an array record, it can be read back with readArray.
+    */
+    template<class Object>
+    void write(std::span<const Object> values) {
+        static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be serialized");
+        append(detail::RecordKind::ARRAY, sizeof(Object), values.size(), values.data(), values.size_bytes());
+    }
+
+    /**
+     * Queue a length-prefixed string.
+    */
+    void write(const String& str);
+
+    /**
+     * Write all the queued records to the file.
+     * @throw serialization_error If the write fails.
+    */
+    void flush();
+
+private:
+    struct Segment {
+        const void*   data;
+        std::uint64_t size;
+    };
+
+    void append(detail::RecordKind kind, std::uint32_t element_size, std::uint64_t count,
+                const void* data, std::uint64_t size);
+    void queue(const void* data, std::uint64_t size) noexcept;
+    void writeSegments();
+
+    std::intptr_t                                        m_file;
+    std::uint64_t                                        m_offset = 0;
+    std::uint64_t                                        m_records_count = 0;
+    std::uint64_t                                        m_segments_count = 0;
+    detail::StreamHeader                                 m_stream_header{};
+    std::array<detail::RecordHeader, BATCH_SIZE>         m_headers{};
+    std::array<Segment, MAX_SEGMENTS_COUNT>              m_segments{};
+};
+
+/**
+ * Reads containers written by BinaryWriter. Array payloads are read with a single read
+ * directly into an arena chunk of the right size, small records are served from a read buffer.
+*/
+class BinaryReader {
+public:
+    constexpr static std::uint64_t BUFFER_SIZE{64u*1024u};
+
+    explicit BinaryReader(const std::filesystem::path& path);
+    ~BinaryReader();
+
+    BinaryReader(const BinaryReader&) = delete;
+    BinaryReader& operator=(const BinaryReader&) = delete;
+
+    /**
+     * @throw serialization_error If the next record is not an array of Object.
+    */
+    template<class Object>
+    GrowingArray<Object> readArray(Arena* arena) {
+        static_assert(std::is_trivially_copyable_v<Object>, "only trivially copyable objects can be serialized");
+        detail::RecordHeader header = readHeader(detail::RecordKind::ARRAY, sizeof(Object));
+        skip(padding(detail::PAYLOAD_ALIGNMENT));
+        if (!header.count) return GrowingArray<Object>(arena);
+        Chunk* chunk = arena->getChunk(header.payload_size);
+        try {
+            readExact(chunk->begin(), header.payload_size);
+            chunk->advance(header.payload_size);
+            skip(padding(detail::RECORD_ALIGNMENT));
+        } catch (...) {
+            arena->releaseChunk(chunk);
+            throw;
+        }
+        return GrowingArray<Object>(arena, chunk);
+    }
+
+    /**
+     * @throw serialization_error If the next record is not a string.
+    */
+    String readString();
+
+    /**
+     * @return true if there are no more records in the stream.
+    */
+    bool eof();
+
+private:
+    detail::RecordHeader readHeader(detail::RecordKind kind, std::uint32_t element_size);
+    std::uint64_t        padding(std::uint64_t alignment) const noexcept;
+    void                 readExact(void* dst, std::uint64_t size);
+    void                 skip(std::uint64_t size);
+    std::uint64_t        readFile(void* dst, std::uint64_t size);
+
+    std::intptr_t                       m_file;
+    std::uint64_t                       m_offset = 0;
+    std::uint64_t                       m_buffer_pos = 0;
+    std::uint64_t                       m_buffer_size = 0;
+    std::unique_ptr<std::byte[]>        m_buffer;
+};
+
+} // namespace mylib
@@ -0,0 +1,202 @@
+#include "slab_allocator.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t THREAD_CACHE_ENTRIES{4u};
+constexpr std::uint64_t SLOT_ALIGNMENT{alignof(std::max_align_t)};
+
+// Maps (size + 7) / 8 to a size class index, so the lookup is a single load.
+constexpr auto SIZE_CLASS_LOOKUP = [] {
+    std::array<std::uint8_t, mylib::SlabAllocator::MAX_SLOT_SIZE/8 + 1> table{};
+    std::uint64_t index = 0;
+    for (std::uint64_t i = 0; i < table.size(); i++) {
+        while (mylib::SlabAllocator::SIZE_CLASSES[index] < i*8) index++;
+        table[i] = static_cast<std::uint8_t>(index);
+    }
+    return table;
+}();
+
+// Allocators are identified by a unique id rather than by address, so a thread cache entry
+// of a destroyed allocator can never be mistaken for a new allocator placed at the same address.
+std::atomic<std::uint64_t> g_next_id{1};
+std::mutex                 g_registry_mutex;
+std::vector<std::pair<std::uint64_t, mylib::SlabAllocator*>> g_registry;
+
+mylib::SlabAllocator* findAllocator(std::uint64_t id) noexcept {
+    for (auto& [allocator_id, allocator] : g_registry) {
+        if (allocator_id == id) return allocator;
+    }
+    return nullptr;
+}
+}
+
+namespace mylib
+{
+/**
+ * Per-thread magazines for a few allocators at once. When the thread exits,
+ * the slots are returned to the allocators which are still alive.
+*/
+struct SlabThreadCache {
+    struct Entry {
+        std::uint64_t           id = 0;
+        SlabAllocator::Magazine magazines[SlabAllocator::SIZE_CLASSES_COUNT]{};
+    };
+
+    ~SlabThreadCache() {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        for (auto& entry : entries) {
+            SlabAllocator* allocator = entry.id ? findAllocator(entry.id) : nullptr;
+            if (!allocator) continue;
+            for (std::uint64_t i = 0; i < SlabAllocator::SIZE_CLASSES_COUNT; i++) {
+                allocator->flush(i, entry.magazines[i], 0);
+            }
+        }
+    }
+
+    std::array<Entry, THREAD_CACHE_ENTRIES> entries;
+};
+
+namespace
+{
+thread_local SlabThreadCache t_cache;
+}
+
+SlabAllocator::SlabAllocator(Arena* arena, std::uint64_t slab_size)
+: m_arena(arena), m_slab_size(slab_size), m_id(g_next_id.fetch_add(1, std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    g_registry.emplace_back(m_id, this);
+}
+
+SlabAllocator::~SlabAllocator() {
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        auto itr = std::find_if(g_registry.begin(), g_registry.end(), [this](const auto& pair) { return pair.first == m_id; });
+        if (itr != g_registry.end()) g_registry.erase(itr);
+    }
+    for (auto& entry : t_cache.entries) {
+        if (entry.id == m_id) entry = SlabThreadCache::Entry{};
+    }
+
+    // NOTE: Slabs are linked into an intrusive list through their first bytes.
+    Chunk* slab = m_slabs.load(std::memory_order_acquire);
+    while (slab) {
+        Chunk* prev = *reinterpret_cast<Chunk**>(slab->begin());
+        m_arena->releaseChunk(slab);
+        slab = prev;
+    }
+}
+
+std::uint64_t SlabAllocator::sizeClassIndex(std::size_t size) noexcept {
+    if (size > MAX_SLOT_SIZE) return SIZE_CLASSES_COUNT;
+    return SIZE_CLASS_LOOKUP[(size + 7) / 8];
+}
+
+void* SlabAllocator::allocate(std::size_t size) {
+    const std::uint64_t index = sizeClassIndex(size);
+    if (index == SIZE_CLASSES_COUNT)
+        throw std::length_error(fmt::format("size {} exceeds the largest size class {}", size, MAX_SLOT_SIZE));
+
+    Magazine* thread_magazines = magazines();
+    if (!thread_magazines) {
+        // All the thread cache entries are taken by other allocators, take a single slot from the depot.
+        Magazine magazine{};
+        refill(index, magazine);
+        void* slot = magazine.slots[--magazine.count];
+        flush(index, magazine, 0);
+        return slot;
+    }
+
+    Magazine& magazine = thread_magazines[index];
+    if (!magazine.count) {
+        refill(index, magazine);
+    }
+    return magazine.slots[--magazine.count];
+}
+
+void SlabAllocator::deallocate(void* ptr, std::size_t size) noexcept {
+    const std::uint64_t index = sizeClassIndex(size);
+    if (!ptr || (index == SIZE_CLASSES_COUNT)) return;
+
+    Magazine* thread_magazines = magazines();
+    if (!thread_magazines) {
+        Magazine magazine{};
+        magazine.slots[magazine.count++] = ptr;
+        flush(index, magazine, 0);
+        return;
+    }
+
+    Magazine& magazine = thread_magazines[index];
+    if (magazine.count == MAGAZINE_SIZE) {
+        flush(index, magazine, MAGAZINE_SIZE / 2);
+    }
+    magazine.slots[magazine.count++] = ptr;
+}
+
+SlabAllocator::Magazine* SlabAllocator::magazines() noexcept {
+    for (auto& entry : t_cache.entries) {
+        if (entry.id == m_id) return entry.magazines;
+    }
+
+    // Slow path, claim an empty entry or the one owned by an already destroyed allocator.
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (auto& entry : t_cache.entries) {
+        if (!entry.id || !findAllocator(entry.id)) {
+            entry = SlabThreadCache::Entry{};
+            entry.id = m_id;
+            return entry.magazines;
+        }
+    }
+    return nullptr;
+}
+
+void SlabAllocator::refill(std::uint64_t index, Magazine& magazine) {
+    Depot& depot = m_depots[index];
+    const std::uint64_t slot_size = SIZE_CLASSES[index];
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    while (magazine.count < MAGAZINE_SIZE / 2) {
+        if (depot.free_list) {
+            FreeNode* node = depot.free_list;
+            depot.free_list = node->next;
+            magazine.slots[magazine.count++] = node;
+            continue;
+        }
+        if (depot.carve_pos + slot_size > depot.carve_end) {
+            newSlab(depot);
+        }
+        magazine.slots[magazine.count++] = depot.carve_pos;
+        depot.carve_pos += slot_size;
+    }
+}
+
+void SlabAllocator::flush(std::uint64_t index, Magazine& magazine, std::uint64_t keep) noexcept {
+    Depot& depot = m_depots[index];
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    while (magazine.count > keep) {
+        auto* node = static_cast<FreeNode*>(magazine.slots[--magazine.count]);
+        node->next = depot.free_list;
+        depot.free_list = node;
+    }
+}
+
+void SlabAllocator::newSlab(Depot& depot) {
+    // The remaining tail of the previous slab is abandoned, it's smaller than a single slot.
+    Chunk* slab = m_arena->getChunk(m_slab_size);
+    auto** link = reinterpret_cast<Chunk**>(slab->begin());
+    *link = m_slabs.load(std::memory_order_relaxed);
+    while (!m_slabs.compare_exchange_weak(*link, slab, std::memory_order_release, std::memory_order_relaxed)) {}
+    m_slabs_count.fetch_add(1, std::memory_order_relaxed);
+
+    auto start = reinterpret_cast<std::uintptr_t>(slab->begin() + sizeof(Chunk*));
+    start = (start + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1);
+    depot.carve_pos = reinterpret_cast<std::byte*>(start);
+    depot.carve_end = slab->begin() + slab->size();
+}
+
+} // namespace mylib
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "arena.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace mylib
+{
+/**
+ * Allocator for small objects which carves large arena chunks (slabs) into fixed-size slots.
+ * A separate chunk per object would cost at least one Arena::PAGE_SIZE page plus a chunk header,
+ * here a slot costs exactly its size class. Free slots are tracked with an intrusive free list per size class,
+ * and each thread keeps a small magazine of slots per size class, so the common allocate/deallocate path
+ * doesn't touch any locks. Magazines are refilled from and flushed to the shared free lists in batches.
+ * Deallocation has to be supplied with the same size the slot was allocated with.
+*/
+class SlabAllocator {
+public:
+    constexpr static std::uint64_t SLAB_SIZE{64u*1024u};
+    constexpr static std::uint64_t MAGAZINE_SIZE{32u};
+    constexpr static std::uint64_t MAX_SLOT_SIZE{512u};
+    constexpr static std::array<std::uint32_t, 12> SIZE_CLASSES{8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512};
+    constexpr static std::uint64_t SIZE_CLASSES_COUNT{SIZE_CLASSES.size()};
+
+    explicit SlabAllocator(Arena* arena, std::uint64_t slab_size=SLAB_SIZE);
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * @throw std::length_error If size exceeds MAX_SLOT_SIZE.
+     * @return A slot of the smallest size class that fits size, aligned by at most alignof(std::max_align_t).
+    */
+    void* allocate(std::size_t size);
+
+    /**
+     * Return a slot, size has to match the size passed to allocate.
+    */
+    void deallocate(void* ptr, std::size_t size) noexcept;
+
+    template<class T, class ...Args>
+    T* create(Args&&... args) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        void* ptr = allocate(sizeof(T));
+        try {
+            return new (ptr) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(ptr, sizeof(T));
+            throw;
+        }
+    }
+
+    template<class T>
+    void destroy(T* ptr) noexcept {
+        if (!ptr) return;
+        ptr->~T();
+        deallocate(ptr, sizeof(T));
+    }
+
+    /**
+     * @return Number of arena chunks taken by slabs.
+    */
+    std::uint64_t slabsCount() const noexcept { return m_slabs_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @return Index into SIZE_CLASSES, or SIZE_CLASSES_COUNT if size is too large.
+    */
+    static std::uint64_t sizeClassIndex(std::size_t size) noexcept;
+
+    struct Magazine {
+        std::uint64_t count;
+        void*         slots[MAGAZINE_SIZE];
+    };
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    // Shared per size class state, magazines are refilled from here.
+    struct alignas(64) Depot {
+        std::mutex mutex;
+        FreeNode*  free_list = nullptr;
+        std::byte* carve_pos = nullptr;
+        std::byte* carve_end = nullptr;
+    };
+
+    friend struct SlabThreadCache;
+
+    Magazine* magazines() noexcept;
+    void      refill(std::uint64_t index, Magazine& magazine);
+    void      flush(std::uint64_t index, Magazine& magazine, std::uint64_t keep) noexcept;
+    void      newSlab(Depot& depot);
+
+    Arena*                                      m_arena;
+    std::uint64_t                               m_slab_size;
+    std::uint64_t                               m_id;
+    std::atomic<Chunk*>                         m_slabs{nullptr};
+    std::atomic<std::uint64_t>                  m_slabs_count{0};
+    std::array<Depot, SIZE_CLASSES_COUNT>       m_depots;
+};
+
+} // namespace mylib
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "arena.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mylib
+{
+namespace detail
+{
+/**
+ * Raw storage for N objects inside the owning container, the objects are constructed by the container.
+*/
+template<class Object, std::size_t N>
+struct InlineStorage {
+    Object* data() noexcept { return reinterpret_cast<Object*>(m_bytes); }
+    const Object* data() const noexcept { return reinterpret_cast<const Object*>(m_bytes); }
+
+    alignas(Object) std::byte m_bytes[N*sizeof(Object)];
+};
+
+// Without inline capacity the container is just a pointer into an arena chunk.
+template<class Object>
+struct InlineStorage<Object, 0> {
+    Object* data() noexcept { return nullptr; }
+    const Object* data() const noexcept { return nullptr; }
+};
+} // namespace detail
+
+/**
+ * Array which keeps the first N elements inside the object, and only takes a chunk from the arena
+ * once it overflows. Arrays which never grow past N don't touch the arena at all, so temporary arrays
+ * built per request allocate nothing. The elements are always addressed through a single data pointer,
+ * which points either to the inline storage or to the chunk, thus the access and push paths
+ * don't branch on the storage kind. SmallArray<T, 0> has no inline storage and always uses the arena.
+ * NOTE: Unlike with GrowingArray, moving an array which is still inline moves the elements one by one,
+ * and the pointers to the elements are not preserved.
+*/
+template<class Object, std::size_t N>
+class SmallArray {
+public:
+    using value_type = Object;
+    using iterator = Object*;
+    using const_iterator = const Object*;
+
+    constexpr static std::size_t INLINE_CAPACITY{N};
+
+    explicit SmallArray(Arena* arena) noexcept
+    : m_arena(arena), m_size(0), m_cap(N) {
+        // NOTE: Set here rather than in the initializer list, m_inline is declared last,
+        // so the hot members stay at the front of the object.
+        m_data = m_inline.data();
+    }
+
+    ~SmallArray() noexcept { destroyAll(); releaseChunk(); }
+
+    SmallArray(const SmallArray& rhs)
+    : SmallArray(rhs.m_arena) { init(rhs); }
+
+    SmallArray& operator=(const SmallArray& rhs) {
+        if (this == &rhs) return *this;
+        clear();
+        init(rhs);
+        return *this;
+    }
+
+    SmallArray(SmallArray&& rhs) noexcept
+    : SmallArray(rhs.m_arena) { steal(rhs); }
+
+    SmallArray& operator=(SmallArray&& rhs) noexcept {
+        if (this == &rhs) return *this;
+        destroyAll();
+        releaseChunk();
+        m_arena = rhs.m_arena;
+        steal(rhs);
+        return *this;
+    }
+
+    /**
+     * @throw std::out_of_range If the index is not less than size().
+    */
+    Object& operator[](std::size_t index) { validateIndex(index); return m_data[index]; }
+    const Object& operator[](std::size_t index) const { validateIndex(index); return m_data[index]; }
+
+    void push_back(const Object& value) { emplace_back(value); }
+    void push_back(Object&& value) { emplace_back(std::move(value)); }
+
+    template<class ...Args>
+    Object& emplace_back(Args&&... args) {
+        if (m_size == m_cap) [[unlikely]] return emplaceSpill(std::forward<Args>(args)...);
+        Object* object = ::new (static_cast<void*>(m_data + m_size)) Object(std::forward<Args>(args)...);
+        m_size += 1;
+        return *object;
+    }
+
+    /**
+     * @throw std::out_of_range If the array is empty.
+    */
+    void pop_back() {
+        validateIndex(m_size - 1);
+        m_size -= 1;
+        std::destroy_at(m_data + m_size);
+    }
+
+    Object& front() { validateIndex(0); return m_data[0]; }
+    const Object& front() const { validateIndex(0); return m_data[0]; }
+    Object& back() { validateIndex(m_size - 1); return m_data[m_size - 1]; }
+    const Object& back() const { validateIndex(m_size - 1); return m_data[m_size - 1]; }
+
+    /**
+     * Make sure the array can hold at least new_cap elements, spilling into an arena chunk if it doesn't fit inline.
+     * @return true if the elements were moved to a new chunk.
+    */
+    bool reserve(std::size_t new_cap) {
+        if (new_cap <= m_cap) return false;
+        spill(new_cap);
+        return true;
+    }
+
+    Object*       data() noexcept { return m_data; }
+    const Object* data() const noexcept { return m_data; }
+
+    std::size_t size() const noexcept { return m_size; }
+    std::size_t capacity() const noexcept { return m_cap; }
+    bool        empty() const noexcept { return m_size == 0; }
+
+    /**
+     * @return true while the elements are stored inside the object.
+    */
+    bool isInline() const noexcept { return m_chunk == nullptr; }
+
+    /**
+     * Destroy the elements, the chunk is kept if the array has already spilled.
+    */
+    void clear() noexcept { destroyAll(); }
+
+    iterator       begin() noexcept { return m_data; }
+    iterator       end() noexcept { return m_data + m_size; }
+    const_iterator begin() const noexcept { return m_data; }
+    const_iterator end() const noexcept { return m_data + m_size; }
+
+private:
+    // Out of the hot path, so the inlined push is just a compare and a construct.
+    // The new element is constructed before the old ones are relocated, since the arguments may refer to them.
+    template<class ...Args>
+    Object& emplaceSpill(Args&&... args) {
+        Chunk* chunk = newChunk(m_cap ? m_cap*2 : 1);
+        Object* object = nullptr;
+        try {
+            object = ::new (static_cast<void*>(reinterpret_cast<Object*>(chunk->begin()) + m_size)) Object(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            m_arena->releaseChunk(chunk);
+            throw;
+        }
+        adopt(chunk);
+        m_size += 1;
+        return *object;
+    }
+
+    void spill(std::size_t new_cap) { adopt(newChunk(new_cap)); }
+
+    Chunk* newChunk(std::size_t new_cap) {
+        Chunk* chunk = m_arena->getChunk(sizeof(Object)*new_cap);
+        // NOTE: The whole chunk is marked as used, so the arena clears everything the elements might have touched.
+        chunk->advance(chunk->size());
+        return chunk;
+    }
+
+    void adopt(Chunk* chunk) noexcept {
+        Object* data = reinterpret_cast<Object*>(chunk->begin());
+        relocate(m_data, m_size, data);
+        releaseChunk();
+        m_chunk = chunk;
+        m_data = data;
+        m_cap = chunk->size() / sizeof(Object);
+    }
+
+    static void relocate(Object* from, std::size_t count, Object* to) noexcept {
+        if constexpr (std::is_trivially_copyable_v<Object>) {
+            if (count) std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count*sizeof(Object));
+        } else {
+            std::uninitialized_move_n(from, count, to);
+            std::destroy_n(from, count);
+        }
+    }
+
+    void steal(SmallArray& rhs) noexcept {
+        if (rhs.m_chunk) {
+            m_chunk = rhs.m_chunk; m_data = rhs.m_data; m_cap = rhs.m_cap;
+            rhs.m_chunk = nullptr; rhs.m_data = rhs.m_inline.data(); rhs.m_cap = N;
+        } else {
+            relocate(rhs.m_data, rhs.m_size, m_data);
+        }
+        m_size = rhs.m_size;
+        rhs.m_size = 0;
+    }
+
+    void init(const SmallArray& rhs) {
+        reserve(rhs.m_size);
+        std::uninitialized_copy_n(rhs.m_data, rhs.m_size, m_data);
+        m_size = rhs.m_size;
+    }
+
+    void destroyAll() noexcept {
+        std::destroy_n(m_data, m_size);
+        m_size = 0;
+    }
+
+    void releaseChunk() noexcept {
+        if (m_chunk) m_arena->releaseChunk(m_chunk);
+        m_chunk = nullptr;
+        m_data = m_inline.data();
+        m_cap = N;
+    }
+
+    void validateIndex(std::size_t index) const {
+        if (index >= m_size)
+            throw std::out_of_range(fmt::format("index {} is out of range", index));
+    }
+
+    Arena*                               m_arena;
+    Object*                              m_data;
+    std::size_t                          m_size;
+    std::size_t                          m_cap;
+    Chunk*                               m_chunk = nullptr;
+    detail::InlineStorage<Object, N>     m_inline;
+};
+
+} // namespace mylib
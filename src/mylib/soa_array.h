@@ -0,0 +1,223 @@
+#pragma once
+
+#include "arena.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mylib
+{
+/**
+ * Structure-of-arrays container. Every field is stored in its own arena chunk,
+ * so a loop which touches only a couple of fields streams through contiguous memory
+ * of exactly those fields. All the columns share the same size and capacity and grow together.
+ * Columns are relocated with memcpy when growing, thus all the fields have to be trivially copyable.
+*/
+template<class ...Fields>
+class SoAArray {
+    static_assert(sizeof...(Fields) > 0, "at least one field is required");
+    static_assert((std::is_trivially_copyable_v<Fields> && ...), "fields have to be trivially copyable");
+
+public:
+    constexpr static std::size_t COLUMNS_COUNT{sizeof...(Fields)};
+    constexpr static std::size_t INITIAL_CAPACITY{64u};
+
+    template<std::size_t I>
+    using column_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    using row_type = std::tuple<Fields&...>;
+    using const_row_type = std::tuple<const Fields&...>;
+
+    /**
+     * Zip-style iterator over rows, dereferencing yields a tuple of references into each column.
+    */
+    class iterator;
+
+    explicit SoAArray(Arena* arena) noexcept
+    : m_arena(arena), m_columns{}, m_size(0), m_cap(0) {}
+
+    ~SoAArray() noexcept { releaseColumns(); }
+
+    SoAArray(const SoAArray& rhs)
+    : m_arena(rhs.m_arena), m_columns{}, m_size(0), m_cap(0) { init(rhs); }
+
+    SoAArray& operator=(const SoAArray& rhs) {
+        if (this == &rhs) return *this;
+        releaseColumns();
+        m_arena = rhs.m_arena;
+        init(rhs);
+        return *this;
+    }
+
+    SoAArray(SoAArray&& rhs) noexcept
+    : m_arena(rhs.m_arena), m_columns(rhs.m_columns), m_size(rhs.m_size), m_cap(rhs.m_cap) {
+        rhs.m_columns = {}; rhs.m_size = rhs.m_cap = 0;
+    }
+
+    SoAArray& operator=(SoAArray&& rhs) noexcept {
+        if (this == &rhs) return *this;
+        releaseColumns();
+        m_arena = rhs.m_arena; m_columns = rhs.m_columns; m_size = rhs.m_size; m_cap = rhs.m_cap;
+        rhs.m_columns = {}; rhs.m_size = rhs.m_cap = 0;
+        return *this;
+    }
+
+    /**
+     * Make sure that every column can hold at least new_cap elements.
+     * Columns are moved to larger chunks all at once, so they always have the same capacity.
+     * @param new_cap Requested capacity in elements.
+     * @return true if the columns were reallocated.
+    */
+    bool grow(std::uint64_t new_cap) {
+        if (new_cap <= m_cap) return false;
+        growColumns(new_cap, std::index_sequence_for<Fields...>{});
+        return true;
+    }
+
+    /**
+     * Append a row, every value goes into its own column.
+    */
+    void push_back(const Fields&... values) {
+        if (m_size == m_cap) grow(m_cap ? m_cap*2 : INITIAL_CAPACITY);
+        pushColumns(std::index_sequence_for<Fields...>{}, values...);
+        m_size += 1;
+    }
+
+    /**
+     * @throw std::out_of_range If the array is empty.
+    */
+    void pop_back() {
+        validateIndex(m_size - 1);
+        popColumns(std::index_sequence_for<Fields...>{});
+        m_size -= 1;
+    }
+
+    /**
+     * @return A tuple of references to the fields of a row at the given index.
+    */
+    row_type operator[](std::size_t index) { validateIndex(index); return rowAt(index, std::index_sequence_for<Fields...>{}); }
+
+    const_row_type operator[](std::size_t index) const { validateIndex(index); return rowAt(index, std::index_sequence_for<Fields...>{}); }
+
+    /**
+     * @return A contiguous view over all the values of the I-th field.
+    */
+    template<std::size_t I>
+    std::span<column_type<I>> column() noexcept { return {data<I>(), m_size}; }
+
+    template<std::size_t I>
+    std::span<const column_type<I>> column() const noexcept { return {data<I>(), m_size}; }
+
+    std::size_t size() const noexcept { return m_size; }
+
+    std::size_t capacity() const noexcept { return m_cap; }
+
+    bool empty() const noexcept { return m_size == 0; }
+
+    /**
+     * Drop all the rows, the columns keep their chunks.
+    */
+    void clear() noexcept {
+        for (auto* chunk : m_columns)
+            if (chunk) chunk->reset();
+        m_size = 0;
+    }
+
+    iterator begin() noexcept { return iterator(this, 0); }
+
+    iterator end() noexcept { return iterator(this, m_size); }
+
+private:
+    template<std::size_t I>
+    column_type<I>* data() const noexcept {
+        if (!m_columns[I]) return nullptr;
+        return reinterpret_cast<column_type<I>*>(m_columns[I]->begin());
+    }
+
+    template<std::size_t ...I>
+    row_type rowAt(std::size_t index, std::index_sequence<I...>) noexcept { return row_type(data<I>()[index]...); }
+
+    template<std::size_t ...I>
+    const_row_type rowAt(std::size_t index, std::index_sequence<I...>) const noexcept { return const_row_type(data<I>()[index]...); }
+
+    template<std::size_t ...I>
+    void growColumns(std::uint64_t new_cap, std::index_sequence<I...>) {
+        std::uint64_t cap = new_cap;
+        ((cap = std::min<std::uint64_t>(cap, growColumn<I>(new_cap))), ...);
+        m_cap = cap;
+    }
+
+    // Returns the amount of elements the new column chunk can hold, which might be
+    // larger than requested since chunk sizes are aligned by the arena page size.
+    template<std::size_t I>
+    std::uint64_t growColumn(std::uint64_t new_cap) {
+        Chunk* chunk = m_arena->getChunk(sizeof(column_type<I>)*new_cap, m_columns[I]);
+        m_columns[I] = chunk;
+        return chunk->size() / sizeof(column_type<I>);
+    }
+
+    template<std::size_t ...I>
+    void pushColumns(std::index_sequence<I...>, const Fields&... values) { (m_columns[I]->push(values), ...); }
+
+    template<std::size_t ...I>
+    void popColumns(std::index_sequence<I...>) { (m_columns[I]->pop(sizeof(column_type<I>)), ...); }
+
+    void validateIndex(std::size_t index) const {
+        if (index >= m_size)
+            throw std::out_of_range(fmt::format("index {} is out of range", index));
+    }
+
+    void init(const SoAArray& rhs) {
+        if (!rhs.m_cap) return;
+        for (std::size_t i = 0; i < COLUMNS_COUNT; i++) {
+            m_columns[i] = m_arena->getChunk(rhs.m_columns[i]->size());
+            m_columns[i]->copy(rhs.m_columns[i]);
+        }
+        m_size = rhs.m_size;
+        m_cap = rhs.m_cap;
+    }
+
+    void releaseColumns() noexcept {
+        for (auto*& chunk : m_columns) {
+            if (chunk) m_arena->releaseChunk(chunk);
+            chunk = nullptr;
+        }
+        m_size = m_cap = 0;
+    }
+
+    Arena*                             m_arena;
+    std::array<Chunk*, COLUMNS_COUNT>  m_columns;
+    std::size_t                        m_size;
+    std::size_t                        m_cap;
+};
+
+template<class ...Fields>
+class SoAArray<Fields...>::iterator {
+public:
+    iterator() : m_array(nullptr), m_index(0) {}
+
+    row_type operator*() const             { return (*m_array)[m_index]; }
+    iterator& operator++()                 { m_index++; return *this; }
+    iterator operator++(int /*postfix*/)   { iterator old_this = *this; ++(*this); return old_this; }
+    iterator& operator--()                 { m_index--; return *this; }
+    iterator operator--(int /*postfix*/)   { iterator old_this = *this; --(*this); return old_this; }
+
+    bool operator==(const iterator& rhs) const noexcept { return (m_array == rhs.m_array) && (m_index == rhs.m_index); }
+    bool operator!=(const iterator& rhs) const noexcept { return !(*this == rhs); }
+
+private:
+    friend class SoAArray<Fields...>;
+
+    iterator(SoAArray* array, std::size_t index)
+    : m_array(array), m_index(index) {}
+
+    SoAArray*   m_array;
+    std::size_t m_index;
+};
+
+} // namespace mylib
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "arena.h"
+#include "growing_array.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <latch>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mylib
+{
+namespace detail
+{
+template<std::size_t SIZE> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<1> { using type = std::uint8_t; };
+template<> struct UnsignedOfSize<2> { using type = std::uint16_t; };
+template<> struct UnsignedOfSize<4> { using type = std::uint32_t; };
+template<> struct UnsignedOfSize<8> { using type = std::uint64_t; };
+
+/**
+ * Map an arithmetic value to an unsigned integer with the same order, so it can be sorted byte by byte.
+ * Signed integers get the sign bit flipped. Negative floats get all the bits flipped, positive ones just the sign bit,
+ * thus -0.0 goes before 0.0, and NaNs go to the ends depending on their sign bit.
+*/
+template<class T>
+auto radixKey(T value) noexcept {
+    using U = typename UnsignedOfSize<sizeof(T)>::type;
+    constexpr U SIGN_BIT = U(1) << (sizeof(U)*8 - 1);
+    if constexpr (std::is_floating_point_v<T>) {
+        const U bits = std::bit_cast<U>(value);
+        return static_cast<U>(bits ^ ((bits & SIGN_BIT) ? U(~U(0)) : SIGN_BIT));
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<U>(std::bit_cast<U>(value) ^ SIGN_BIT);
+    } else {
+        return static_cast<U>(value);
+    }
+}
+
+/**
+ * Selects the radix sort at compile time: arithmetic values are sorted by themselves,
+ * pairs with an arithmetic first member, e.g. key-index pairs, are sorted by the first member.
+ * The passes copy the objects to raw scratch memory and through uninitialized buffers, so they have to be
+ * trivially copyable and default constructible. std::pair never is trivially copyable, since its assignment
+ * is user-provided, thus its members are checked instead. Anything else takes the comparison sort.
+*/
+template<class Object>
+struct RadixTraits {
+    constexpr static bool ENABLED = false;
+};
+
+// Wider types, e.g. long double or __int128, have no UnsignedOfSize and take the comparison sort.
+template<class T>
+concept RadixKey = std::is_arithmetic_v<T> && (sizeof(T) <= sizeof(std::uint64_t));
+
+template<class T>
+    requires RadixKey<T>
+struct RadixTraits<T> {
+    constexpr static bool ENABLED = true;
+    static auto key(const T& value) noexcept { return radixKey(value); }
+};
+
+template<class Key, class Value>
+    requires RadixKey<Key>
+struct RadixTraits<std::pair<Key, Value>> {
+    constexpr static bool ENABLED = std::is_trivially_copyable_v<Value> && std::is_default_constructible_v<Value>;
+    static auto key(const std::pair<Key, Value>& value) noexcept { return radixKey(value.first); }
+};
+
+constexpr std::size_t RADIX_BITS{8u};
+constexpr std::size_t RADIX_BUCKETS{1u << RADIX_BITS};
+
+template<class Object>
+using RadixHistogram = std::array<std::array<std::size_t, RADIX_BUCKETS>, sizeof(decltype(RadixTraits<Object>::key(std::declval<Object>())))>;
+
+template<class Object>
+std::size_t digitOf(const Object& object, std::size_t digit) noexcept {
+    return static_cast<std::size_t>(RadixTraits<Object>::key(object) >> (digit*RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+template<class Object>
+void countDigits(const Object* data, std::size_t count, RadixHistogram<Object>& histogram) noexcept {
+    for (std::size_t i = 0; i < count; i++) {
+        const auto key = RadixTraits<Object>::key(data[i]);
+        for (std::size_t digit = 0; digit < histogram.size(); digit++) {
+            histogram[digit][static_cast<std::size_t>(key >> (digit*RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+}
+
+// Below this size the passes over the histograms cost more than a comparison sort.
+constexpr std::size_t RADIX_SORT_THRESHOLD{256u};
+
+// Per thread, smaller arrays are not worth waking the threads up.
+constexpr std::size_t PARALLEL_SORT_THRESHOLD{1u << 16};
+
+/**
+ * Move the objects in [begin, end) to their buckets, offsets point to the next free slot of every bucket.
+ * Objects are collected into a cache line per bucket first and written out a line at a time,
+ * so the 256 output streams don't evict each other and miss the TLB on every object.
+*/
+template<class Object>
+void scatter(const Object* from, std::size_t begin, std::size_t end, Object* to,
+             std::array<std::size_t, RADIX_BUCKETS>& offsets, std::size_t digit) noexcept {
+    constexpr std::size_t LINE_OBJECTS = std::max<std::size_t>(1u, 64u / sizeof(Object));
+    struct alignas(64) Line {
+        Object objects[LINE_OBJECTS];
+    };
+    std::array<Line, RADIX_BUCKETS> lines;
+    std::array<std::uint8_t, RADIX_BUCKETS> filled{};
+
+    for (std::size_t i = begin; i < end; i++) {
+        const std::size_t bucket = digitOf(from[i], digit);
+        lines[bucket].objects[filled[bucket]++] = from[i];
+        if (filled[bucket] == LINE_OBJECTS) {
+            std::copy_n(lines[bucket].objects, LINE_OBJECTS, to + offsets[bucket]);
+            offsets[bucket] += LINE_OBJECTS;
+            filled[bucket] = 0;
+        }
+    }
+    for (std::size_t bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+        std::copy_n(lines[bucket].objects, filled[bucket], to + offsets[bucket]);
+        offsets[bucket] += filled[bucket];
+    }
+}
+
+template<class Object>
+void comparisonSort(Object* data, std::size_t count) {
+    std::stable_sort(data, data + count, [](const Object& lhs, const Object& rhs) {
+        return RadixTraits<Object>::key(lhs) < RadixTraits<Object>::key(rhs);
+    });
+}
+
+/**
+ * LSD radix sort of count objects, one pass per byte of the key. The histograms of all the bytes are collected
+ * in a single pass up front, and the bytes which are the same in every key are skipped.
+ * @return The buffer holding the sorted objects, either data or scratch.
+*/
+template<class Object>
+Object* radixSort(Object* data, Object* scratch, std::size_t count) noexcept {
+    RadixHistogram<Object> histogram{};
+    countDigits(data, count, histogram);
+
+    Object* from = data;
+    Object* to = scratch;
+    for (std::size_t digit = 0; digit < histogram.size(); digit++) {
+        auto& buckets = histogram[digit];
+        if (buckets[digitOf(from[0], digit)] == count) continue;
+
+        std::size_t offset = 0;
+        for (auto& bucket : buckets) {
+            offset += std::exchange(bucket, offset);
+        }
+        scatter(from, 0, count, to, buckets, digit);
+        std::swap(from, to);
+    }
+    return from;
+}
+
+/**
+ * The same passes split between threads. Every thread counts the digits of its part of the array,
+ * then computes where its objects go from the counts of all the threads, which keeps the sort stable.
+*/
+template<class Object>
+Object* parallelRadixSort(Object* data, Object* scratch, std::size_t count, std::size_t threads_count) {
+    constexpr std::size_t DIGITS = std::tuple_size_v<RadixHistogram<Object>>;
+    std::vector<std::array<std::size_t, RADIX_BUCKETS>> counts(threads_count);
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads_count));
+    std::latch start(1);
+    std::atomic<bool> aborted{false};
+    Object* result = data;
+
+    auto worker = [&](std::size_t thread) {
+        // NOTE: Nobody touches the array until all the threads are running, so failing to start one leaves it intact.
+        start.wait();
+        if (aborted.load(std::memory_order_relaxed)) return;
+        const std::size_t begin = count*thread / threads_count;
+        const std::size_t end = count*(thread + 1) / threads_count;
+        Object* from = data;
+        Object* to = scratch;
+        std::array<std::size_t, RADIX_BUCKETS> offsets;
+        for (std::size_t digit = 0; digit < DIGITS; digit++) {
+            auto& own = counts[thread];
+            own.fill(0);
+            for (std::size_t i = begin; i < end; i++) {
+                own[digitOf(from[i], digit)]++;
+            }
+            sync.arrive_and_wait();
+
+            // Objects with a smaller digit go first, then the same digit from the preceding threads.
+            std::size_t offset = 0;
+            bool trivial = false;
+            for (std::size_t bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+                std::size_t total = 0;
+                for (std::size_t t = 0; t < threads_count; t++) {
+                    if (t == thread) offsets[bucket] = offset + total;
+                    total += counts[t][bucket];
+                }
+                trivial = trivial || (total == count);
+                offset += total;
+            }
+            sync.arrive_and_wait();
+            if (trivial) continue;
+
+            scatter(from, begin, end, to, offsets, digit);
+            std::swap(from, to);
+            sync.arrive_and_wait();
+        }
+        if (thread == 0) result = from;
+    };
+
+    std::vector<std::jthread> threads;
+    try {
+        threads.reserve(threads_count - 1);
+        for (std::size_t thread = 1; thread < threads_count; thread++) {
+            threads.emplace_back(worker, thread);
+        }
+    } catch (...) {
+        aborted.store(true, std::memory_order_relaxed);
+        start.count_down();
+        throw;
+    }
+    start.count_down();
+    worker(0);
+    threads.clear();
+    return result;
+}
+
+template<class Object, class F>
+void sortWithScratch(GrowingArray<Object>& arr, F&& sort) {
+    Object* data = arr.data();
+    const std::size_t count = arr.size();
+    Chunk* chunk = arr.arena()->getChunk(sizeof(Object)*count);
+    try {
+        Object* sorted = sort(data, reinterpret_cast<Object*>(chunk->begin()), count);
+        if (sorted != data) std::copy(sorted, sorted + count, data);
+    } catch (...) {
+        arr.arena()->releaseChunk(chunk);
+        throw;
+    }
+    arr.arena()->releaseChunk(chunk);
+}
+} // namespace detail
+
+/**
+ * Sort the elements in ascending order. Arrays of arithmetic values, and of pairs with an arithmetic first member
+ * and a trivially copyable second one, are radix sorted with scratch space of the same size taken from the array's arena,
+ * which is stable and O(n) with up to sizeof(key) passes over the elements.
+ * Any other element type is sorted with std::sort.
+*/
+template<class Object>
+void sort(GrowingArray<Object>& arr) {
+    if constexpr (detail::RadixTraits<Object>::ENABLED) {
+        if (arr.size() < detail::RADIX_SORT_THRESHOLD) {
+            detail::comparisonSort(arr.data(), arr.size());
+            return;
+        }
+        detail::sortWithScratch(arr, [](Object* data, Object* scratch, std::size_t count) {
+            return detail::radixSort(data, scratch, count);
+        });
+    } else {
+        std::sort(arr.data(), arr.data() + arr.size());
+    }
+}
+
+/**
+ * Sort the elements with a custom comparison, always a comparison sort.
+*/
+template<class Object, class Compare>
+void sort(GrowingArray<Object>& arr, Compare comp) {
+    std::sort(arr.data(), arr.data() + arr.size(), comp);
+}
+
+/**
+ * The same as sort, but the radix passes are split between the given number of threads,
+ * the calling thread is one of them. Small arrays and other element types are sorted on the calling thread.
+ * @throw std::system_error If a thread cannot be started.
+*/
+template<class Object>
+void parallel_sort(GrowingArray<Object>& arr, std::size_t threads_count=std::thread::hardware_concurrency()) {
+    if constexpr (detail::RadixTraits<Object>::ENABLED) {
+        threads_count = std::min(threads_count, arr.size() / detail::PARALLEL_SORT_THRESHOLD);
+        if (threads_count < 2) {
+            sort(arr);
+            return;
+        }
+        detail::sortWithScratch(arr, [threads_count](Object* data, Object* scratch, std::size_t count) {
+            return detail::parallelRadixSort(data, scratch, count, threads_count);
+        });
+    } else {
+        sort(arr);
+    }
+}
+
+} // namespace mylib
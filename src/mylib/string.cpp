@@ -1,5 +1,25 @@
 #include "string.h"
+#include <atomic>
 #include <cstring>
+#include <new>
+
+namespace
+{
+// Precedes the characters of a shared string in its chunk.
+struct SharedHeader {
+    std::atomic<std::uint32_t> refs;
+};
+
+SharedHeader* sharedHeader(mylib::Chunk* chunk) noexcept {
+    return std::launder(reinterpret_cast<SharedHeader*>(chunk->begin()));
+}
+
+void releaseSharedChunk(mylib::Arena* arena, mylib::Chunk* chunk) noexcept {
+    // The last owner has to see all the writes made by the other owners before it releases the chunk.
+    if (sharedHeader(chunk)->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        arena->releaseChunk(chunk);
+}
+}
 
 namespace mylib
 {
@@ -18,16 +38,76 @@ String::String(const char *str) {
     m_size = size;
 }
 
-String::~String() { delete[]m_data; }  
+String::String(StringView src)
+: m_size(src.size()) {
+    m_data = new char[m_size + 1]{};
+    memcpy(m_data, src.data(), m_size);
+    m_data[m_size] = 0;
+}
+
+String::String(std::initializer_list<const char *> list)
+: m_size(0) {
+    for (const char* str : list)
+        m_size += std::strlen(str);
+    m_data = new char[m_size + 1]{};
+    size_t pos = 0;
+    for (const char* str : list) {
+        size_t size = std::strlen(str);
+        memcpy(m_data + pos, str, size);
+        pos += size;
+    }
+    m_data[m_size] = 0;
+}
+
+String::String(size_t count, char ch)
+: m_size(count) {
+    m_data = new char[m_size + 1]{};
+    memset(m_data, ch, m_size);
+    m_data[m_size] = 0;
+}
+
+String::String(Arena* arena, StringView src)
+: m_size(0) {
+    initShared(arena, src, StringView());
+}
+
+String::~String() {
+    if (m_memory) releaseShared();
+    else delete[]m_data;
+}
 
 String::String(const String& rhs)
 : m_size(rhs.m_size) {
+    if (rhs.m_memory) {
+        // Shared, no copy.
+        m_arena = rhs.m_arena;
+        m_memory = rhs.m_memory;
+        m_data = rhs.m_data;
+        sharedHeader(m_memory)->refs.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     m_data = new char[m_size + 1]{};
     memcpy(m_data, rhs.m_data, m_size + 1);
 }
 
 String& String::operator=(const String& rhs) {
     if (this == &rhs) return *this;
+    if (rhs.m_memory) {
+        sharedHeader(rhs.m_memory)->refs.fetch_add(1, std::memory_order_relaxed);
+        if (m_memory) releaseShared();
+        else delete[]m_data;
+        m_arena = rhs.m_arena;
+        m_memory = rhs.m_memory;
+        m_data = rhs.m_data;
+        m_size = rhs.m_size;
+        return *this;
+    }
+    if (m_memory) {
+        releaseShared();
+        m_memory = nullptr;
+        m_arena = nullptr;
+        m_data = nullptr;
+    }
     char *tmp = m_data;
     m_size = rhs.m_size;
     m_data = new char[m_size + 1]{};
@@ -37,25 +117,59 @@ String& String::operator=(const String& rhs) {
 }
 
 String::String(String&& rhs)
-: m_size(rhs.m_size), m_data(rhs.m_data)
+: m_arena(rhs.m_arena), m_memory(rhs.m_memory), m_data(rhs.m_data), m_size(rhs.m_size)
 { rhs.zeroMembers(); }
 
 String& String::operator=(String&& rhs) {
     if (this == &rhs) return *this;
-    char* tmp = m_data;
+    if (m_memory) releaseShared();
+    else delete []m_data;
+    m_arena = rhs.m_arena;
+    m_memory = rhs.m_memory;
     m_data = rhs.m_data;
     m_size = rhs.m_size;
     rhs.zeroMembers();
-    delete []tmp;
     return *this;
 }
 
 void String::zeroMembers()
-{ m_data = nullptr; m_size =  0; }
+{ m_arena = nullptr; m_memory = nullptr; m_data = nullptr; m_size =  0; }
+
+std::uint32_t String::useCount() const noexcept {
+    return m_memory ? sharedHeader(m_memory)->refs.load(std::memory_order_relaxed) : 1;
+}
+
+void String::initShared(Arena* arena, StringView first, StringView second) {
+    const size_t size = first.size() + second.size();
+    Chunk* chunk = arena->getChunk(sizeof(SharedHeader) + size + 1);
+    new (chunk->begin()) SharedHeader{1};
+    char* data = reinterpret_cast<char*>(chunk->begin() + sizeof(SharedHeader));
+    memcpy(data, first.data(), first.size());
+    memcpy(data + first.size(), second.data(), second.size());
+    data[size] = 0;
+    m_size = size;
+    m_arena = arena;
+    m_memory = chunk;
+    m_data = data;
+}
+
+void String::releaseShared() noexcept {
+    releaseSharedChunk(m_arena, m_memory);
+}
+
+void String::detach() {
+    // A single owner can modify the buffer in place.
+    if (!m_memory || (sharedHeader(m_memory)->refs.load(std::memory_order_acquire) == 1)) return;
+    Chunk* shared = m_memory;
+    initShared(m_arena, StringView(m_data, m_size), StringView());
+    releaseSharedChunk(m_arena, shared);
+}
 
 bool String::operator==(const String& str) {
     if (this->m_size != str.m_size)
         return false;
+    if (m_data == str.m_data)
+        return true;
     for (size_t i = 0; i < m_size; i++)
         if (m_data[i] != str.m_data[i])
             return false;
@@ -65,6 +179,25 @@ bool String::operator==(const String& str) {
 bool String::operator!=(const String& str)
 { return !(*this == str); }
 
+String& String::operator+=(const String& str) {
+    if (m_memory) {
+        // Always detaches, since the concatenation needs a larger chunk anyway.
+        Chunk* shared = m_memory;
+        initShared(m_arena, view(), str.view());
+        releaseSharedChunk(m_arena, shared);
+        return *this;
+    }
+    size_t size = m_size + str.m_size;
+    char *data = new char[size + 1]{};
+    if (m_data) memcpy(data, m_data, m_size);
+    if (str.m_data) memcpy(data + m_size, str.m_data, str.m_size);
+    data[size] = 0;
+    delete []m_data;
+    m_data = data;
+    m_size = size;
+    return *this;
+}
+
 String operator+(const String& a, const String& b) {
     // TODO: Pull out this operation into a function
     size_t size = a.m_size + b.m_size;
@@ -88,6 +221,12 @@ String operator+(const char *a, const String& b) {
     return std::move(res);
 }
 
+String operator+(const String& a, const char *b) {
+    String res(a);
+    res += String(b);
+    return res;
+}
+
 std::ostream& operator<<(std::ostream& os, const String& rhs) {
     os << rhs.m_data;
     return os;
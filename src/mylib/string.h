@@ -1,15 +1,35 @@
 #pragma once
 
 #include "arena.h"
+#include "string_view.h"
 #include <ostream>
 #include <initializer_list>
 
 namespace mylib
 {
+/**
+ * By default a string owns a private heap buffer, and copies are deep.
+ * Strings constructed with an arena use a shared representation instead: the characters are stored
+ * in an arena chunk together with an atomic reference count, copies share the chunk in O(1),
+ * and a string is detached into a chunk of its own before it's modified (copy-on-write).
+ * A chunk costs at least Arena::PAGE_SIZE, so the shared representation pays off for long strings,
+ * or strings which are copied many times, e.g. the same labels stored in many containers.
+*/
 class String {
 public:
     explicit String(const char *src);
     explicit String(const std::string& src);
+    explicit String(StringView src);
+    String(size_t count, char ch);
+
+    /**
+     * Shared representation, see the class description.
+    */
+    String(Arena* arena, StringView src);
+
+    /**
+     * Concatenation of all the strings in the list.
+    */
     String(std::initializer_list<const char *> list);
     ~String();
 
@@ -19,6 +39,26 @@ public:
     String& operator=(String&& rhs);
 
     size_t size() const { return m_size; }
+    const char* data() const { return m_data; }
+
+    /**
+     * Detaches a shared string, since the characters may be modified through the pointer.
+     * NOTE: The pointer must not be written through after the string is copied.
+    */
+    char* data() { detach(); return m_data; }
+
+    bool isShared() const noexcept { return m_memory != nullptr; }
+
+    /**
+     * @return Number of strings sharing the buffer, 1 for a string with a private buffer.
+    */
+    std::uint32_t useCount() const noexcept;
+
+    /**
+     * Non-owning view of the characters, valid until the string is modified or destroyed.
+    */
+    StringView view() const noexcept { return m_data ? StringView(m_data, m_size) : StringView(); }
+    operator StringView() const noexcept { return view(); }
 
     bool operator==(const String& str);
     bool operator!=(const String& str);
@@ -31,10 +71,13 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const String& rhs); 
 private:
     void zeroMembers();
+    void initShared(Arena* arena, StringView first, StringView second);
+    void releaseShared() noexcept;
+    void detach();
 
-    Arena* m_arena;
-    Chunk* m_memory;
-    char *m_data{nullptr}; // remove
+    Arena* m_arena{nullptr};
+    Chunk* m_memory{nullptr}; // Shared buffer, nullptr if the string owns a heap buffer.
+    char *m_data{nullptr};
     size_t m_size; 
 };
 
@@ -0,0 +1,140 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+constexpr std::uint64_t ENTRY_ALIGNMENT{alignof(mylib::detail::InternedEntry)};
+constexpr std::uint64_t LINK_SIZE{sizeof(mylib::Chunk*)};
+
+std::uint64_t alignUp(std::uint64_t size) noexcept {
+    return (size + ENTRY_ALIGNMENT - 1) & ~(ENTRY_ALIGNMENT - 1);
+}
+}
+
+namespace mylib
+{
+StringPool::StringPool(Arena* arena, std::uint64_t chunk_size)
+: m_arena(arena), m_chunk_size(chunk_size) {
+    m_table.store(newTable(INITIAL_CAPACITY), std::memory_order_relaxed);
+}
+
+StringPool::~StringPool() {
+    Table* table = m_table.load(std::memory_order_relaxed);
+    while (table) {
+        Table* prev = table->prev;
+        m_arena->releaseChunk(table->chunk);
+        table = prev;
+    }
+    while (m_chunks) {
+        Chunk* prev = *reinterpret_cast<Chunk**>(m_chunks->begin());
+        m_arena->releaseChunk(m_chunks);
+        m_chunks = prev;
+    }
+}
+
+std::uint64_t StringPool::hash(std::string_view str) noexcept {
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+InternedString StringPool::intern(std::string_view str) {
+    const std::uint64_t str_hash = hash(str);
+    // Fast path, the string is already interned.
+    if (const detail::InternedEntry* entry = lookup(m_table.load(std::memory_order_acquire), str, str_hash))
+        return InternedString(entry);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Another thread could intern the same string while this one was waiting for the lock.
+    if (const detail::InternedEntry* entry = lookup(m_table.load(std::memory_order_relaxed), str, str_hash))
+        return InternedString(entry);
+
+    // Keep the load factor at most a half, so the probe sequences stay short.
+    const std::uint64_t size = m_size.load(std::memory_order_relaxed);
+    if ((size + 1)*2 > m_table.load(std::memory_order_relaxed)->capacity) {
+        grow();
+    }
+    const detail::InternedEntry* entry = store(str, str_hash);
+    insert(m_table.load(std::memory_order_relaxed), entry);
+    m_size.store(size + 1, std::memory_order_relaxed);
+    return InternedString(entry);
+}
+
+InternedString StringPool::find(std::string_view str) const noexcept {
+    return InternedString(lookup(m_table.load(std::memory_order_acquire), str, hash(str)));
+}
+
+std::uint64_t StringPool::memoryUsage() const noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_storage_bytes + m_index_bytes;
+}
+
+const detail::InternedEntry* StringPool::lookup(const Table* table, std::string_view str, std::uint64_t hash) const noexcept {
+    const std::uint64_t mask = table->capacity - 1;
+    for (std::uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        const detail::InternedEntry* entry = table->slots[i].load(std::memory_order_acquire);
+        if (!entry) return nullptr;
+        // Comparing the hashes first rejects nearly all the collisions without touching the bytes.
+        if ((entry->hash == hash) && (entry->size == str.size()) && !std::memcmp(entry->data(), str.data(), str.size()))
+            return entry;
+    }
+}
+
+const detail::InternedEntry* StringPool::store(std::string_view str, std::uint64_t hash) {
+    const std::uint64_t size = alignUp(sizeof(detail::InternedEntry) + str.size() + 1);
+    if (!m_chunks || (m_chunks->remainingSpace() < size)) {
+        // The tail of the previous chunk is abandoned, strings larger than a chunk get a chunk of their own.
+        Chunk* chunk = m_arena->getChunk(std::max(m_chunk_size, LINK_SIZE + size));
+        chunk->push<Chunk*>(m_chunks);
+        m_chunks = chunk;
+        m_storage_bytes += chunk->size();
+    }
+    auto* entry = new (m_chunks->end()) detail::InternedEntry{hash, str.size()};
+    char* data = reinterpret_cast<char*>(entry + 1);
+    std::memcpy(data, str.data(), str.size());
+    data[str.size()] = 0;
+    m_chunks->advance(size);
+    return entry;
+}
+
+void StringPool::insert(Table* table, const detail::InternedEntry* entry) noexcept {
+    const std::uint64_t mask = table->capacity - 1;
+    std::uint64_t i = entry->hash & mask;
+    while (table->slots[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & mask;
+    }
+    // Publishes the entry's bytes together with the pointer.
+    table->slots[i].store(entry, std::memory_order_release);
+}
+
+StringPool::Table* StringPool::newTable(std::uint64_t capacity) {
+    const std::uint64_t size = sizeof(Table) + (capacity - 1)*sizeof(Table::slots[0]);
+    Chunk* chunk = m_arena->getChunk(size);
+    auto* table = new (chunk->begin()) Table{chunk, nullptr, capacity, {}};
+    for (std::uint64_t i = 1; i < capacity; i++) {
+        new (&table->slots[i]) std::atomic<const detail::InternedEntry*>(nullptr);
+    }
+    m_index_bytes += chunk->size();
+    return table;
+}
+
+void StringPool::grow() {
+    Table* table = m_table.load(std::memory_order_relaxed);
+    Table* grown = newTable(table->capacity*2);
+    for (std::uint64_t i = 0; i < table->capacity; i++) {
+        if (const detail::InternedEntry* entry = table->slots[i].load(std::memory_order_relaxed))
+            insert(grown, entry);
+    }
+    grown->prev = table;
+    // Readers which still probe the old table find every string interned before the switch.
+    m_table.store(grown, std::memory_order_release);
+}
+
+} // namespace mylib
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "arena.h"
+#include "string.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+
+namespace mylib
+{
+namespace detail
+{
+/**
+ * A string stored in a pool, the bytes follow the header and are null-terminated.
+*/
+struct InternedEntry {
+    std::uint64_t hash;
+    std::uint64_t size;
+
+    const char* data() const noexcept { return reinterpret_cast<const char*>(this + 1); }
+};
+} // namespace detail
+
+/**
+ * Handle to a string stored in a StringPool. Equal strings interned into the same pool share the entry,
+ * thus comparison is a single pointer comparison. Handles are trivially copyable, and stay valid while the pool is alive.
+ * Comparing handles from different pools is meaningless.
+*/
+class InternedString {
+public:
+    InternedString() noexcept = default;
+
+    const char*      data() const noexcept { return m_entry ? m_entry->data() : ""; }
+    const char*      c_str() const noexcept { return data(); }
+    std::size_t      size() const noexcept { return m_entry ? m_entry->size : 0; }
+    bool             empty() const noexcept { return size() == 0; }
+    std::uint64_t    hash() const noexcept { return m_entry ? m_entry->hash : 0; }
+    std::string_view view() const noexcept { return std::string_view(data(), size()); }
+
+    bool operator==(const InternedString& rhs) const noexcept { return m_entry == rhs.m_entry; }
+
+    friend std::ostream& operator<<(std::ostream& os, const InternedString& rhs) { return os << rhs.view(); }
+
+private:
+    friend class StringPool;
+
+    explicit InternedString(const detail::InternedEntry* entry) noexcept
+    : m_entry(entry) {}
+
+    const detail::InternedEntry* m_entry = nullptr;
+};
+
+/**
+ * Set of unique strings. The bytes of all the strings are packed into arena chunks,
+ * and an open-addressing hash index over them provides deduplication.
+ * Lookups of strings which are already interned don't take any locks, they probe the index with acquire loads.
+ * Inserting a new string takes a mutex, and the index is grown by publishing a new table.
+ * Old tables are kept until the pool is destroyed, since a concurrent reader may still probe them,
+ * they take less memory than the last table all together.
+*/
+class StringPool {
+public:
+    constexpr static std::uint64_t DEFAULT_CHUNK_SIZE{64u*1024u};
+    constexpr static std::uint64_t INITIAL_CAPACITY{1024u};
+
+    explicit StringPool(Arena* arena, std::uint64_t chunk_size=DEFAULT_CHUNK_SIZE);
+    ~StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * Thread-safe.
+     * @return Handle to the pool's copy of str, a copy is made only on the first call with this content.
+    */
+    InternedString intern(std::string_view str);
+    InternedString intern(const String& str) { return intern(std::string_view(str.data(), str.size())); }
+
+    /**
+     * Thread-safe and lock-free.
+     * @return Handle to the pool's copy of str, or an empty handle if str was never interned.
+    */
+    InternedString find(std::string_view str) const noexcept;
+
+    /**
+     * @return Number of unique strings.
+    */
+    std::uint64_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+
+    /**
+     * @return Number of bytes taken from the arena for the strings and the index.
+    */
+    std::uint64_t memoryUsage() const noexcept;
+
+    static std::uint64_t hash(std::string_view str) noexcept;
+
+private:
+    // NOTE: Allocated in a chunk of its own, slots extend past the end of the struct.
+    struct Table {
+        Chunk*                                    chunk;
+        Table*                                    prev; // Retired tables, released with the pool.
+        std::uint64_t                             capacity;
+        std::atomic<const detail::InternedEntry*> slots[1];
+    };
+
+    const detail::InternedEntry* lookup(const Table* table, std::string_view str, std::uint64_t hash) const noexcept;
+    const detail::InternedEntry* store(std::string_view str, std::uint64_t hash);
+    void                         insert(Table* table, const detail::InternedEntry* entry) noexcept;
+    Table*                       newTable(std::uint64_t capacity);
+    void                         grow();
+
+    Arena*               m_arena;
+    std::uint64_t        m_chunk_size;
+    std::atomic<Table*>  m_table{nullptr};
+    std::atomic<std::uint64_t> m_size{0};
+
+    // Guarded by m_mutex.
+    mutable std::mutex   m_mutex;
+    Chunk*               m_chunks = nullptr; // Linked through their first bytes.
+    std::uint64_t        m_storage_bytes = 0;
+    std::uint64_t        m_index_bytes = 0;
+};
+
+} // namespace mylib
+
+template<>
+struct std::hash<mylib::InternedString> {
+    std::size_t operator()(const mylib::InternedString& str) const noexcept {
+        return static_cast<std::size_t>(str.hash());
+    }
+};
@@ -0,0 +1,118 @@
+#include "string_view.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+#endif
+
+namespace
+{
+using size_type = mylib::StringView::size_type;
+
+std::array<bool, 256> makeTable(mylib::StringView delimiters) noexcept {
+    std::array<bool, 256> table{};
+    for (char c : delimiters) {
+        table[static_cast<unsigned char>(c)] = true;
+    }
+    return table;
+}
+
+size_type findAnyScalar(const char* data, size_type size, size_type pos, const std::array<bool, 256>& table) noexcept {
+    for (; pos < size; pos++) {
+        if (table[static_cast<unsigned char>(data[pos])]) return pos;
+    }
+    return mylib::StringView::npos;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+size_type findAnySimd(const char* data, size_type size, size_type pos, mylib::StringView delimiters) noexcept {
+    __m128i needles[mylib::StringView::MAX_SIMD_DELIMITERS];
+    for (size_type i = 0; i < delimiters.size(); i++) {
+        needles[i] = _mm_set1_epi8(delimiters[i]);
+    }
+    for (; pos + 16 <= size; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i matches = _mm_cmpeq_epi8(block, needles[0]);
+        for (size_type i = 1; i < delimiters.size(); i++) {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, needles[i]));
+        }
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+        if (mask) return pos + static_cast<size_type>(std::countr_zero(mask));
+    }
+    for (; pos < size; pos++) {
+        for (char delimiter : delimiters) {
+            if (data[pos] == delimiter) return pos;
+        }
+    }
+    return mylib::StringView::npos;
+}
+#endif
+}
+
+namespace mylib
+{
+StringView::size_type StringView::find(char ch, size_type pos) const noexcept {
+    if (pos >= m_size) return npos;
+    const void* match = std::memchr(m_data + pos, ch, m_size - pos);
+    return match ? static_cast<size_type>(static_cast<const char*>(match) - m_data) : npos;
+}
+
+StringView::size_type StringView::find(StringView str, size_type pos) const noexcept {
+    if (str.empty()) return (pos <= m_size) ? pos : npos;
+    // Look for the first character with memchr, and compare the rest only there.
+    while ((pos < m_size) && (m_size - pos >= str.m_size)) {
+        pos = find(str.m_data[0], pos);
+        if ((pos == npos) || (m_size - pos < str.m_size)) return npos;
+        if (!std::memcmp(m_data + pos, str.m_data, str.m_size)) return pos;
+        pos += 1;
+    }
+    return npos;
+}
+
+StringView::size_type StringView::find_first_of(StringView delimiters, size_type pos) const noexcept {
+    if ((pos >= m_size) || delimiters.empty()) return npos;
+    if (delimiters.size() == 1) return find(delimiters[0], pos);
+#if defined(__SSE2__) || defined(_M_X64)
+    if (delimiters.size() <= MAX_SIMD_DELIMITERS) return findAnySimd(m_data, m_size, pos, delimiters);
+#endif
+    return findAnyScalar(m_data, m_size, pos, makeTable(delimiters));
+}
+
+StringView::size_type StringView::find_first_not_of(StringView delimiters, size_type pos) const noexcept {
+    const std::array<bool, 256> table = makeTable(delimiters);
+    for (; pos < m_size; pos++) {
+        if (!table[static_cast<unsigned char>(m_data[pos])]) return pos;
+    }
+    return npos;
+}
+
+void SplitRange::iterator::advance() noexcept {
+    if (!m_next) {
+        m_done = true;
+        return;
+    }
+    StringView rest(m_next, static_cast<size_type>(m_end - m_next));
+    if (m_skip_empty) {
+        const size_type start = rest.find_first_not_of(m_delimiters);
+        if (start == StringView::npos) {
+            m_done = true;
+            return;
+        }
+        rest.remove_prefix(start);
+    }
+
+    const size_type length = rest.find_first_of(m_delimiters);
+    if (length == StringView::npos) {
+        m_token = rest;
+        m_next = nullptr;
+    }
+    else {
+        m_token = StringView(rest.data(), length);
+        m_next = rest.data() + length + 1;
+    }
+}
+
+} // namespace mylib
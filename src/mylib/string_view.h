@@ -0,0 +1,176 @@
+#pragma once
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace mylib
+{
+/**
+ * Non-owning view of a contiguous sequence of characters, the referenced buffer has to outlive the view.
+ * The bytes are not necessarily null-terminated.
+*/
+class StringView {
+public:
+    using size_type = std::size_t;
+    using const_iterator = const char*;
+
+    constexpr static size_type npos{static_cast<size_type>(-1)};
+
+    constexpr StringView() noexcept = default;
+    constexpr StringView(const char* data, size_type size) noexcept
+    : m_data(data), m_size(size) {}
+
+    StringView(const char* str) noexcept
+    : m_data(str), m_size(std::strlen(str)) {}
+
+    StringView(const std::string& str) noexcept
+    : m_data(str.data()), m_size(str.size()) {}
+
+    constexpr StringView(std::string_view str) noexcept
+    : m_data(str.data()), m_size(str.size()) {}
+
+    constexpr operator std::string_view() const noexcept { return std::string_view(m_data, m_size); }
+
+    constexpr const char*    data() const noexcept { return m_data; }
+    constexpr size_type      size() const noexcept { return m_size; }
+    constexpr bool           empty() const noexcept { return m_size == 0; }
+    constexpr const_iterator begin() const noexcept { return m_data; }
+    constexpr const_iterator end() const noexcept { return m_data + m_size; }
+    constexpr char           operator[](size_type index) const noexcept { return m_data[index]; }
+
+    /**
+     * @throw std::out_of_range If pos is greater than size().
+     * @return View of at most count characters starting at pos.
+    */
+    StringView substr(size_type pos, size_type count=npos) const {
+        if (pos > m_size)
+            throw std::out_of_range(fmt::format("position {} is out of range, size {}", pos, m_size));
+        return StringView(m_data + pos, std::min(count, m_size - pos));
+    }
+
+    constexpr void remove_prefix(size_type count) noexcept { m_data += count; m_size -= count; }
+    constexpr void remove_suffix(size_type count) noexcept { m_size -= count; }
+
+    bool starts_with(StringView prefix) const noexcept {
+        return (m_size >= prefix.m_size) && !std::memcmp(m_data, prefix.m_data, prefix.m_size);
+    }
+
+    bool ends_with(StringView suffix) const noexcept {
+        return (m_size >= suffix.m_size) && !std::memcmp(m_data + m_size - suffix.m_size, suffix.m_data, suffix.m_size);
+    }
+
+    /**
+     * @return Position of the first occurrence at or after pos, or npos.
+    */
+    size_type find(char ch, size_type pos=0) const noexcept;
+    size_type find(StringView str, size_type pos=0) const noexcept;
+
+    /**
+     * Find the first character which is any of the delimiters. Up to MAX_SIMD_DELIMITERS delimiters
+     * are matched 16 bytes at a time with SSE2, larger sets fall back to a table lookup per character.
+     * @return Position of the first match at or after pos, or npos.
+    */
+    size_type find_first_of(StringView delimiters, size_type pos=0) const noexcept;
+
+    /**
+     * @return Position of the first character at or after pos which is none of the delimiters, or npos.
+    */
+    size_type find_first_not_of(StringView delimiters, size_type pos=0) const noexcept;
+
+    constexpr static size_type MAX_SIMD_DELIMITERS{4u};
+
+    friend bool operator==(StringView lhs, StringView rhs) noexcept {
+        return (lhs.m_size == rhs.m_size) && !std::memcmp(lhs.m_data, rhs.m_data, lhs.m_size);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, StringView rhs) {
+        return os.write(rhs.m_data, static_cast<std::streamsize>(rhs.m_size));
+    }
+
+private:
+    const char* m_data = "";
+    size_type   m_size = 0;
+};
+
+/**
+ * Lazy sequence of views into the source buffer, separated by any of the delimiters.
+ * Nothing is allocated or copied, the source buffer has to outlive the range.
+*/
+class SplitRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StringView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StringView*;
+        using reference = const StringView&;
+
+        iterator() noexcept = default;
+
+        reference operator*() const noexcept { return m_token; }
+        pointer   operator->() const noexcept { return &m_token; }
+
+        iterator& operator++() noexcept { advance(); return *this; }
+        iterator  operator++(int) noexcept { iterator tmp = *this; advance(); return tmp; }
+
+        bool operator==(const iterator& rhs) const noexcept {
+            if (m_done || rhs.m_done) return m_done == rhs.m_done;
+            return (m_token.data() == rhs.m_token.data()) && (m_token.size() == rhs.m_token.size());
+        }
+
+    private:
+        friend class SplitRange;
+
+        // NOTE: Everything is copied from the range, so the iterators stay valid after the range is gone.
+        iterator(const SplitRange& range) noexcept
+        : m_next(range.m_source.data()), m_end(range.m_source.end()), m_delimiters(range.m_delimiters),
+          m_skip_empty(range.m_skip_empty), m_done(false) { advance(); }
+
+        void advance() noexcept;
+
+        const char* m_next = nullptr; // Start of the remaining input, nullptr after the last field.
+        const char* m_end = nullptr;
+        StringView  m_delimiters;
+        StringView  m_token;
+        bool        m_skip_empty = false;
+        bool        m_done = true;
+    };
+
+    SplitRange(StringView source, StringView delimiters, bool skip_empty) noexcept
+    : m_source(source), m_delimiters(delimiters), m_skip_empty(skip_empty) {}
+
+    iterator begin() const noexcept { return iterator(*this); }
+    iterator end() const noexcept { return iterator(); }
+
+private:
+    StringView m_source;
+    StringView m_delimiters;
+    bool       m_skip_empty;
+};
+
+/**
+ * Every field between delimiters, including the empty ones, e.g. "a,,b" yields "a", "" and "b",
+ * and an empty string yields a single empty field. Suits CSV-like input.
+ * NOTE: The delimiters are referenced, not copied, so they have to outlive the range as well.
+*/
+inline SplitRange split(StringView str, StringView delimiters) noexcept {
+    return SplitRange(str, delimiters, false);
+}
+
+/**
+ * Non-empty runs of characters between delimiters, e.g. "  GET   /index " yields "GET" and "/index".
+ * Suits whitespace separated input such as log lines.
+*/
+inline SplitRange tokenize(StringView str, StringView delimiters=" \t\r\n") noexcept {
+    return SplitRange(str, delimiters, true);
+}
+
+} // namespace mylib
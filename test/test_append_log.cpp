@@ -0,0 +1,139 @@
+#include <mylib/append_log.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct Sample {
+    std::uint64_t index;
+    std::uint64_t checksum;
+};
+}
+
+class AppendLogFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t m_arena_size{1024u*1024u};
+    constexpr static std::uint64_t m_segment_size{1024u};
+    mylib::Arena m_arena{m_arena_size};
+};
+
+TEST_F(AppendLogFixture, PushAndSnapshot) {
+    mylib::AppendLog<std::uint64_t> log(&m_arena, m_segment_size);
+    ASSERT_TRUE(log.snapshot().empty());
+
+    const std::uint64_t count = log.segmentCapacity()*3 + 5;
+    for (std::uint64_t i = 0; i < count; i++) {
+        log.push(i);
+    }
+    auto snapshot = log.snapshot();
+    ASSERT_EQ(snapshot.size(), count);
+    ASSERT_EQ(log.size(), count);
+
+    // Elements pushed after the snapshot was taken are not a part of it.
+    log.push(count);
+    ASSERT_EQ(snapshot.size(), count);
+    ASSERT_EQ(log.snapshot().size(), count + 1);
+
+    std::uint64_t expected = 0;
+    for (std::uint64_t value : snapshot) {
+        ASSERT_EQ(value, expected++);
+    }
+    ASSERT_EQ(expected, count);
+    ASSERT_EQ(snapshot.at(log.segmentCapacity()*2 + 1), log.segmentCapacity()*2 + 1);
+    ASSERT_THROW(snapshot.at(count), std::out_of_range);
+}
+
+TEST_F(AppendLogFixture, AppendBatch) {
+    mylib::AppendLog<std::uint32_t> log(&m_arena, m_segment_size);
+    std::vector<std::uint32_t> values(log.segmentCapacity()*2);
+    std::iota(values.begin(), values.end(), 0u);
+    log.append(values);
+
+    auto snapshot = log.snapshot();
+    ASSERT_TRUE(std::equal(snapshot.begin(), snapshot.end(), values.begin(), values.end()));
+}
+
+TEST_F(AppendLogFixture, DiscardReclaimsSegments) {
+    mylib::AppendLog<std::uint64_t> log(&m_arena, m_segment_size);
+    const std::uint64_t capacity = log.segmentCapacity();
+    for (std::uint64_t i = 0; i < capacity*4; i++) {
+        log.push(i);
+    }
+    const std::uint64_t chunks = m_arena.totalChunks() - m_arena.emptyChunksCount();
+
+    {
+        // The snapshot sees the first segments, so they can't be reclaimed while it's alive.
+        auto snapshot = log.snapshot();
+        log.discard(capacity*2 + 1);
+        ASSERT_EQ(log.retiredCount(), 2);
+        ASSERT_EQ(log.beginIndex(), capacity*2 + 1);
+        ASSERT_EQ(snapshot.beginIndex(), 0);
+        ASSERT_EQ(*snapshot.begin(), 0);
+        ASSERT_EQ(snapshot.at(capacity), capacity);
+
+        auto later = log.snapshot();
+        ASSERT_EQ(later.beginIndex(), capacity*2 + 1);
+        ASSERT_EQ(*later.begin(), capacity*2 + 1);
+        ASSERT_EQ(later.size(), capacity*2 - 1);
+        ASSERT_EQ(log.reclaim(), 0);
+    }
+
+    ASSERT_EQ(log.reclaim(), 2);
+    ASSERT_EQ(log.retiredCount(), 0);
+    ASSERT_EQ(m_arena.totalChunks() - m_arena.emptyChunksCount(), chunks - 2);
+
+    // The segment being written to is never retired.
+    log.discard(capacity*10);
+    ASSERT_EQ(log.beginIndex(), capacity*4);
+    ASSERT_TRUE(log.snapshot().empty());
+    ASSERT_EQ(log.retiredCount(), 0);
+}
+
+TEST_F(AppendLogFixture, ConcurrentReaders) {
+    mylib::AppendLog<Sample> log(&m_arena, m_segment_size);
+    constexpr std::uint64_t samples_count{200000u};
+    constexpr std::uint64_t window{1000u};
+    std::atomic<bool> done{false};
+
+    auto read = [&log, &done]() {
+        std::uint64_t last_end = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            auto snapshot = log.snapshot();
+            ASSERT_GE(snapshot.endIndex(), last_end);
+            last_end = snapshot.endIndex();
+            std::uint64_t expected = snapshot.beginIndex();
+            for (const Sample& sample : snapshot) {
+                ASSERT_EQ(sample.index, expected);
+                ASSERT_EQ(sample.checksum, ~expected);
+                expected += 1;
+            }
+            ASSERT_EQ(expected, snapshot.endIndex());
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (std::uint32_t i = 0; i < 4; i++) {
+        readers.emplace_back(read);
+    }
+
+    // Keep only a sliding window of samples, so segments are retired and reused while readers iterate over them.
+    for (std::uint64_t i = 0; i < samples_count; i++) {
+        log.push(Sample{.index = i, .checksum = ~i});
+        if (i % window == 0) {
+            log.discard(i > window ? i - window : 0);
+        }
+    }
+    done.store(true, std::memory_order_release);
+    std::for_each(readers.begin(), readers.end(), std::mem_fn(&std::thread::join));
+
+    log.discard(samples_count);
+    log.reclaim();
+    ASSERT_EQ(log.retiredCount(), 0);
+    ASSERT_EQ(log.size(), samples_count);
+}
@@ -5,6 +5,11 @@
 #include <algorithm>
 #include <thread>
 #include <functional> // std::mem_fn
+#include <filesystem>
+#ifndef _WIN32
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
 
 class ArenaFixture : public ::testing::Test {
 protected:
@@ -202,4 +207,471 @@ TEST_F(ArenaDeathFixture, PopOnEmptyChunk) {
     mylib::Arena arena(m_small_arena_size);
     auto* chunk = arena.getChunk(chunk_size);
     ASSERT_THROW(chunk->pop(chunk_size / 2), std::length_error);
-}
\ No newline at end of file
+}
+
+TEST_F(ArenaFixture, PushForwardsLvaluesAndRvalues) {
+    mylib::Arena arena(m_small_arena_size);
+    auto* chunk = arena.getChunk(3*sizeof(std::uint64_t));
+    std::uint64_t value = 1;
+    const std::uint64_t const_value = 2;
+    chunk->push(value);
+    chunk->push(const_value);
+    chunk->push(std::uint64_t{3});
+    const auto* values = reinterpret_cast<const std::uint64_t*>(chunk->begin());
+    ASSERT_EQ(values[0], 1);
+    ASSERT_EQ(values[1], 2);
+    ASSERT_EQ(values[2], 3);
+    const auto* end = chunk->end();
+    ASSERT_THROW(chunk->advance(chunk->remainingSpace() + 1), std::length_error);
+    ASSERT_EQ(chunk->end(), end);
+    chunk->pop(sizeof(std::uint64_t));
+    ASSERT_EQ(chunk->end(), end - sizeof(std::uint64_t));
+    arena.releaseChunk(chunk);
+}
+
+class PersistentArenaFixture : public ArenaFixture {
+protected:
+    void SetUp() override {
+        m_path = std::filesystem::temp_directory_path() / 
+            fmt::format("mylib_{}.arena", ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove(m_path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_path);
+    }
+
+    std::filesystem::path m_path;
+};
+
+TEST_F(PersistentArenaFixture, ReopenSnapshot) {
+    constexpr std::uint64_t VALUES_COUNT = 100;
+    {
+        mylib::Arena arena(m_path, m_medium_arena_size);
+        ASSERT_TRUE(arena.isPersistent());
+        ASSERT_EQ(arena.root(0), nullptr);
+        auto* chunk = arena.getChunk(VALUES_COUNT*sizeof(std::uint64_t));
+        for (std::uint64_t i = 0; i < VALUES_COUNT; i++) {
+            chunk->push(i*3);
+        }
+        auto* free_chunk = arena.getChunk(mylib::Arena::PAGE_SIZE);
+        arena.releaseChunk(free_chunk);
+        arena.setRoot(0, chunk);
+    }
+    mylib::Arena arena(m_path);
+    ASSERT_EQ(arena.totalChunks(), 2);
+    ASSERT_EQ(arena.emptyChunksCount(), 1);
+    auto* chunk = arena.root(0);
+    ASSERT_NE(chunk, nullptr);
+    ASSERT_EQ(chunk->end() - chunk->begin(), VALUES_COUNT*sizeof(std::uint64_t));
+    auto* values = reinterpret_cast<std::uint64_t*>(chunk->begin());
+    for (std::uint64_t i = 0; i < VALUES_COUNT; i++) {
+        ASSERT_EQ(values[i], i*3);
+    }
+    ASSERT_THROW(arena.root(mylib::Arena::ROOTS_COUNT), std::out_of_range);
+}
+
+TEST_F(PersistentArenaFixture, DoesNotGrow) {
+    mylib::Arena arena(m_path, m_small_arena_size);
+    ASSERT_THROW(arena.getChunk(m_medium_arena_size), std::length_error);
+    ASSERT_EQ(arena.totalBlocks(), 1);
+}
+
+TEST_F(PersistentArenaFixture, RejectTruncatedFile) {
+    {
+        mylib::Arena arena(m_path, m_medium_arena_size);
+        arena.setRoot(0, arena.getChunk(mylib::Arena::PAGE_SIZE));
+    }
+    // Mapping the whole size of a partially copied file would fault on the first access past its end.
+    std::filesystem::resize_file(m_path, m_medium_arena_size / 2);
+    ASSERT_THROW(mylib::Arena arena(m_path), std::exception);
+}
+
+TEST_F(ArenaFixture, RootsRequirePersistentArena) {
+    mylib::Arena arena(m_small_arena_size);
+    ASSERT_FALSE(arena.isPersistent());
+    ASSERT_THROW(arena.root(0), std::logic_error);
+}
+
+#ifndef _WIN32
+TEST_F(PersistentArenaFixture, RelocateWhenBaseAddressIsTaken) {
+    void* base = nullptr;
+    {
+        mylib::Arena arena(m_path, m_medium_arena_size);
+        auto* chunk = arena.getChunk(mylib::Arena::PAGE_SIZE);
+        chunk->push(std::uint64_t{42});
+        arena.setRoot(1, chunk);
+        base = chunk->begin();
+    }
+    // Occupy the first page of the previous mapping, so the file has to be mapped somewhere else.
+    const std::uintptr_t os_page_size = sysconf(_SC_PAGESIZE);
+    void* mapping_start = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(base) & ~(os_page_size - 1));
+    void* blocker = mmap(mapping_start, os_page_size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+    ASSERT_EQ(blocker, mapping_start);
+    {
+        mylib::Arena arena(m_path);
+        auto* chunk = arena.root(1);
+        ASSERT_NE(static_cast<void*>(chunk->begin()), base);
+        ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(chunk->begin()), 42);
+        auto* chunk2 = arena.getChunk(mylib::Arena::PAGE_SIZE);
+        ASSERT_EQ(arena.totalChunks(), 2);
+        arena.releaseChunk(chunk2);
+        ASSERT_EQ(arena.emptyChunksCount(), 1);
+    }
+    munmap(blocker, os_page_size);
+}
+#endif
+
+TEST_F(ArenaFixture, ChunkHandles) {
+    mylib::Arena arena(m_small_arena_size);
+    auto handle = arena.getChunkHandle(512);
+    ASSERT_TRUE(handle);
+    ASSERT_TRUE(handle.isValid());
+    handle->push(std::uint64_t{1});
+    ASSERT_EQ(handle.get()->end() - handle.get()->begin(), sizeof(std::uint64_t));
+    arena.releaseChunk(handle);
+    ASSERT_EQ(arena.emptyChunksCount(), 1);
+#ifdef MYLIB_ARENA_HARDENED
+    ASSERT_FALSE(handle.isValid());
+    ASSERT_THROW(handle.get(), mylib::stale_chunk_error);
+    ASSERT_THROW(arena.releaseChunk(handle), mylib::stale_chunk_error);
+    // The same chunk is handed out again, but the old handle stays stale.
+    auto new_handle = arena.getChunkHandle(512);
+    ASSERT_TRUE(new_handle.isValid());
+    ASSERT_FALSE(handle.isValid());
+#else
+    ASSERT_EQ(sizeof(mylib::ChunkHandle), sizeof(mylib::Chunk*));
+#endif
+}
+
+TEST_F(ArenaFixture, Quarantine) {
+    mylib::Arena arena(m_small_arena_size);
+    arena.setQuarantineSize(2);
+    auto* chunk1 = arena.getChunk(512);
+    auto* chunk2 = arena.getChunk(512);
+    auto* chunk3 = arena.getChunk(512);
+    arena.releaseChunk(chunk1);
+    arena.releaseChunk(chunk2);
+    ASSERT_EQ(arena.emptyChunksCount(), 0);
+    // Quarantined chunks are not reused.
+    auto* chunk4 = arena.getChunk(512);
+    ASSERT_NE(chunk4, chunk1);
+    ASSERT_NE(chunk4, chunk2);
+    // The oldest chunk leaves the quarantine once it's full.
+    arena.releaseChunk(chunk3);
+    ASSERT_EQ(arena.emptyChunksCount(), 1);
+    ASSERT_EQ(arena.getChunk(512), chunk1);
+    arena.setQuarantineSize(0);
+    ASSERT_EQ(arena.emptyChunksCount(), 2);
+}
+
+#ifdef MYLIB_ARENA_HARDENED
+TEST_F(ArenaDeathFixture, DetectWriteAfterRelease) {
+    mylib::Arena arena(m_small_arena_size);
+    auto* chunk = arena.getChunk(512);
+    auto* stale = chunk->begin();
+    arena.releaseChunk(chunk);
+    ASSERT_THROW(arena.releaseChunk(chunk), mylib::stale_chunk_error);
+    *stale = std::byte{1};
+    ASSERT_THROW(arena.getChunk(512), mylib::stale_chunk_error);
+    // The corrupted chunk is returned to the free list, poisoned again.
+    ASSERT_EQ(arena.emptyChunksCount(), 1);
+    ASSERT_EQ(arena.getChunk(512), chunk);
+
+    std::vector<mylib::Chunk*> chunks(2);
+    arena.getChunks(512, chunks.size(), chunks.data());
+    arena.releaseChunks(chunks);
+    *chunks[1]->begin() = std::byte{1};
+    ASSERT_THROW(arena.getChunks(512, chunks.size(), chunks.data()), mylib::stale_chunk_error);
+    ASSERT_EQ(arena.emptyChunksCount(), 2);
+}
+
+TEST_F(ArenaFixture, ReusedChunksAreCleared) {
+    mylib::Arena arena(m_small_arena_size);
+    auto* chunk = arena.getChunk(512);
+    chunk->push(std::uint64_t{0xffffffff});
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(512);
+    ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(chunk->begin()), 0);
+}
+#endif
+
+TEST_F(ArenaFixture, ClearPolicies) {
+    mylib::Arena arena(m_small_arena_size);
+    ASSERT_EQ(arena.clearPolicy(), mylib::ClearPolicy::CLEAR_ON_RELEASE);
+    arena.setClearPolicy(mylib::ClearPolicy::CLEAR_ON_ACQUIRE);
+    auto* chunk = arena.getChunk(512);
+    chunk->push(std::uint64_t{0xffffffff});
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(512);
+    ASSERT_EQ(chunk->end(), chunk->begin());
+    ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(chunk->begin()), 0);
+
+    // Clearing deferred by the release is still done by an acquisition with the default policy.
+    chunk->push(std::uint64_t{0xffffffff});
+    arena.releaseChunk(chunk, mylib::ClearPolicy::NO_CLEAR);
+    chunk = arena.getChunk(512, mylib::ClearPolicy::CLEAR_ON_RELEASE);
+    ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(chunk->begin()), 0);
+    arena.releaseChunk(chunk);
+}
+
+TEST_F(ArenaFixture, ClearAfterNoClearAcquisition) {
+    mylib::Arena arena(m_small_arena_size);
+    auto* chunk = arena.getChunk(512);
+    std::fill(chunk->begin(), chunk->begin() + chunk->size(), std::byte{0xab});
+    chunk->advance(chunk->size());
+    arena.releaseChunk(chunk, mylib::ClearPolicy::NO_CLEAR);
+    // The new owner uses less than the previous one, the rest still has to be cleared on the next release.
+    chunk = arena.getChunk(512, mylib::ClearPolicy::NO_CLEAR);
+    chunk->push(std::uint64_t{1});
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(512);
+    ASSERT_TRUE(std::all_of(chunk->begin(), chunk->begin() + chunk->size(), [](std::byte b) { return b == std::byte{0}; }));
+}
+
+#ifndef MYLIB_ARENA_HARDENED
+TEST_F(ArenaFixture, NoClearKeepsStaleData) {
+    mylib::Arena arena(m_small_arena_size);
+    arena.setClearPolicy(mylib::ClearPolicy::NO_CLEAR);
+    auto* chunk = arena.getChunk(512);
+    chunk->push(std::uint64_t{0xffffffff});
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(512);
+    ASSERT_EQ(chunk->end(), chunk->begin());
+    ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(chunk->begin()), 0xffffffff);
+}
+#endif
+
+TEST_F(ArenaFixture, ClearLargeChunks) {
+    const std::uint64_t size = mylib::Arena::NON_TEMPORAL_CLEAR_SIZE*2 + 100;
+    mylib::Arena arena(m_medium_arena_size*4);
+    auto* chunk = arena.getChunk(size);
+    std::fill(chunk->begin(), chunk->begin() + chunk->size(), std::byte{0xff});
+    chunk->advance(chunk->size() - 1);
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(size);
+    ASSERT_TRUE(std::all_of(chunk->begin(), chunk->begin() + chunk->size() - 1, [](std::byte b) { return b == std::byte{0}; }));
+#ifndef MYLIB_ARENA_HARDENED
+    // Only the used bytes are cleared.
+    ASSERT_EQ(chunk->begin()[chunk->size() - 1], std::byte{0xff});
+#endif
+}
+
+TEST_F(ArenaFixture, GetChunksBatch) {
+    constexpr std::uint64_t count = 128;
+    mylib::Arena arena(m_medium_arena_size);
+    std::vector<mylib::Chunk*> chunks(count);
+    arena.getChunks(512, count, chunks.data());
+    ASSERT_EQ(arena.totalChunks(), count);
+    for (std::uint64_t i = 0; i < count; i++) {
+        ASSERT_GE(chunks[i]->size(), 512);
+        ASSERT_TRUE(arena.contains(chunks[i]));
+        // Carved back to back.
+        if (i) {
+            ASSERT_EQ(reinterpret_cast<std::byte*>(chunks[i]) - reinterpret_cast<std::byte*>(chunks[i - 1]), 1024);
+        }
+    }
+
+    arena.releaseChunks(std::span(chunks).first(count / 2));
+    ASSERT_EQ(arena.emptyChunksCount(), count / 2);
+
+    // Free chunks are reused first, the rest doesn't fit into the first block.
+    std::vector<mylib::Chunk*> more(count * 8);
+    arena.getChunks(512, more.size(), more.data());
+    ASSERT_EQ(arena.emptyChunksCount(), 0);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    ASSERT_TRUE(std::is_permutation(more.begin(), more.begin() + count / 2, chunks.begin()));
+
+    arena.releaseChunks(std::span(chunks).last(count / 2));
+    arena.releaseChunks(more);
+    ASSERT_EQ(arena.emptyChunksCount(), arena.totalChunks());
+}
+
+TEST_F(PersistentArenaFixture, GetChunksIsAllOrNothing) {
+    mylib::Arena arena(m_path, m_small_arena_size*4);
+    arena.releaseChunk(arena.getChunk(512));
+    std::vector<mylib::Chunk*> chunks(64);
+    ASSERT_THROW(arena.getChunks(512, chunks.size(), chunks.data()), std::length_error);
+    ASSERT_EQ(arena.emptyChunksCount(), arena.totalChunks());
+}
+
+TEST_F(ArenaFixture, Reset) {
+    mylib::Arena arena(m_medium_arena_size);
+    auto handle = arena.getChunkHandle(512);
+    std::vector<mylib::Chunk*> chunks(64);
+    arena.getChunks(512, chunks.size(), chunks.data());
+    auto* first = handle.get();
+    for (auto* chunk : chunks) {
+        chunk->push(std::uint64_t{0xffffffff});
+    }
+    arena.releaseChunk(chunks.back());
+    arena.reset();
+    ASSERT_EQ(arena.totalChunks(), 0);
+    ASSERT_EQ(arena.emptyChunksCount(), 0);
+    ASSERT_EQ(arena.totalBlocks(), 1);
+    ASSERT_FALSE(arena.contains(first));
+#ifdef MYLIB_ARENA_HARDENED
+    ASSERT_FALSE(handle.isValid());
+#endif
+
+    // Chunks are carved from the beginning again, discarded data is cleared lazily.
+    auto* chunk = arena.getChunk(2048);
+    ASSERT_EQ(chunk, first);
+    ASSERT_TRUE(std::all_of(chunk->begin(), chunk->begin() + chunk->size(), [](std::byte b) { return b == std::byte{0}; }));
+}
+
+TEST_F(ArenaFixture, RetireEpoch) {
+    mylib::Arena arena(m_small_arena_size*4);
+    auto* long_lived = arena.getChunk(512);
+    ASSERT_EQ(arena.currentEpoch(), 0);
+
+    const auto epoch = arena.beginEpoch();
+    ASSERT_EQ(epoch, 1);
+    std::vector<mylib::Chunk*> chunks(8);
+    arena.getChunks(512, chunks.size(), chunks.data());
+    arena.releaseChunk(chunks.front());
+    ASSERT_EQ(arena.retireEpoch(epoch), chunks.size() - 1);
+    ASSERT_EQ(arena.emptyChunksCount(), chunks.size());
+    ASSERT_EQ(arena.retireEpoch(epoch), 0);
+
+    // The block only holds chunks of the retired epoch, so it's rewound.
+    const auto next_epoch = arena.beginEpoch();
+    arena.releaseChunk(long_lived);
+    arena.getChunks(512, chunks.size(), chunks.data());
+    ASSERT_EQ(arena.retireEpoch(next_epoch), chunks.size());
+    ASSERT_EQ(arena.totalChunks(), 0);
+}
+
+TEST_F(ArenaFixture, ReleasePointerIntoChunkData) {
+    mylib::Arena arena(m_small_arena_size);
+    auto* chunk = arena.getChunk(2048);
+    // Zeroed data looks like an in-use chunk header.
+    arena.releaseChunk(reinterpret_cast<mylib::Chunk*>(chunk->begin() + 64));
+    ASSERT_EQ(arena.emptyChunksCount(), 0);
+    // Page aligned within the block, where the next chunk's header would be.
+    arena.releaseChunk(reinterpret_cast<mylib::Chunk*>(chunk->begin() + mylib::Arena::PAGE_SIZE - mylib::Arena::CHUNK_HEADER_SIZE));
+    ASSERT_EQ(arena.emptyChunksCount(), 0);
+    ASSERT_EQ(arena.totalChunks(), 1);
+    arena.releaseChunk(chunk);
+    ASSERT_EQ(arena.emptyChunksCount(), 1);
+}
+
+TEST_F(PersistentArenaFixture, ResetClearsRoots) {
+    mylib::Arena arena(m_path, m_small_arena_size);
+    arena.setRoot(0, arena.getChunk(512));
+    arena.reset();
+    ASSERT_EQ(arena.root(0), nullptr);
+    ASSERT_EQ(arena.totalChunks(), 0);
+}
+
+TEST_F(ArenaFixture, Trim) {
+    mylib::Arena arena(m_small_arena_size);
+    const auto initial_size = arena.reservedSize();
+    auto* chunk = arena.getChunk(m_medium_arena_size);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    const auto reserved_size = arena.reservedSize();
+    arena.releaseChunk(chunk);
+    // Blocks are kept until trimmed explicitly by default.
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    ASSERT_EQ(arena.trim(), reserved_size - initial_size);
+    ASSERT_EQ(arena.totalBlocks(), 1);
+    ASSERT_EQ(arena.reservedSize(), initial_size);
+    ASSERT_EQ(arena.trim(), 0);
+}
+
+TEST_F(ArenaFixture, TrimPolicy) {
+    mylib::Arena arena(m_small_arena_size);
+    arena.setTrimPolicy(mylib::TrimPolicy{.retained_bytes = 0});
+    auto* chunk = arena.getChunk(m_medium_arena_size);
+    auto* quarantined = arena.getChunk(m_small_arena_size);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    arena.setQuarantineSize(1);
+    arena.releaseChunk(quarantined);
+    arena.releaseChunk(chunk);
+    // The block is kept alive by the quarantined chunk.
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    arena.setQuarantineSize(0);
+    arena.releaseChunk(nullptr);
+    ASSERT_EQ(arena.totalBlocks(), 1);
+
+    arena.setTrimPolicy(mylib::TrimPolicy{.grace_period = std::chrono::hours(1)});
+    arena.releaseChunk(arena.getChunk(m_medium_arena_size));
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    arena.setTrimPolicy(mylib::TrimPolicy{.grace_period = std::chrono::steady_clock::duration::zero()});
+    ASSERT_EQ(arena.totalBlocks(), 1);
+}
+
+TEST_F(ArenaFixture, MaxReservedSize) {
+    mylib::Arena arena(m_small_arena_size);
+    arena.setMaxReservedSize(m_medium_arena_size);
+    // The new block is shrunk to the remaining space instead of DEFAULT_ALLOC_SIZE.
+    auto* chunk = arena.getChunk(m_small_arena_size);
+    ASSERT_EQ(arena.reservedSize(), m_medium_arena_size);
+    ASSERT_THROW(arena.getChunk(m_medium_arena_size), std::length_error);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    // Empty blocks are trimmed to make room.
+    arena.releaseChunk(chunk);
+    chunk = arena.getChunk(m_medium_arena_size - 2*m_small_arena_size);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    ASSERT_LE(arena.reservedSize(), m_medium_arena_size);
+}
+
+TEST_F(ArenaFixture, GeometricGrowth) {
+    mylib::Arena arena(mylib::ArenaOptions{
+        .initial_size = m_small_arena_size, 
+        .block_size = m_small_arena_size*2,
+        .growth_factor = 2.0, 
+        .max_block_size = m_small_arena_size*4,
+    });
+    std::vector<mylib::Chunk*> chunks;
+    std::vector<std::uint64_t> reserved_sizes{arena.reservedSize()};
+    while (arena.totalBlocks() < 5) {
+        chunks.push_back(arena.getChunk(mylib::Arena::PAGE_SIZE));
+        if (reserved_sizes.size() < arena.totalBlocks())
+            reserved_sizes.push_back(arena.reservedSize());
+    }
+    std::vector<std::uint64_t> block_sizes;
+    for (std::uint64_t i = 1; i < reserved_sizes.size(); i++) {
+        block_sizes.push_back(reserved_sizes[i] - reserved_sizes[i - 1]);
+    }
+    // Doubles until it reaches the maximum block size.
+    // Memory blocks round their size up to PAGE_SIZE, including some bookkeeping.
+    ASSERT_GT(block_sizes[0], 2*m_small_arena_size);
+    ASSERT_LE(block_sizes[0], 2*m_small_arena_size + mylib::Arena::PAGE_SIZE);
+    ASSERT_GT(block_sizes[1], 4*m_small_arena_size);
+    ASSERT_LE(block_sizes[1], 4*m_small_arena_size + mylib::Arena::PAGE_SIZE);
+    ASSERT_EQ(block_sizes[1], block_sizes[2]);
+    ASSERT_EQ(block_sizes[2], block_sizes[3]);
+    arena.releaseChunks(chunks);
+    ASSERT_THROW(mylib::Arena(mylib::ArenaOptions{.growth_factor = 0.5}), std::invalid_argument);
+}
+
+TEST_F(ArenaFixture, DedicatedBlocks) {
+    mylib::Arena arena(mylib::ArenaOptions{
+        .initial_size = m_small_arena_size, 
+        .block_size = m_small_arena_size*4,
+        .dedicated_block_threshold = m_medium_arena_size,
+    });
+    auto* small_chunk = arena.getChunk(m_small_arena_size);
+    const auto reserved_size = arena.reservedSize();
+    auto* huge_chunk = arena.getChunk(m_medium_arena_size*2);
+    ASSERT_EQ(arena.totalBlocks(), 3);
+    ASSERT_LE(arena.reservedSize() - reserved_size, m_medium_arena_size*2 + 2*mylib::Arena::PAGE_SIZE);
+    arena.releaseChunk(huge_chunk);
+    ASSERT_EQ(arena.totalBlocks(), 2);
+    ASSERT_EQ(arena.reservedSize(), reserved_size);
+    arena.releaseChunk(small_chunk);
+}
+
+TEST_F(ArenaFixture, BackingMemory) {
+    for (auto backing : {mylib::BackingMemory::ANONYMOUS, mylib::BackingMemory::HUGE_PAGES, mylib::BackingMemory::HEAP}) {
+        mylib::Arena arena(mylib::ArenaOptions{.initial_size = m_medium_arena_size, .backing = backing});
+        auto* chunk = arena.getChunk(m_small_arena_size);
+        ASSERT_TRUE(std::all_of(chunk->begin(), chunk->begin() + chunk->size(), [](std::byte b) { return b == std::byte{0}; }));
+        for (std::uint64_t i = 0; i < 100; i++) {
+            chunk->push(std::uint64_t{i});
+        }
+        ASSERT_EQ(reinterpret_cast<std::uint64_t*>(chunk->begin())[99], 99);
+        arena.releaseChunk(chunk);
+    }
+}
@@ -0,0 +1,88 @@
+#include <mylib/arena.h>
+#include <mylib/arena_resource.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ArenaResourceFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024*16;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(ArenaResourceFixture, PmrContainers) {
+    mylib::ArenaResource resource(&m_arena);
+    std::pmr::vector<std::uint64_t> vec(&resource);
+    for (std::uint64_t i = 0; i < 10000; i++) {
+        vec.push_back(i);
+    }
+    ASSERT_EQ(vec[9999], 9999);
+    std::pmr::unordered_map<std::uint32_t, std::pmr::string> map(&resource);
+    for (std::uint32_t i = 0; i < 1000; i++) {
+        map.emplace(i, std::pmr::string("a long enough string to avoid small buffer optimization", &resource));
+    }
+    ASSERT_EQ(map.size(), 1000);
+    ASSERT_EQ(map.at(500).size(), 55);
+    ASSERT_GT(resource.allocatedBytes(), 10000*sizeof(std::uint64_t));
+    ASSERT_GT(m_arena.totalChunks(), 0);
+}
+
+TEST_F(ArenaResourceFixture, ReuseFreedBlocksOfTheSameSizeClass) {
+    mylib::ArenaResource resource(&m_arena);
+    void* a = resource.allocate(24, 8);
+    void* b = resource.allocate(32, 8);
+    ASSERT_NE(a, b);
+    resource.deallocate(a, 24, 8);
+    // 24 and 32 bytes belong to the same size class.
+    void* c = resource.allocate(30, 8);
+    ASSERT_EQ(a, c);
+    void* d = resource.allocate(30, 8);
+    ASSERT_NE(d, a);
+    ASSERT_NE(d, b);
+}
+
+TEST_F(ArenaResourceFixture, Alignment) {
+    mylib::ArenaResource resource(&m_arena);
+    ASSERT_NE(resource.allocate(1, 1), nullptr);
+    for (std::size_t alignment = 1; alignment <= 256; alignment *= 2) {
+        void* ptr = resource.allocate(3, alignment);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0);
+    }
+    void* large = resource.allocate(mylib::ArenaResource::DEFAULT_CHUNK_SIZE*4, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(large) % 64, 0);
+}
+
+TEST_F(ArenaResourceFixture, ReleaseReturnsChunksToArena) {
+    mylib::ArenaResource resource(&m_arena, mylib::Arena::PAGE_SIZE*4);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_NE(resource.allocate(256, 8), nullptr);
+    }
+    ASSERT_NE(resource.allocate(mylib::Arena::PAGE_SIZE*8, 8), nullptr);
+    const std::uint64_t total_chunks = m_arena.totalChunks();
+    ASSERT_GT(total_chunks, 1);
+    ASSERT_EQ(m_arena.emptyChunksCount(), 0);
+    resource.release();
+    ASSERT_EQ(resource.allocatedBytes(), 0);
+    ASSERT_EQ(m_arena.emptyChunksCount(), total_chunks);
+}
+
+TEST_F(ArenaResourceFixture, StlAllocator) {
+    mylib::ArenaResource resource(&m_arena);
+    mylib::ArenaAllocator<int> allocator(&resource);
+    std::vector<int, mylib::ArenaAllocator<int>> vec(allocator);
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+    ASSERT_EQ(vec.back(), 999);
+    using Allocator = mylib::ArenaAllocator<std::pair<const int, double>>;
+    std::map<int, double, std::less<int>, Allocator> map{Allocator(&resource)};
+    for (int i = 0; i < 1000; i++) {
+        map[i] = i*0.5;
+    }
+    ASSERT_EQ(map.size(), 1000);
+    ASSERT_EQ(map.begin()->first, 0);
+    ASSERT_TRUE(allocator == Allocator(&resource));
+}
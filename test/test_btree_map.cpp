@@ -0,0 +1,210 @@
+#include <mylib/btree_map.h>
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+class BTreeMapFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t m_arena_size{1024u*1024u*16u};
+    mylib::Arena m_arena{m_arena_size};
+};
+
+TEST_F(BTreeMapFixture, InsertFindErase) {
+    mylib::BTreeMap<std::int64_t, std::uint64_t> map(&m_arena);
+    std::map<std::int64_t, std::uint64_t> expected;
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<std::int64_t> keys(-100000, 100000);
+
+    for (std::uint64_t i = 0; i < 50000; i++) {
+        const std::int64_t key = keys(random);
+        const bool inserted = expected.emplace(key, i).second;
+        auto [itr, map_inserted] = map.insert(key, i);
+        ASSERT_EQ(map_inserted, inserted);
+        ASSERT_EQ(itr.key(), key);
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    ASSERT_GT(map.height(), 2);
+    ASSERT_TRUE(std::equal(map.begin(), map.end(), expected.begin(), expected.end(),
+        [](const auto& lhs, const auto& rhs) { return (lhs.first == rhs.first) && (lhs.second == rhs.second); }));
+
+    for (std::uint64_t i = 0; i < 50000; i++) {
+        const std::int64_t key = keys(random);
+        ASSERT_EQ(map.erase(key), expected.erase(key));
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        ASSERT_TRUE(map.contains(key));
+        ASSERT_EQ(map.at(key), value);
+    }
+    ASSERT_THROW(map.at(100001), std::out_of_range);
+
+    map.insert_or_assign(100001, 1);
+    map.insert_or_assign(100001, 2);
+    ASSERT_EQ(map[100001], 2);
+    ASSERT_EQ(map[100002], 0);
+
+    // Erasing everything leaves an empty, but usable map.
+    for (std::int64_t key = -100000; key <= 100002; key++) {
+        map.erase(key);
+    }
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.begin(), map.end());
+    map.insert(7, 7);
+    ASSERT_EQ(map.begin().key(), 7);
+}
+
+TEST_F(BTreeMapFixture, LowerAndUpperBound) {
+    mylib::BTreeMap<std::uint32_t, std::uint32_t> map(&m_arena);
+    for (std::uint32_t i = 0; i < 10000; i++) {
+        map.insert(i*2, i);
+    }
+    // Keys above INT32_MAX take the sign bit flip in the SIMD search.
+    map.insert(0xFFFFFFF0u, 1);
+
+    ASSERT_EQ(map.lower_bound(10).key(), 10);
+    ASSERT_EQ(map.lower_bound(11).key(), 12);
+    ASSERT_EQ(map.upper_bound(10).key(), 12);
+    ASSERT_EQ(map.lower_bound(20000).key(), 0xFFFFFFF0u);
+    ASSERT_EQ(map.upper_bound(0xFFFFFFF0u), map.end());
+    ASSERT_EQ(map.find(11), map.end());
+}
+
+TEST_F(BTreeMapFixture, LowerAndUpperBound64) {
+    // Without AVX2 the 64-bit comparison is emulated with 32-bit ones, so keys differ in either half,
+    // with and without the sign bits set.
+    std::vector<std::uint64_t> values;
+    for (std::uint64_t high : {0ull, 1ull, 0x7FFFFFFFull, 0x80000000ull, 0xFFFFFFFFull}) {
+        for (std::uint64_t low : {0ull, 1ull, 0x7FFFFFFFull, 0x80000000ull, 0xFFFFFFFEull}) {
+            values.push_back((high << 32) | low);
+        }
+    }
+
+    mylib::BTreeMap<std::uint64_t, std::uint64_t> unsigned_map(&m_arena);
+    mylib::BTreeMap<std::int64_t, std::uint64_t> signed_map(&m_arena);
+    std::map<std::uint64_t, std::uint64_t> unsigned_expected;
+    std::map<std::int64_t, std::uint64_t> signed_expected;
+    for (std::uint64_t value : values) {
+        unsigned_map.insert(value, value);
+        unsigned_expected.emplace(value, value);
+        signed_map.insert(static_cast<std::int64_t>(value), value);
+        signed_expected.emplace(static_cast<std::int64_t>(value), value);
+    }
+
+    for (std::uint64_t value : values) {
+        for (std::uint64_t key : {value - 1, value, value + 1}) {
+            auto expected_lower = unsigned_expected.lower_bound(key);
+            auto expected_upper = unsigned_expected.upper_bound(key);
+            ASSERT_EQ(unsigned_map.lower_bound(key) == unsigned_map.end(), expected_lower == unsigned_expected.end());
+            ASSERT_EQ(unsigned_map.upper_bound(key) == unsigned_map.end(), expected_upper == unsigned_expected.end());
+            if (expected_lower != unsigned_expected.end()) {
+                ASSERT_EQ(unsigned_map.lower_bound(key).key(), expected_lower->first);
+            }
+            if (expected_upper != unsigned_expected.end()) {
+                ASSERT_EQ(unsigned_map.upper_bound(key).key(), expected_upper->first);
+            }
+
+            const auto signed_key = static_cast<std::int64_t>(key);
+            auto expected_signed_lower = signed_expected.lower_bound(signed_key);
+            auto expected_signed_upper = signed_expected.upper_bound(signed_key);
+            ASSERT_EQ(signed_map.lower_bound(signed_key) == signed_map.end(), expected_signed_lower == signed_expected.end());
+            ASSERT_EQ(signed_map.upper_bound(signed_key) == signed_map.end(), expected_signed_upper == signed_expected.end());
+            if (expected_signed_lower != signed_expected.end()) {
+                ASSERT_EQ(signed_map.lower_bound(signed_key).key(), expected_signed_lower->first);
+            }
+            if (expected_signed_upper != signed_expected.end()) {
+                ASSERT_EQ(signed_map.upper_bound(signed_key).key(), expected_signed_upper->first);
+            }
+        }
+    }
+}
+
+TEST_F(BTreeMapFixture, RangeScan) {
+    mylib::BTreeMap<std::uint64_t, double> map(&m_arena);
+    for (std::uint64_t timestamp = 0; timestamp < 100000; timestamp += 10) {
+        map.insert(timestamp, static_cast<double>(timestamp) / 10);
+    }
+
+    std::vector<std::uint64_t> keys;
+    map.scan(995, 1500, [&keys](std::uint64_t key, double value) {
+        ASSERT_EQ(value, static_cast<double>(key) / 10);
+        keys.push_back(key);
+    });
+    ASSERT_EQ(keys.size(), 50);
+    ASSERT_EQ(keys.front(), 1000);
+    ASSERT_EQ(keys.back(), 1490);
+
+    std::uint64_t count = 0;
+    for (auto itr = map.lower_bound(99000); itr != map.end(); ++itr) {
+        count += 1;
+    }
+    ASSERT_EQ(count, 100);
+}
+
+TEST_F(BTreeMapFixture, CustomCompare) {
+    mylib::BTreeMap<std::int32_t, std::int32_t, std::greater<std::int32_t>> map(&m_arena);
+    for (std::int32_t i = 0; i < 1000; i++) {
+        map.insert(i, -i);
+    }
+    std::int32_t expected = 999;
+    for (auto [key, value] : map) {
+        ASSERT_EQ(key, expected);
+        ASSERT_EQ(value, -expected);
+        expected -= 1;
+    }
+    ASSERT_EQ(map.lower_bound(500).key(), 500);
+    ASSERT_EQ(map.upper_bound(500).key(), 499);
+}
+
+TEST_F(BTreeMapFixture, LargeValues) {
+    // A leaf of these is larger than a slab.
+    using Value = std::array<char, 22000>;
+    mylib::BTreeMap<std::uint32_t, Value> map(&m_arena);
+    for (std::uint32_t i = 0; i < 64; i++) {
+        Value value{};
+        value.fill(static_cast<char>(i));
+        map.insert(i, value);
+    }
+    for (std::uint32_t i = 0; i < 64; i++) {
+        ASSERT_EQ(map.at(i)[0], static_cast<char>(i));
+        ASSERT_EQ(map.at(i)[21999], static_cast<char>(i));
+    }
+}
+
+TEST_F(BTreeMapFixture, BulkLoad) {
+    mylib::GrowingArray<std::pair<std::uint64_t, std::uint64_t>> sorted(&m_arena);
+    constexpr std::uint64_t count{100000u};
+    for (std::uint64_t i = 0; i < count; i++) {
+        sorted.push_back(std::make_pair(i*3, i));
+    }
+
+    mylib::BTreeMap<std::uint64_t, std::uint64_t> map(&m_arena);
+    map.insert(1, 1);
+    map.bulk_load(sorted);
+    ASSERT_EQ(map.size(), count);
+    ASSERT_FALSE(map.contains(1));
+
+    std::uint64_t i = 0;
+    for (auto [key, value] : map) {
+        ASSERT_EQ(key, i*3);
+        ASSERT_EQ(value, i);
+        i += 1;
+    }
+    ASSERT_EQ(i, count);
+
+    // The bulk loaded tree supports the regular updates.
+    for (std::uint64_t key = 1; key < count*3; key += 3) {
+        ASSERT_TRUE(map.insert(key, 0).second);
+    }
+    ASSERT_EQ(map.size(), count*2);
+    ASSERT_EQ(map.lower_bound(4).key(), 4);
+    ASSERT_EQ(map.erase(3), 1);
+    ASSERT_EQ(map.upper_bound(1).key(), 4);
+
+    sorted.push_back(std::make_pair(0, 0));
+    ASSERT_THROW(map.bulk_load(sorted), std::invalid_argument);
+}
@@ -0,0 +1,146 @@
+#include <mylib/filter.h>
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <vector>
+
+class FilterFixture : public ::testing::Test {
+protected:
+    std::vector<std::uint64_t> randomKeys(std::size_t count) {
+        std::vector<std::uint64_t> keys(count);
+        for (auto& key : keys) key = m_random();
+        return keys;
+    }
+
+    template<class Filter>
+    double falsePositiveRate(const Filter& filter, std::size_t count) {
+        std::size_t positives = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            // Odd keys are never inserted by the tests.
+            positives += filter.contains(m_random() | 1);
+        }
+        return static_cast<double>(positives) / static_cast<double>(count);
+    }
+
+    std::mt19937_64 m_random{7};
+    mylib::Arena m_arena{1024u*1024u*16u};
+};
+
+TEST_F(FilterFixture, BloomFilter) {
+    constexpr std::size_t COUNT = 100000;
+    mylib::BloomFilter filter(&m_arena, COUNT, 0.01);
+    ASSERT_EQ(filter.memoryUsage(), filter.blocksCount()*mylib::BloomFilter::BLOCK_SIZE);
+    std::vector<std::uint64_t> keys;
+    for (std::uint64_t i = 0; i < COUNT; i++) {
+        keys.push_back(i*2); // Sequential keys are mixed before use.
+    }
+    filter.insert(std::span<const std::uint64_t>(keys.data(), COUNT / 2));
+    for (std::size_t i = COUNT / 2; i < COUNT; i++) {
+        filter.insert(keys[i]);
+    }
+    ASSERT_EQ(filter.size(), COUNT);
+
+    auto results = std::make_unique<bool[]>(COUNT);
+    ASSERT_EQ(filter.contains(keys, std::span<bool>(results.get(), COUNT)), COUNT);
+    for (std::uint64_t key : keys) {
+        ASSERT_TRUE(filter.contains(key));
+    }
+    ASSERT_LT(falsePositiveRate(filter, 100000), 0.02);
+
+    filter.clear();
+    ASSERT_EQ(filter.size(), 0);
+    ASSERT_FALSE(filter.contains(keys[0]));
+    ASSERT_THROW(mylib::BloomFilter(&m_arena, 10, 1.5), std::invalid_argument);
+}
+
+TEST_F(FilterFixture, CuckooFilter) {
+    constexpr std::size_t COUNT = 100000;
+    mylib::CuckooFilter filter(&m_arena, COUNT);
+    ASSERT_GE(filter.capacity(), COUNT);
+    std::vector<std::uint64_t> keys = randomKeys(COUNT);
+    for (auto& key : keys) key &= ~1ull;
+    ASSERT_EQ(filter.insert(keys), COUNT);
+    ASSERT_EQ(filter.size(), COUNT);
+    for (std::uint64_t key : keys) {
+        ASSERT_TRUE(filter.contains(key));
+    }
+    ASSERT_LT(falsePositiveRate(filter, 100000), 0.001);
+
+    // Erased keys are gone, the rest are still there.
+    for (std::size_t i = 0; i < COUNT; i += 2) {
+        ASSERT_TRUE(filter.erase(keys[i]));
+    }
+    ASSERT_EQ(filter.size(), COUNT / 2);
+    std::size_t still_present = 0;
+    for (std::size_t i = 0; i < COUNT; i++) {
+        if (i % 2) ASSERT_TRUE(filter.contains(keys[i]));
+        else still_present += filter.contains(keys[i]);
+    }
+    ASSERT_LT(still_present, COUNT / 100);
+
+    auto results = std::make_unique<bool[]>(COUNT);
+    ASSERT_GE(filter.contains(keys, std::span<bool>(results.get(), COUNT)), COUNT / 2);
+    ASSERT_TRUE(results[1]);
+}
+
+TEST_F(FilterFixture, CuckooFilterBecomesFull) {
+    mylib::CuckooFilter filter(&m_arena, 1000);
+    std::vector<std::uint64_t> keys = randomKeys(filter.capacity()*2);
+    const std::uint64_t inserted = filter.insert(keys);
+    ASSERT_LT(inserted, keys.size());
+    ASSERT_GT(filter.loadFactor(), 0.9);
+    ASSERT_FALSE(filter.insert(m_random()));
+    for (std::uint64_t i = 0; i < inserted; i++) {
+        ASSERT_TRUE(filter.contains(keys[i]));
+    }
+    // Erasing makes room for the fingerprint kept aside.
+    ASSERT_TRUE(filter.erase(keys[0]));
+    ASSERT_TRUE(filter.contains(keys[inserted - 1]));
+    filter.clear();
+    ASSERT_TRUE(filter.insert(keys[0]));
+}
+
+TEST_F(FilterFixture, Serialization) {
+    const auto path = std::filesystem::temp_directory_path() / "mylib_filter.bin";
+    mylib::BloomFilter bloom(&m_arena, 1000);
+    mylib::CuckooFilter cuckoo(&m_arena, 1000);
+    std::vector<std::uint64_t> keys = randomKeys(1000);
+    bloom.insert(keys);
+    cuckoo.insert(keys);
+    {
+        mylib::BinaryWriter writer(path);
+        bloom.write(writer);
+        cuckoo.write(writer);
+    }
+    mylib::BinaryReader reader(path);
+    mylib::BloomFilter bloom_copy = mylib::BloomFilter::read(reader, &m_arena);
+    mylib::CuckooFilter cuckoo_copy = mylib::CuckooFilter::read(reader, &m_arena);
+    ASSERT_TRUE(reader.eof());
+    ASSERT_EQ(bloom_copy.size(), 1000);
+    ASSERT_EQ(cuckoo_copy.size(), 1000);
+    for (std::uint64_t key : keys) {
+        ASSERT_TRUE(bloom_copy.contains(key));
+        ASSERT_TRUE(cuckoo_copy.contains(key));
+    }
+    ASSERT_TRUE(std::equal(bloom.bytes().begin(), bloom.bytes().end(), bloom_copy.bytes().begin(), bloom_copy.bytes().end()));
+
+    // The raw bytes of one kind of filter are rejected by the other.
+    ASSERT_THROW(mylib::CuckooFilter(&m_arena, bloom.bytes()), std::invalid_argument);
+    ASSERT_THROW(mylib::BloomFilter(&m_arena, bloom.bytes().first(100)), std::invalid_argument);
+
+    // A corrupted buckets count is rejected, even if multiplying it by the bucket size wraps around to the right size.
+    std::vector<std::byte> malformed(bloom.bytes().begin(), bloom.bytes().end());
+    auto setBucketsCount = [&malformed](std::uint64_t buckets_count) {
+        std::memcpy(malformed.data() + offsetof(mylib::detail::FilterHeader, buckets_count), &buckets_count, sizeof(buckets_count));
+    };
+    const std::uint64_t buckets_count = (malformed.size() - sizeof(mylib::detail::FilterHeader)) / mylib::BloomFilter::BLOCK_SIZE;
+    setBucketsCount(buckets_count + (1ull << 58));
+    ASSERT_THROW(mylib::BloomFilter(&m_arena, malformed), std::invalid_argument);
+    setBucketsCount(0);
+    malformed.resize(sizeof(mylib::detail::FilterHeader));
+    ASSERT_THROW(mylib::BloomFilter(&m_arena, malformed), std::invalid_argument);
+    std::filesystem::remove(path);
+}
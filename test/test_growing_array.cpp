@@ -3,6 +3,7 @@
 #include <mylib/growing_array.h>
 #include <fmt/core.h>
 #include <gtest/gtest.h>
+#include <filesystem>
 
 class ArrayFixture : public ::testing::Test {
 protected:
@@ -59,4 +60,31 @@ TEST_F(ArrayFixture, Create) {
     str_arr.clear();
     ASSERT_EQ(str_arr.size(), 0);
     ASSERT_EQ(str_arr.max_size(), CAP);
-}
\ No newline at end of file
+}
+TEST_F(ArrayFixture, ReopenFromPersistentArena) {
+    const auto path = std::filesystem::temp_directory_path() / "mylib_growing_array.arena";
+    std::filesystem::remove(path);
+    constexpr std::int32_t COUNT = 1000;
+    {
+        mylib::Arena arena(path, ARENA_SIZE);
+        mylib::GrowingArray<std::int32_t> arr(&arena);
+        for (std::int32_t i = 0; i < COUNT; i++) {
+            arr.push_back(i);
+        }
+        arena.setRoot(0, arr.release());
+        ASSERT_EQ(arr.size(), 0);
+    }
+    {
+        mylib::Arena arena(path);
+        mylib::GrowingArray<std::int32_t> arr(&arena, arena.root(0));
+        ASSERT_EQ(arr.size(), COUNT);
+        for (std::int32_t i = 0; i < COUNT; i++) {
+            ASSERT_EQ(arr[i], i);
+        }
+        arr.push_back(COUNT);
+        ASSERT_EQ(arr.back(), COUNT);
+        // The array owns the adopted chunk, hand it back to the root rather than releasing it.
+        arena.setRoot(0, arr.release());
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,90 @@
+#include <mylib/arena.h>
+#include <mylib/numa_arena.h>
+#include <mylib/growing_array.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace
+{
+thread_local std::uint32_t t_simulated_node = 0;
+}
+
+class NumaArenaFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t NODE_ARENA_SIZE = 1024*1024;
+    constexpr static std::uint32_t NODES_COUNT = 2;
+
+    mylib::NumaArena m_arena{NODE_ARENA_SIZE, mylib::NumaTopology::simulate(NODES_COUNT, [] { return t_simulated_node; })};
+};
+
+TEST_F(NumaArenaFixture, RouteToCallerNode) {
+    ASSERT_TRUE(m_arena.isSimulated());
+    ASSERT_EQ(m_arena.nodesCount(), NODES_COUNT);
+    t_simulated_node = 0;
+    auto* chunk0 = m_arena.getChunk(512);
+    std::thread([this] {
+        t_simulated_node = 1;
+        ASSERT_EQ(m_arena.currentNode(), 1);
+        m_arena.getChunk(512);
+        m_arena.getChunk(512);
+    }).join();
+    ASSERT_TRUE(m_arena.nodeArena(0)->contains(chunk0));
+    ASSERT_FALSE(m_arena.nodeArena(1)->contains(chunk0));
+    auto stats = m_arena.stats();
+    ASSERT_EQ(stats.size(), NODES_COUNT);
+    ASSERT_EQ(stats[0].total_chunks, 1);
+    ASSERT_EQ(stats[0].chunk_requests, 1);
+    ASSERT_EQ(stats[1].total_chunks, 2);
+    ASSERT_EQ(stats[1].chunk_requests, 2);
+    ASSERT_GE(stats[1].reserved_bytes, NODE_ARENA_SIZE);
+    ASSERT_THROW(m_arena.nodeArena(NODES_COUNT), std::out_of_range);
+}
+
+TEST_F(NumaArenaFixture, ReleaseFromRemoteNode) {
+    t_simulated_node = 1;
+    auto* chunk = m_arena.getChunk(512);
+    chunk->push(std::uint64_t{7});
+    t_simulated_node = 0;
+    m_arena.releaseChunk(chunk);
+    auto stats = m_arena.stats();
+    ASSERT_EQ(stats[1].empty_chunks, 1);
+    ASSERT_EQ(stats[1].remote_releases, 1);
+    ASSERT_EQ(stats[0].total_chunks, 0);
+}
+
+TEST_F(NumaArenaFixture, GrowAcrossNodes) {
+    t_simulated_node = 0;
+    auto* chunk = m_arena.getChunk(512);
+    chunk->push(std::uint64_t{42});
+    t_simulated_node = 1;
+    auto* new_chunk = m_arena.getChunk(4096, chunk);
+    ASSERT_EQ(*reinterpret_cast<std::uint64_t*>(new_chunk->begin()), 42);
+    ASSERT_TRUE(m_arena.nodeArena(1)->contains(new_chunk));
+    ASSERT_EQ(m_arena.stats()[0].empty_chunks, 1);
+}
+
+TEST_F(NumaArenaFixture, LocalArenaForContainers) {
+    t_simulated_node = 1;
+    mylib::GrowingArray<int> arr(m_arena.local());
+    for (int i = 0; i < 100; i++) {
+        arr.push_back(i);
+    }
+    ASSERT_EQ(m_arena.stats()[1].total_chunks, m_arena.nodeArena(1)->totalChunks());
+    ASSERT_GT(m_arena.nodeArena(1)->totalChunks(), 0);
+    ASSERT_EQ(m_arena.nodeArena(0)->totalChunks(), 0);
+}
+
+TEST(NumaArena, BindToNode) {
+    // Node 0 exists on every machine, the block is mapped and bound rather than malloc'ed.
+    mylib::Arena arena(1024*1024, 0);
+    ASSERT_EQ(arena.numaNode(), 0);
+    auto* chunk = arena.getChunk(1024*512);
+    for (std::uint64_t i = 0; i < 1024; i++) {
+        chunk->push(std::uint64_t{i});
+    }
+    ASSERT_EQ(reinterpret_cast<std::uint64_t*>(chunk->begin())[1023], 1023);
+    auto topology = mylib::NumaTopology::detect();
+    ASSERT_GE(topology.nodes_count, 1);
+    mylib::NumaArena numa_arena(1024*1024, topology);
+    ASSERT_LT(numa_arena.currentNode(), numa_arena.nodesCount());
+}
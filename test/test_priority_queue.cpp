@@ -0,0 +1,127 @@
+#include <mylib/priority_queue.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+class PriorityQueueFixture : public ::testing::Test {
+protected:
+    template<std::size_t D>
+    void popsInOrder() {
+        std::mt19937_64 random(D);
+        mylib::PriorityQueue<std::uint64_t, std::less<std::uint64_t>, D> queue(&m_arena);
+        std::vector<std::uint64_t> expected;
+        for (std::uint64_t i = 0; i < 10000; i++) {
+            const std::uint64_t value = random() % 1000;
+            queue.push(value);
+            expected.push_back(value);
+        }
+        std::sort(expected.begin(), expected.end(), std::greater<std::uint64_t>());
+        ASSERT_EQ(queue.size(), expected.size());
+        for (std::uint64_t value : expected) {
+            ASSERT_EQ(queue.top(), value);
+            queue.pop();
+        }
+        ASSERT_TRUE(queue.empty());
+    }
+
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024*16;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(PriorityQueueFixture, PopsInOrder) {
+    popsInOrder<2>();
+    popsInOrder<3>();
+    popsInOrder<4>();
+    popsInOrder<8>();
+
+    mylib::PriorityQueue<std::int32_t> empty(&m_arena);
+    ASSERT_THROW(empty.top(), std::out_of_range);
+    ASSERT_THROW(empty.pop(), std::out_of_range);
+}
+
+TEST_F(PriorityQueueFixture, PushBulk) {
+    std::mt19937_64 random(1);
+    mylib::PriorityQueue<std::int64_t, std::greater<std::int64_t>, 4> queue(&m_arena);
+    std::vector<std::int64_t> expected;
+    auto pushBatch = [&](std::size_t count) {
+        std::vector<std::int64_t> batch;
+        for (std::size_t i = 0; i < count; i++) {
+            batch.push_back(static_cast<std::int64_t>(random() % 100000) - 50000);
+        }
+        queue.push_bulk(batch);
+        expected.insert(expected.end(), batch.begin(), batch.end());
+    };
+    // The first batch rebuilds the heap, the second one is small enough to be sifted up.
+    pushBatch(5000);
+    pushBatch(100);
+    pushBatch(0);
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(queue.size(), expected.size());
+    for (std::int64_t value : expected) {
+        ASSERT_EQ(queue.top(), value);
+        queue.pop();
+    }
+}
+
+TEST_F(PriorityQueueFixture, IndexedUpdateAndErase) {
+    using Queue = mylib::IndexedPriorityQueue<std::uint64_t, std::greater<std::uint64_t>, 4>;
+    std::mt19937_64 random(2);
+    Queue queue(&m_arena);
+    std::map<Queue::Handle, std::uint64_t> expected;
+    for (std::uint64_t i = 0; i < 2000; i++) {
+        const std::uint64_t value = random() % 10000;
+        expected[queue.push(value)] = value;
+    }
+    for (std::uint64_t i = 0; i < 5000; i++) {
+        auto itr = std::next(expected.begin(), static_cast<std::ptrdiff_t>(random() % expected.size()));
+        switch (random() % 3) {
+        case 0:
+            itr->second = random() % 10000;
+            queue.update(itr->first, itr->second);
+            break;
+        case 1:
+            queue.erase(itr->first);
+            ASSERT_FALSE(queue.contains(itr->first));
+            expected.erase(itr);
+            break;
+        default: {
+            const std::uint64_t value = random() % 10000;
+            expected[queue.push(value)] = value;
+        }
+        }
+        ASSERT_EQ(queue.size(), expected.size());
+        const auto min = std::min_element(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+        ASSERT_EQ(queue.top(), min->second);
+        ASSERT_EQ(queue.value(queue.topHandle()), min->second);
+    }
+    for (const auto& [handle, value] : expected) {
+        ASSERT_TRUE(queue.contains(handle));
+        ASSERT_EQ(queue.value(handle), value);
+    }
+}
+
+TEST_F(PriorityQueueFixture, IndexedHandlesAreReused) {
+    mylib::IndexedPriorityQueue<std::int32_t> queue(&m_arena);
+    const auto low = queue.push(1);
+    const auto high = queue.push(10);
+    ASSERT_EQ(queue.topHandle(), high);
+    queue.update(low, 20);
+    ASSERT_EQ(queue.topHandle(), low);
+    queue.pop();
+    ASSERT_FALSE(queue.contains(low));
+    ASSERT_THROW(queue.value(low), std::out_of_range);
+    ASSERT_THROW(queue.update(low, 0), std::out_of_range);
+    ASSERT_THROW(queue.erase(100), std::out_of_range);
+
+    // The freed handle goes to the next push.
+    ASSERT_EQ(queue.push(5), low);
+    ASSERT_EQ(queue.top(), 10);
+    queue.erase(high);
+    ASSERT_EQ(queue.top(), 5);
+    queue.pop();
+    ASSERT_TRUE(queue.empty());
+    ASSERT_THROW(queue.pop(), std::out_of_range);
+}
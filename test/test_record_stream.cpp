@@ -0,0 +1,118 @@
+#include <mylib/record_stream.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+struct TradeEvent {
+    std::uint64_t id;
+    double        price;
+    std::uint32_t quantity;
+};
+
+struct CancelEvent {
+    std::uint64_t id;
+};
+
+struct alignas(16) SnapshotEvent {
+    std::uint64_t ids[4];
+};
+
+using EventStream = mylib::RecordStream<TradeEvent, CancelEvent, SnapshotEvent, char>;
+}
+
+class RecordStreamFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t m_arena_size{1024u*1024u};
+    mylib::Arena m_arena{m_arena_size};
+};
+
+TEST_F(RecordStreamFixture, PushAndIterate) {
+    EventStream stream(&m_arena);
+    ASSERT_TRUE(stream.empty());
+    ASSERT_EQ(stream.begin(), stream.end());
+
+    stream.push(TradeEvent{.id = 1, .price = 10.5, .quantity = 3});
+    stream.push('x');
+    stream.emplace<CancelEvent>(CancelEvent{.id = 1});
+    auto& snapshot = stream.push(SnapshotEvent{{1, 2, 3, 4}});
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(&snapshot) % alignof(SnapshotEvent), 0);
+    ASSERT_EQ(stream.size(), 4);
+
+    std::vector<std::uint16_t> tags;
+    for (auto record : stream) {
+        tags.push_back(record.tag());
+    }
+    ASSERT_EQ(tags, (std::vector<std::uint16_t>{
+        EventStream::TAG_OF<TradeEvent>, EventStream::TAG_OF<char>, 
+        EventStream::TAG_OF<CancelEvent>, EventStream::TAG_OF<SnapshotEvent>}));
+
+    auto itr = stream.begin();
+    ASSERT_TRUE((*itr).is<TradeEvent>());
+    ASSERT_EQ((*itr).as<TradeEvent>().quantity, 3);
+    ASSERT_EQ((*itr).size(), sizeof(TradeEvent));
+    ASSERT_THROW((*itr).as<CancelEvent>(), std::logic_error);
+    ASSERT_EQ((*++itr).as<char>(), 'x');
+}
+
+TEST_F(RecordStreamFixture, Visit) {
+    EventStream stream(&m_arena);
+    for (std::uint64_t i = 0; i < 10; i++) {
+        if (i % 2) stream.push(TradeEvent{.id = i, .price = 1.0, .quantity = 1});
+        else stream.push(CancelEvent{.id = i});
+    }
+    struct Visitor {
+        std::uint64_t trades = 0;
+        std::uint64_t cancels = 0;
+        std::uint64_t ids_sum = 0;
+        void operator()(const TradeEvent& e) { trades += 1; ids_sum += e.id; }
+        void operator()(const CancelEvent& e) { cancels += 1; ids_sum += e.id; }
+        void operator()(const SnapshotEvent&) {}
+        void operator()(char) {}
+    } visitor;
+    stream.visit(visitor);
+    ASSERT_EQ(visitor.trades, 5);
+    ASSERT_EQ(visitor.cancels, 5);
+    ASSERT_EQ(visitor.ids_sum, 45);
+}
+
+TEST_F(RecordStreamFixture, SpansMultipleChunks) {
+    constexpr std::uint64_t RECORDS_COUNT = 10000;
+    EventStream stream(&m_arena, mylib::Arena::PAGE_SIZE);
+    std::vector<const TradeEvent*> pointers;
+    for (std::uint64_t i = 0; i < RECORDS_COUNT; i++) {
+        pointers.push_back(&stream.push(TradeEvent{.id = i, .price = 0.0, .quantity = 0}));
+    }
+    ASSERT_GT(stream.chunksCount(), 1);
+    std::uint64_t expected = 0;
+    for (auto record : stream) {
+        ASSERT_EQ(record.as<TradeEvent>().id, expected);
+        ASSERT_EQ(&record.as<TradeEvent>(), pointers[expected]);
+        expected += 1;
+    }
+    ASSERT_EQ(expected, RECORDS_COUNT);
+
+    const auto empty_chunks = m_arena.emptyChunksCount();
+    const auto chunks_count = stream.chunksCount();
+    stream.clear();
+    ASSERT_EQ(m_arena.emptyChunksCount(), empty_chunks + chunks_count);
+    ASSERT_EQ(stream.begin(), stream.end());
+}
+
+TEST_F(RecordStreamFixture, RecordLargerThanChunk) {
+    using LargeStream = mylib::RecordStream<std::uint64_t, std::array<std::uint64_t, 512>>;
+    LargeStream stream(&m_arena, mylib::Arena::PAGE_SIZE);
+    stream.push(std::uint64_t{7});
+    std::array<std::uint64_t, 512> large{};
+    large.back() = 42;
+    stream.push(large);
+    stream.push(std::uint64_t{8});
+    // The large record gets a chunk of its own, the next record fits into its page-aligned tail.
+    ASSERT_EQ(stream.chunksCount(), 2);
+    auto itr = stream.begin();
+    ASSERT_EQ((*itr++).as<std::uint64_t>(), 7);
+    ASSERT_EQ(((*itr++).as<std::array<std::uint64_t, 512>>().back()), 42);
+    ASSERT_EQ((*itr++).as<std::uint64_t>(), 8);
+    ASSERT_EQ(itr, stream.end());
+}
@@ -0,0 +1,128 @@
+#include <mylib/rope.h>
+#include <gtest/gtest.h>
+#include <bit>
+#include <random>
+#include <string>
+
+class RopeFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t m_arena_size{1024u*1024u*64u};
+    constexpr static std::uint64_t m_leaf_size{256u};
+
+    static std::string toString(const mylib::Rope& rope) {
+        mylib::String flat = rope.flatten();
+        return std::string(flat.data(), flat.size());
+    }
+
+    mylib::Arena m_arena{m_arena_size};
+};
+
+TEST_F(RopeFixture, AppendAndFlatten) {
+    mylib::Rope rope(&m_arena, m_leaf_size);
+    std::string expected;
+    for (int i = 0; i < 10000; i++) {
+        const std::string piece = "line " + std::to_string(i) + "\n";
+        rope.append(piece);
+        expected += piece;
+    }
+    ASSERT_EQ(rope.size(), expected.size());
+    ASSERT_EQ(toString(rope), expected);
+    ASSERT_EQ(rope.at(5), expected[5]);
+    ASSERT_THROW(rope.at(rope.size()), std::out_of_range);
+
+    // Small appends fill the leaves in place, and the tree stays balanced.
+    ASSERT_LE(rope.ioVecs().size(), expected.size() / (m_leaf_size / 2));
+    ASSERT_LE(rope.depth(), 2*std::bit_width(rope.ioVecs().size()));
+
+    mylib::String str("tail");
+    rope.append(str);
+    ASSERT_EQ(toString(rope), expected + "tail");
+}
+
+TEST_F(RopeFixture, ConcatenationSharesNodes) {
+    mylib::Rope rope(&m_arena, std::string(1000, 'a'), m_leaf_size);
+    const std::uint64_t chunks = m_arena.totalChunks() - m_arena.emptyChunksCount();
+
+    mylib::Rope doubled = rope;
+    for (int i = 0; i < 20; i++) {
+        doubled += doubled;
+    }
+    ASSERT_EQ(doubled.size(), 1000u << 20);
+    ASSERT_LE(doubled.depth(), 30);
+    // No characters were copied.
+    ASSERT_EQ(m_arena.totalChunks() - m_arena.emptyChunksCount(), chunks);
+    ASSERT_EQ(rope.size(), 1000);
+    ASSERT_EQ(doubled.at(doubled.size() - 1), 'a');
+
+    // Appending to a rope whose leaves are shared doesn't modify the other rope.
+    mylib::Rope copy = rope;
+    copy.append("b");
+    ASSERT_EQ(rope.size(), 1000);
+    ASSERT_EQ(toString(copy), std::string(1000, 'a') + "b");
+}
+
+TEST_F(RopeFixture, EditingMatchesString) {
+    mylib::Rope rope(&m_arena, "The quick brown fox", m_leaf_size);
+    std::string expected = "The quick brown fox";
+    std::mt19937 random(7);
+    for (int i = 0; i < 2000; i++) {
+        const std::uint64_t pos = random() % (expected.size() + 1);
+        switch (random() % 3) {
+        case 0: {
+            const std::string piece(random() % 300, static_cast<char>('a' + random() % 26));
+            rope.insert(pos, piece);
+            expected.insert(pos, piece);
+            break;
+        }
+        case 1: {
+            const std::uint64_t count = random() % 200;
+            rope.erase(pos, count);
+            expected.erase(pos, count);
+            break;
+        }
+        case 2: {
+            const std::uint64_t count = random() % 500;
+            mylib::Rope sub = rope.substr(pos, count);
+            ASSERT_EQ(toString(sub), expected.substr(pos, count));
+            rope.insert(pos / 2, sub);
+            expected.insert(pos / 2, expected.substr(pos, count));
+            break;
+        }
+        }
+        ASSERT_EQ(rope.size(), expected.size());
+    }
+    ASSERT_EQ(toString(rope), expected);
+    ASSERT_TRUE(rope == mylib::Rope(&m_arena, expected, 4096));
+    ASSERT_FALSE(rope == mylib::Rope(&m_arena, expected + "x"));
+    ASSERT_THROW(rope.insert(rope.size() + 1, "x"), std::out_of_range);
+
+    rope.insert(3, rope);
+    expected.insert(3, expected);
+    ASSERT_EQ(toString(rope), expected);
+}
+
+TEST_F(RopeFixture, InsertionsAreSizedToFit) {
+    // Only the rightmost leaf keeps spare space for appends, the inserted ones would take a leaf each.
+    mylib::Rope rope(&m_arena, "ab");
+    const std::uint64_t reserved = m_arena.reservedSize();
+    for (int i = 0; i < 2000; i++) {
+        rope.insert(1, "xy");
+    }
+    ASSERT_EQ(rope.size(), 4002);
+    ASSERT_EQ(rope.at(0), 'a');
+    ASSERT_EQ(rope.at(4001), 'b');
+    ASSERT_EQ(m_arena.reservedSize(), reserved);
+}
+
+TEST_F(RopeFixture, IoVecs) {
+    mylib::Rope rope(&m_arena, "HTTP/1.1 200 OK\r\n", m_leaf_size);
+    mylib::Rope body(&m_arena, std::string(1000, 'x'), m_leaf_size);
+    rope.append("Content-Length: 1000\r\n\r\n").append(body);
+
+    std::string gathered;
+    for (const mylib::IoVec& vec : rope.ioVecs()) {
+        gathered.append(static_cast<const char*>(vec.base), vec.length);
+    }
+    ASSERT_EQ(gathered, toString(rope));
+    ASSERT_TRUE(mylib::Rope(&m_arena, m_leaf_size).ioVecs().empty());
+}
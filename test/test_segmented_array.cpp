@@ -0,0 +1,127 @@
+#include <mylib/segmented_array.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
+class SegmentedArrayFixture : public ::testing::Test {
+protected:
+    std::uint64_t usedChunks() const { return m_arena.totalChunks() - m_arena.emptyChunksCount(); }
+
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024*16;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(SegmentedArrayFixture, PushAndIndex) {
+    using Array = mylib::SegmentedArray<std::uint64_t, 1024>;
+    static_assert(Array::SEGMENT_SHIFT == 10);
+    static_assert(mylib::SegmentedArray<std::uint64_t>::SEGMENT_SIZE == 8192);
+
+    Array arr(&m_arena);
+    ASSERT_TRUE(arr.empty());
+    constexpr std::uint64_t COUNT = 100000;
+    for (std::uint64_t i = 0; i < COUNT; i++) {
+        arr.push_back(i*3);
+    }
+    ASSERT_EQ(arr.size(), COUNT);
+    ASSERT_EQ(arr.segmentsCount(), (COUNT + 1023) / 1024);
+    ASSERT_EQ(arr.front(), 0);
+    ASSERT_EQ(arr.back(), (COUNT - 1)*3);
+    ASSERT_EQ(arr[1024], 1024*3);
+    ASSERT_THROW(arr[COUNT], std::out_of_range);
+
+    // Iterators are random access, so the standard algorithms work across the segments.
+    ASSERT_TRUE(std::is_sorted(arr.begin(), arr.end()));
+    ASSERT_EQ(*std::lower_bound(arr.begin(), arr.end(), 3000), 3000);
+    ASSERT_EQ(arr.end() - arr.begin(), COUNT);
+
+    std::uint64_t sum = 0;
+    std::uint64_t segments = 0;
+    arr.forEachSegment([&](std::span<const std::uint64_t> segment) {
+        sum = std::accumulate(segment.begin(), segment.end(), sum);
+        segments++;
+    });
+    ASSERT_EQ(sum, 3*COUNT*(COUNT - 1)/2);
+    ASSERT_EQ(segments, arr.segmentsCount());
+}
+
+TEST_F(SegmentedArrayFixture, StableReferences) {
+    mylib::SegmentedArray<std::string, 16> arr(&m_arena);
+    std::vector<const std::string*> pointers;
+    for (std::int32_t i = 0; i < 5000; i++) {
+        pointers.push_back(&arr.emplace_back("a string long enough to live on the heap " + std::to_string(i)));
+    }
+    // The directory was reallocated several times, but the elements never moved.
+    for (std::int32_t i = 0; i < 5000; i++) {
+        ASSERT_EQ(&arr[i], pointers[i]);
+        ASSERT_EQ(*pointers[i], "a string long enough to live on the heap " + std::to_string(i));
+    }
+}
+
+TEST_F(SegmentedArrayFixture, TruncateReleasesSegments) {
+    const std::uint64_t chunks = usedChunks();
+    {
+        mylib::SegmentedArray<std::string, 64> arr(&m_arena);
+        for (std::int32_t i = 0; i < 1000; i++) {
+            arr.push_back(std::to_string(i));
+        }
+        const std::uint64_t segments = arr.segmentsCount();
+        ASSERT_EQ(segments, 16);
+
+        arr.truncate(100);
+        ASSERT_EQ(arr.size(), 100);
+        ASSERT_EQ(arr.segmentsCount(), 2);
+        ASSERT_EQ(usedChunks(), chunks + 2 + 2); // Two segments and the directory.
+        ASSERT_EQ(arr.back(), "99");
+
+        arr.pop_back();
+        ASSERT_EQ(arr.back(), "98");
+        arr.push_back("new");
+        ASSERT_EQ(arr[99], "new");
+
+        arr.clear();
+        ASSERT_TRUE(arr.empty());
+        ASSERT_EQ(arr.segmentsCount(), 0);
+        arr.reserve(200);
+        ASSERT_EQ(arr.capacity(), 256);
+    }
+    ASSERT_EQ(usedChunks(), chunks);
+}
+
+TEST_F(SegmentedArrayFixture, ReleasedSegmentsAreCleared) {
+    // The elements removed before the array is destroyed still have to be cleared by the arena.
+    {
+        mylib::SegmentedArray<std::uint64_t, 512> arr(&m_arena);
+        for (std::int32_t i = 0; i < 512; i++) {
+            arr.push_back(0xababababababababull);
+        }
+        for (std::int32_t i = 0; i < 256; i++) {
+            arr.pop_back();
+        }
+        arr.truncate(0);
+    }
+    mylib::Chunk* chunk = m_arena.getChunk(4096);
+    ASSERT_TRUE(std::all_of(chunk->begin(), chunk->begin() + 4096, [](std::byte b) { return b == std::byte{0}; }));
+    m_arena.releaseChunk(chunk);
+}
+
+TEST_F(SegmentedArrayFixture, CopyAndMove) {
+    mylib::SegmentedArray<std::string, 8> arr(&m_arena);
+    for (std::int32_t i = 0; i < 100; i++) {
+        arr.push_back(std::to_string(i));
+    }
+    mylib::SegmentedArray<std::string, 8> copy = arr;
+    ASSERT_TRUE(std::equal(arr.begin(), arr.end(), copy.begin(), copy.end()));
+    ASSERT_NE(&copy[0], &arr[0]);
+
+    const std::string* first = &arr[0];
+    mylib::SegmentedArray<std::string, 8> moved = std::move(arr);
+    ASSERT_EQ(&moved[0], first);
+    ASSERT_TRUE(arr.empty());
+
+    copy = moved;
+    ASSERT_EQ(copy.size(), 100);
+    moved = std::move(arr);
+    ASSERT_TRUE(moved.empty());
+}
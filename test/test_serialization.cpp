@@ -0,0 +1,119 @@
+#include <mylib/arena.h>
+#include <mylib/growing_array.h>
+#include <mylib/string.h>
+#include <mylib/serialization.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+class SerializationFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_path = std::filesystem::temp_directory_path() / 
+            fmt::format("mylib_{}.bin", ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_path);
+    }
+
+    struct Point {
+        float x, y, z;
+        std::uint32_t id;
+    };
+
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024*16;
+    mylib::Arena m_arena{ARENA_SIZE};
+    std::filesystem::path m_path;
+};
+
+TEST_F(SerializationFixture, WriteAndReadArrays) {
+    constexpr std::uint64_t COUNT = 100000;
+    {
+        mylib::GrowingArray<std::uint64_t> values(&m_arena);
+        mylib::GrowingArray<Point> points(&m_arena);
+        for (std::uint64_t i = 0; i < COUNT; i++) {
+            values.push_back(i*7);
+            if (i % 10 == 0) points.push_back(Point{1.0f*i, 2.0f*i, 3.0f*i, static_cast<std::uint32_t>(i)});
+        }
+        mylib::BinaryWriter writer(m_path);
+        writer.write(values);
+        writer.write(points);
+    }
+    mylib::BinaryReader reader(m_path);
+    auto values = reader.readArray<std::uint64_t>(&m_arena);
+    auto points = reader.readArray<Point>(&m_arena);
+    ASSERT_TRUE(reader.eof());
+    ASSERT_EQ(values.size(), COUNT);
+    ASSERT_EQ(points.size(), COUNT / 10);
+    for (std::uint64_t i = 0; i < COUNT; i++) {
+        ASSERT_EQ(values[i], i*7);
+    }
+    ASSERT_EQ(points[42].id, 420);
+    ASSERT_EQ(points[42].z, 1260.0f);
+}
+
+TEST_F(SerializationFixture, MixedRecordsSpanMultipleBatches) {
+    constexpr std::uint64_t COUNT = mylib::BinaryWriter::BATCH_SIZE*3;
+    std::vector<mylib::String> strings;
+    strings.reserve(COUNT);
+    mylib::GrowingArray<std::int16_t> small(&m_arena);
+    small.push_back(1); small.push_back(-2); small.push_back(3);
+    mylib::GrowingArray<std::int16_t> empty(&m_arena);
+    {
+        mylib::BinaryWriter writer(m_path);
+        for (std::uint64_t i = 0; i < COUNT; i++) {
+            strings.emplace_back(fmt::format("string number {}", i));
+            writer.write(strings.back());
+            writer.write(small);
+        }
+        writer.write(empty);
+    }
+    mylib::BinaryReader reader(m_path);
+    for (std::uint64_t i = 0; i < COUNT; i++) {
+        auto str = reader.readString();
+        ASSERT_TRUE(str == strings[i]);
+        auto arr = reader.readArray<std::int16_t>(&m_arena);
+        ASSERT_EQ(arr.size(), 3);
+        ASSERT_EQ(arr[1], -2);
+    }
+    ASSERT_EQ(reader.readArray<std::int16_t>(&m_arena).size(), 0);
+    ASSERT_TRUE(reader.eof());
+}
+
+TEST_F(SerializationFixture, RecordMismatch) {
+    {
+        mylib::BinaryWriter writer(m_path);
+        mylib::String str("payload");
+        writer.write(str);
+        writer.flush();
+    }
+    mylib::BinaryReader reader(m_path);
+    ASSERT_THROW(reader.readArray<std::uint32_t>(&m_arena), mylib::serialization_error);
+}
+
+TEST_F(SerializationFixture, InvalidStream) {
+    {
+        std::ofstream file(m_path, std::ios::binary);
+        file << "not a stream";
+    }
+    ASSERT_THROW(mylib::BinaryReader reader(m_path), mylib::serialization_error);
+}
+
+TEST_F(SerializationFixture, TruncatedArray) {
+    {
+        mylib::GrowingArray<std::uint64_t> values(&m_arena);
+        for (std::uint64_t i = 0; i < 10000; i++) {
+            values.push_back(i);
+        }
+        mylib::BinaryWriter writer(m_path);
+        writer.write(values);
+    }
+    std::filesystem::resize_file(m_path, std::filesystem::file_size(m_path) / 2);
+    const std::uint64_t used_chunks = m_arena.totalChunks() - m_arena.emptyChunksCount();
+    mylib::BinaryReader reader(m_path);
+    ASSERT_THROW(reader.readArray<std::uint64_t>(&m_arena), mylib::serialization_error);
+    // The chunk the payload was read into is returned to the arena.
+    ASSERT_EQ(m_arena.totalChunks() - m_arena.emptyChunksCount(), used_chunks);
+}
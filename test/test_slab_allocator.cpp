@@ -0,0 +1,115 @@
+#include <mylib/arena.h>
+#include <mylib/slab_allocator.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional> // std::mem_fn
+#include <set>
+#include <thread>
+#include <vector>
+
+class SlabAllocatorFixture : public ::testing::Test {
+protected:
+    struct Node {
+        Node*         next;
+        std::uint64_t value;
+    };
+
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024*64;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(SlabAllocatorFixture, SizeClasses) {
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(0), 0);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(8), 0);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(9), 1);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(24), 2);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(33), 4);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(512), mylib::SlabAllocator::SIZE_CLASSES_COUNT - 1);
+    ASSERT_EQ(mylib::SlabAllocator::sizeClassIndex(513), mylib::SlabAllocator::SIZE_CLASSES_COUNT);
+    mylib::SlabAllocator allocator(&m_arena);
+    ASSERT_THROW(allocator.allocate(513), std::length_error);
+}
+
+TEST_F(SlabAllocatorFixture, SmallObjectsShareChunks) {
+    constexpr std::uint64_t NODES_COUNT = 100000;
+    mylib::SlabAllocator allocator(&m_arena);
+    std::vector<Node*> nodes;
+    nodes.reserve(NODES_COUNT);
+    for (std::uint64_t i = 0; i < NODES_COUNT; i++) {
+        nodes.push_back(allocator.create<Node>(Node{nullptr, i}));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(nodes.back()) % alignof(Node), 0);
+    }
+    for (std::uint64_t i = 0; i < NODES_COUNT; i++) {
+        ASSERT_EQ(nodes[i]->value, i);
+    }
+    // 16 bytes per node, a slab holds roughly 4000 of them.
+    const std::uint64_t expected_slabs = NODES_COUNT*sizeof(Node) / mylib::SlabAllocator::SLAB_SIZE + 2;
+    ASSERT_LE(allocator.slabsCount(), expected_slabs);
+    ASSERT_EQ(m_arena.totalChunks(), allocator.slabsCount());
+    std::set<Node*> unique(nodes.begin(), nodes.end());
+    ASSERT_EQ(unique.size(), NODES_COUNT);
+    for (auto* node : nodes) {
+        allocator.destroy(node);
+    }
+    // Freed slots are reused without new slabs.
+    const std::uint64_t slabs = allocator.slabsCount();
+    for (std::uint64_t i = 0; i < NODES_COUNT; i++) {
+        nodes[i] = allocator.create<Node>();
+    }
+    ASSERT_EQ(allocator.slabsCount(), slabs);
+}
+
+TEST_F(SlabAllocatorFixture, ReleaseSlabsOnDestruction) {
+    {
+        mylib::SlabAllocator allocator(&m_arena);
+        for (std::uint64_t size = 1; size <= mylib::SlabAllocator::MAX_SLOT_SIZE; size++) {
+            allocator.allocate(size);
+        }
+        ASSERT_EQ(allocator.slabsCount(), mylib::SlabAllocator::SIZE_CLASSES_COUNT);
+    }
+    ASSERT_EQ(m_arena.emptyChunksCount(), m_arena.totalChunks());
+}
+
+TEST_F(SlabAllocatorFixture, ThreadSafety) {
+    constexpr std::int32_t THREAD_COUNT = 8;
+    constexpr std::uint64_t NODES_COUNT = 20000;
+    mylib::SlabAllocator allocator(&m_arena);
+    std::vector<std::vector<Node*>> nodes(THREAD_COUNT);
+    auto allocate = [&allocator, &nodes](std::int32_t index) {
+        for (std::uint64_t i = 0; i < NODES_COUNT; i++) {
+            nodes[index].push_back(allocator.create<Node>(Node{nullptr, i}));
+        }
+    };
+    // Release nodes allocated by another thread.
+    auto release = [&allocator, &nodes](std::int32_t index) {
+        for (auto* node : nodes[(index + 1) % THREAD_COUNT]) {
+            allocator.destroy(node);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::int32_t i = 0; i < THREAD_COUNT; i++) {
+        threads.emplace_back(allocate, i);
+    }
+    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+    std::set<Node*> unique;
+    for (auto& thread_nodes : nodes) {
+        for (std::uint64_t i = 0; i < NODES_COUNT; i++) {
+            ASSERT_EQ(thread_nodes[i]->value, i);
+        }
+        unique.insert(thread_nodes.begin(), thread_nodes.end());
+    }
+    ASSERT_EQ(unique.size(), THREAD_COUNT*NODES_COUNT);
+
+    threads.clear();
+    for (std::int32_t i = 0; i < THREAD_COUNT; i++) {
+        threads.emplace_back(release, i);
+    }
+    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+    // Magazines of the exited threads were flushed, so all the slots are reusable.
+    const std::uint64_t slabs = allocator.slabsCount();
+    for (std::uint64_t i = 0; i < THREAD_COUNT*NODES_COUNT; i++) {
+        allocator.create<Node>();
+    }
+    ASSERT_EQ(allocator.slabsCount(), slabs);
+}
@@ -0,0 +1,126 @@
+#include <mylib/small_array.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class SmallArrayFixture : public ::testing::Test {
+protected:
+    std::uint64_t usedChunks() const { return m_arena.totalChunks() - m_arena.emptyChunksCount(); }
+
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(SmallArrayFixture, InlineDoesNotAllocate) {
+    const std::uint64_t chunks = usedChunks();
+    mylib::SmallArray<std::int32_t, 16> arr(&m_arena);
+    ASSERT_TRUE(arr.empty());
+    ASSERT_EQ(arr.capacity(), 16);
+    for (std::int32_t i = 0; i < 16; i++) {
+        arr.push_back(i);
+    }
+    ASSERT_TRUE(arr.isInline());
+    ASSERT_EQ(usedChunks(), chunks);
+    ASSERT_EQ(arr.front(), 0);
+    ASSERT_EQ(arr.back(), 15);
+    ASSERT_THROW(arr[16], std::out_of_range);
+
+    // The 17th element spills into a chunk.
+    arr.push_back(16);
+    ASSERT_FALSE(arr.isInline());
+    ASSERT_EQ(usedChunks(), chunks + 1);
+    ASSERT_GE(arr.capacity(), 32);
+    std::int32_t expected = 0;
+    for (std::int32_t value : arr) {
+        ASSERT_EQ(value, expected++);
+    }
+    arr.pop_back();
+    ASSERT_EQ(arr.size(), 16);
+}
+
+TEST_F(SmallArrayFixture, NonTrivialElements) {
+    mylib::SmallArray<std::string, 4> arr(&m_arena);
+    std::vector<std::string> expected;
+    for (std::int32_t i = 0; i < 1000; i++) {
+        // Long enough to be allocated on the heap, so a missed destructor or a shallow copy is visible to sanitizers.
+        const std::string str = "string with a long enough content " + std::to_string(i);
+        arr.emplace_back(str);
+        expected.push_back(str);
+    }
+    ASSERT_EQ(arr.size(), expected.size());
+    ASSERT_TRUE(std::equal(arr.begin(), arr.end(), expected.begin()));
+    arr.clear();
+    ASSERT_TRUE(arr.empty());
+    ASSERT_FALSE(arr.isInline());
+}
+
+TEST_F(SmallArrayFixture, PushOwnElementWhenFull) {
+    // The pushed value refers to the storage which is about to be relocated.
+    mylib::SmallArray<std::uint64_t, 0> numbers(&m_arena);
+    numbers.push_back(42);
+    while (numbers.size() < numbers.capacity()) {
+        numbers.push_back(numbers.size());
+    }
+    const std::size_t size = numbers.size();
+    numbers.push_back(numbers[0]);
+    ASSERT_EQ(numbers.size(), size + 1);
+    ASSERT_EQ(numbers.back(), 42);
+
+    mylib::SmallArray<std::string, 2> strings(&m_arena);
+    strings.push_back("string with a long enough content 0");
+    strings.push_back("string with a long enough content 1");
+    strings.push_back(strings[0]);
+    strings.emplace_back(strings[1]);
+    ASSERT_FALSE(strings.isInline());
+    ASSERT_EQ(strings[2], strings[0]);
+    ASSERT_EQ(strings[3], strings[1]);
+}
+
+TEST_F(SmallArrayFixture, CopyAndMove) {
+    mylib::SmallArray<std::string, 4> small(&m_arena);
+    small.push_back("a");
+    small.push_back("b");
+    mylib::SmallArray<std::string, 4> large(&m_arena);
+    for (std::int32_t i = 0; i < 10; i++) {
+        large.push_back(std::to_string(i));
+    }
+
+    mylib::SmallArray<std::string, 4> small_copy = small;
+    mylib::SmallArray<std::string, 4> large_copy = large;
+    ASSERT_TRUE(small_copy.isInline());
+    ASSERT_FALSE(large_copy.isInline());
+    ASSERT_NE(large_copy.data(), large.data());
+    ASSERT_TRUE(std::equal(large.begin(), large.end(), large_copy.begin(), large_copy.end()));
+
+    // A spilled array hands over its chunk, an inline one moves the elements.
+    const std::string* data = large.data();
+    mylib::SmallArray<std::string, 4> large_moved = std::move(large);
+    ASSERT_EQ(large_moved.data(), data);
+    ASSERT_TRUE(large.empty());
+    ASSERT_TRUE(large.isInline());
+
+    mylib::SmallArray<std::string, 4> small_moved = std::move(small);
+    ASSERT_EQ(small_moved.size(), 2);
+    ASSERT_EQ(small_moved[1], "b");
+    ASSERT_TRUE(small.empty());
+
+    small_moved = large_moved;
+    ASSERT_EQ(small_moved.size(), 10);
+    large_moved = std::move(small_copy);
+    ASSERT_EQ(large_moved.size(), 2);
+    ASSERT_TRUE(large_moved.isInline());
+}
+
+TEST_F(SmallArrayFixture, ZeroInlineCapacity) {
+    static_assert(sizeof(mylib::SmallArray<std::int64_t, 0>) <= 6*sizeof(void*));
+    const std::uint64_t chunks = usedChunks();
+    {
+        mylib::SmallArray<std::int64_t, 0> arr(&m_arena);
+        ASSERT_EQ(arr.capacity(), 0);
+        ASSERT_FALSE(arr.reserve(0));
+        arr.push_back(1);
+        ASSERT_FALSE(arr.isInline());
+        ASSERT_EQ(usedChunks(), chunks + 1);
+    }
+    ASSERT_EQ(usedChunks(), chunks);
+}
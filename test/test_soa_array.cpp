@@ -0,0 +1,86 @@
+#include <mylib/arena.h>
+#include <mylib/soa_array.h>
+#include <gtest/gtest.h>
+#include <numeric>
+
+class SoAArrayFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t ARENA_SIZE = 1024*1024;
+    mylib::Arena m_arena{ARENA_SIZE};
+};
+
+TEST_F(SoAArrayFixture, Create) {
+    mylib::SoAArray<std::uint64_t, double, char> arr(&m_arena);
+    ASSERT_EQ(arr.size(), 0);
+    ASSERT_EQ(arr.capacity(), 0);
+    ASSERT_TRUE(arr.empty());
+    ASSERT_TRUE(arr.column<0>().empty());
+    arr.push_back(1u, 1.5, 'a');
+    arr.push_back(2u, 2.5, 'b');
+    ASSERT_EQ(arr.size(), 2);
+    using Array = mylib::SoAArray<std::uint64_t, double, char>;
+    ASSERT_GE(arr.capacity(), Array::INITIAL_CAPACITY);
+    auto [id, value, tag] = arr[1];
+    ASSERT_EQ(id, 2u);
+    ASSERT_EQ(value, 2.5);
+    ASSERT_EQ(tag, 'b');
+    std::get<1>(arr[0]) = 10.0;
+    ASSERT_EQ(arr.column<1>()[0], 10.0);
+    arr.pop_back();
+    ASSERT_EQ(arr.size(), 1);
+    ASSERT_THROW(arr[1], std::out_of_range);
+    arr.clear();
+    ASSERT_TRUE(arr.empty());
+}
+
+TEST_F(SoAArrayFixture, ColumnsGrowTogether) {
+    constexpr std::uint64_t ROWS_COUNT = 10000;
+    mylib::SoAArray<std::uint32_t, std::uint64_t> arr(&m_arena);
+    for (std::uint64_t i = 0; i < ROWS_COUNT; i++) {
+        arr.push_back(static_cast<std::uint32_t>(i), i*i);
+    }
+    ASSERT_EQ(arr.size(), ROWS_COUNT);
+    auto ids = arr.column<0>();
+    auto squares = arr.column<1>();
+    ASSERT_EQ(ids.size(), ROWS_COUNT);
+    ASSERT_EQ(squares.size(), ROWS_COUNT);
+    for (std::uint64_t i = 0; i < ROWS_COUNT; i++) {
+        ASSERT_EQ(ids[i], i);
+        ASSERT_EQ(squares[i], i*i);
+    }
+    // Columns have to be placed in separate chunks.
+    ASSERT_NE(static_cast<const void*>(ids.data()), static_cast<const void*>(squares.data()));
+    ASSERT_EQ(std::accumulate(ids.begin(), ids.end(), std::uint64_t{0}), ROWS_COUNT*(ROWS_COUNT-1)/2);
+}
+
+TEST_F(SoAArrayFixture, IterateRows) {
+    mylib::SoAArray<int, float> arr(&m_arena);
+    for (int i = 0; i < 100; i++) {
+        arr.push_back(i, i*0.5f);
+    }
+    int count = 0;
+    for (auto [i, f] : arr) {
+        ASSERT_EQ(f, i*0.5f);
+        f = 0.0f;
+        count++;
+    }
+    ASSERT_EQ(count, 100);
+    for (float f : arr.column<1>()) {
+        ASSERT_EQ(f, 0.0f);
+    }
+}
+
+TEST_F(SoAArrayFixture, CopyAndMove) {
+    mylib::SoAArray<int, char> arr(&m_arena);
+    for (int i = 0; i < 200; i++) {
+        arr.push_back(i, static_cast<char>(i));
+    }
+    mylib::SoAArray<int, char> copy(arr);
+    ASSERT_EQ(copy.size(), arr.size());
+    std::get<0>(copy[0]) = -1;
+    ASSERT_EQ(std::get<0>(arr[0]), 0);
+    mylib::SoAArray<int, char> moved(std::move(copy));
+    ASSERT_EQ(moved.size(), arr.size());
+    ASSERT_EQ(copy.size(), 0);
+    ASSERT_EQ(std::get<0>(moved[199]), 199);
+}
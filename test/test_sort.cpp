@@ -0,0 +1,139 @@
+#include <mylib/sort.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <compare>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+class SortFixture : public ::testing::Test {
+protected:
+    template<class T, class Generator>
+    std::vector<T> fill(mylib::GrowingArray<T>& arr, std::size_t count, Generator&& generate) {
+        std::vector<T> values;
+        for (std::size_t i = 0; i < count; i++) {
+            values.push_back(generate(i));
+            arr.push_back(values.back());
+        }
+        return values;
+    }
+
+    template<class T>
+    void match(const mylib::GrowingArray<T>& arr, const std::vector<T>& expected) {
+        ASSERT_EQ(arr.size(), expected.size());
+        ASSERT_TRUE(std::equal(arr.data(), arr.data() + arr.size(), expected.begin()));
+    }
+
+    std::uint64_t usedChunks() const { return m_arena.totalChunks() - m_arena.emptyChunksCount(); }
+
+    std::mt19937_64 m_random{42};
+    mylib::Arena m_arena{1024u*1024u*64u};
+};
+
+TEST_F(SortFixture, Integers) {
+    for (std::size_t count : {0, 1, 100, 1000, 100000}) {
+        mylib::GrowingArray<std::uint64_t> unsigned_arr(&m_arena);
+        auto unsigned_values = fill(unsigned_arr, count, [&](std::size_t) { return m_random(); });
+        mylib::GrowingArray<std::int32_t> signed_arr(&m_arena);
+        auto signed_values = fill(signed_arr, count, [&](std::size_t) { return static_cast<std::int32_t>(m_random()); });
+
+        const std::uint64_t chunks = usedChunks();
+        mylib::sort(unsigned_arr);
+        mylib::sort(signed_arr);
+        // The scratch space is returned to the arena.
+        ASSERT_EQ(usedChunks(), chunks);
+
+        std::sort(unsigned_values.begin(), unsigned_values.end());
+        std::sort(signed_values.begin(), signed_values.end());
+        match(unsigned_arr, unsigned_values);
+        match(signed_arr, signed_values);
+    }
+
+    // Keys which differ only in a couple of bytes skip the other passes.
+    mylib::GrowingArray<std::int64_t> narrow(&m_arena);
+    auto narrow_values = fill(narrow, 10000, [&](std::size_t) { return static_cast<std::int64_t>(m_random() % 1000) - 500; });
+    mylib::sort(narrow);
+    std::sort(narrow_values.begin(), narrow_values.end());
+    match(narrow, narrow_values);
+}
+
+TEST_F(SortFixture, FloatingPoint) {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    mylib::GrowingArray<double> arr(&m_arena);
+    std::uniform_real_distribution<double> distribution(-1e9, 1e9);
+    auto values = fill(arr, 10000, [&](std::size_t i) {
+        if (i == 10) return INF;
+        if (i == 20) return -INF;
+        if (i == 30) return 0.0;
+        return distribution(m_random);
+    });
+    mylib::sort(arr);
+    std::sort(values.begin(), values.end());
+    match(arr, values);
+    ASSERT_EQ(arr.front(), -INF);
+    ASSERT_EQ(arr.back(), INF);
+
+    mylib::GrowingArray<float> floats(&m_arena);
+    auto float_values = fill(floats, 1000, [&](std::size_t) { return static_cast<float>(distribution(m_random)); });
+    mylib::sort(floats);
+    std::sort(float_values.begin(), float_values.end());
+    match(floats, float_values);
+
+    // Wider than any radix key, sorted by comparison.
+    mylib::GrowingArray<long double> long_doubles(&m_arena);
+    auto long_double_values = fill(long_doubles, 1000, [&](std::size_t) { return static_cast<long double>(distribution(m_random)); });
+    mylib::sort(long_doubles);
+    std::sort(long_double_values.begin(), long_double_values.end());
+    match(long_doubles, long_double_values);
+}
+
+TEST_F(SortFixture, KeyIndexPairsAreStable) {
+    using Pair = std::pair<std::int32_t, std::uint32_t>;
+    for (std::size_t count : {100, 100000}) {
+        mylib::GrowingArray<Pair> arr(&m_arena);
+        auto values = fill(arr, count, [&](std::size_t i) {
+            return Pair(static_cast<std::int32_t>(m_random() % 64) - 32, static_cast<std::uint32_t>(i));
+        });
+        mylib::sort(arr);
+        std::stable_sort(values.begin(), values.end(), [](const Pair& lhs, const Pair& rhs) { return lhs.first < rhs.first; });
+        match(arr, values);
+    }
+}
+
+struct Version {
+    std::uint16_t major;
+    std::uint16_t minor;
+
+    auto operator<=>(const Version&) const = default;
+};
+
+// Pairs holding non-trivially copyable values can't go through the raw scratch memory.
+static_assert(!mylib::detail::RadixTraits<std::pair<std::int32_t, std::string>>::ENABLED);
+
+TEST_F(SortFixture, Parallel) {
+    mylib::GrowingArray<std::uint64_t> arr(&m_arena);
+    auto values = fill(arr, 1000000, [&](std::size_t) { return m_random(); });
+    mylib::parallel_sort(arr, 4);
+    std::sort(values.begin(), values.end());
+    match(arr, values);
+
+    using Pair = std::pair<float, std::uint32_t>;
+    mylib::GrowingArray<Pair> pairs(&m_arena);
+    auto pair_values = fill(pairs, 500000, [&](std::size_t i) { return Pair(static_cast<float>(m_random() % 1000) - 500.0f, static_cast<std::uint32_t>(i)); });
+    mylib::parallel_sort(pairs, 3);
+    std::stable_sort(pair_values.begin(), pair_values.end(), [](const Pair& lhs, const Pair& rhs) { return lhs.first < rhs.first; });
+    match(pairs, pair_values);
+
+    // Other types fall back to a comparison sort.
+    mylib::GrowingArray<Version> versions(&m_arena);
+    auto version_values = fill(versions, 100000, [&](std::size_t) {
+        return Version{static_cast<std::uint16_t>(m_random() % 4), static_cast<std::uint16_t>(m_random() % 16)};
+    });
+    mylib::parallel_sort(versions, 4);
+    std::sort(version_values.begin(), version_values.end());
+    match(versions, version_values);
+
+    mylib::sort(arr, std::greater<std::uint64_t>());
+    ASSERT_TRUE(std::is_sorted(arr.data(), arr.data() + arr.size(), std::greater<std::uint64_t>()));
+}
@@ -0,0 +1,141 @@
+#include <mylib/string.h>
+#include <mylib/string_view.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+std::vector<std::string> collect(mylib::SplitRange range) {
+    std::vector<std::string> fields;
+    for (mylib::StringView field : range) {
+        fields.emplace_back(field.data(), field.size());
+    }
+    return fields;
+}
+}
+
+TEST(StringTest, InitializerListConcatenates) {
+    mylib::String str{"metric", ".", "name"};
+    ASSERT_EQ(str.size(), 11);
+    ASSERT_EQ(str.view(), "metric.name");
+
+    mylib::String empty{};
+    ASSERT_EQ(empty.size(), 0);
+    ASSERT_TRUE(empty.view().empty());
+}
+
+TEST(StringTest, StringViewInterop) {
+    mylib::String str("GET /index.html HTTP/1.1");
+    mylib::StringView view = str;
+    ASSERT_EQ(view.data(), str.data());
+    ASSERT_EQ(view.substr(4, 11), "/index.html");
+    ASSERT_TRUE(view.starts_with("GET"));
+    ASSERT_TRUE(view.ends_with("1.1"));
+    ASSERT_THROW(view.substr(view.size() + 1), std::out_of_range);
+
+    mylib::String copy(view.substr(4, 11));
+    ASSERT_EQ(copy.size(), 11);
+    ASSERT_EQ(copy.data()[11], 0);
+
+    copy += mylib::String("?q=1");
+    ASSERT_EQ(copy.view(), "/index.html?q=1");
+    ASSERT_EQ((copy + "#top").view(), "/index.html?q=1#top");
+}
+
+TEST(StringTest, Find) {
+    mylib::StringView view("key=value;other=1;last");
+    ASSERT_EQ(view.find('='), 3);
+    ASSERT_EQ(view.find('=', 4), 15);
+    ASSERT_EQ(view.find("other"), 10);
+    ASSERT_EQ(view.find("missing"), mylib::StringView::npos);
+    ASSERT_EQ(view.find_first_of(";="), 3);
+    ASSERT_EQ(view.find_first_of(";", 4), 9);
+    ASSERT_EQ(view.find_first_not_of("key"), 3);
+
+    // Long enough for the SIMD blocks, with the match in the scalar tail and past the first block.
+    std::string line(100, 'a');
+    line[37] = '\t';
+    line[98] = ',';
+    mylib::StringView long_view(line);
+    ASSERT_EQ(long_view.find_first_of(",\t"), 37);
+    ASSERT_EQ(long_view.find_first_of(",\t", 38), 98);
+    ASSERT_EQ(long_view.find_first_of(",|;:"), 98);
+    ASSERT_EQ(long_view.find_first_of(",|;:!"), 98);
+    ASSERT_EQ(long_view.find_first_of("xyz"), mylib::StringView::npos);
+}
+
+TEST(StringTest, Split) {
+    ASSERT_EQ(collect(mylib::split("a,b,,c", ",")), (std::vector<std::string>{"a", "b", "", "c"}));
+    ASSERT_EQ(collect(mylib::split("a,", ",")), (std::vector<std::string>{"a", ""}));
+    ASSERT_EQ(collect(mylib::split("", ",")), (std::vector<std::string>{""}));
+    ASSERT_EQ(collect(mylib::split("a;b,c", ",;")), (std::vector<std::string>{"a", "b", "c"}));
+
+    // Fields are views into the source buffer.
+    std::string csv = "1696000000,cpu.load,0.75";
+    auto itr = mylib::split(csv, ",").begin();
+    ASSERT_EQ(itr->data(), csv.data());
+    ++itr;
+    ASSERT_EQ(itr->data(), csv.data() + 11);
+}
+
+TEST(StringTest, Tokenize) {
+    ASSERT_EQ(collect(mylib::tokenize("  GET   /index.html\tHTTP/1.1\r\n")),
+        (std::vector<std::string>{"GET", "/index.html", "HTTP/1.1"}));
+    ASSERT_EQ(collect(mylib::tokenize("   ")), std::vector<std::string>{});
+    ASSERT_EQ(collect(mylib::tokenize("a|b||c", "|")), (std::vector<std::string>{"a", "b", "c"}));
+}
+
+TEST(StringTest, SharedCopies) {
+    mylib::Arena arena(1024u*1024u);
+    const std::uint64_t chunks = arena.totalChunks() - arena.emptyChunksCount();
+    {
+        mylib::String label(&arena, "region=eu-west-1");
+        ASSERT_TRUE(label.isShared());
+        ASSERT_EQ(label.useCount(), 1);
+        ASSERT_EQ(arena.totalChunks() - arena.emptyChunksCount(), chunks + 1);
+
+        std::vector<mylib::String> copies(100, label);
+        ASSERT_EQ(label.useCount(), 101);
+        ASSERT_EQ(std::as_const(copies.back()).data(), std::as_const(label).data());
+        ASSERT_TRUE(copies.back() == label);
+        ASSERT_EQ(arena.totalChunks() - arena.emptyChunksCount(), chunks + 1);
+
+        mylib::String moved(std::move(copies.back()));
+        copies.pop_back();
+        ASSERT_EQ(label.useCount(), 101);
+
+        mylib::String assigned("heap");
+        assigned = label;
+        ASSERT_TRUE(assigned.isShared());
+        ASSERT_EQ(label.useCount(), 102);
+
+        copies.clear();
+        ASSERT_EQ(label.useCount(), 3);
+    }
+    // The last owner returned the chunk.
+    ASSERT_EQ(arena.totalChunks() - arena.emptyChunksCount(), chunks);
+}
+
+TEST(StringTest, SharedDetachesOnWrite) {
+    mylib::Arena arena(1024u*1024u);
+    mylib::String original(&arena, "cpu.load");
+    mylib::String copy = original;
+
+    copy += mylib::String(".avg");
+    ASSERT_EQ(copy.view(), "cpu.load.avg");
+    ASSERT_EQ(original.view(), "cpu.load");
+    ASSERT_EQ(original.useCount(), 1);
+    ASSERT_TRUE(copy.isShared());
+
+    mylib::String other = original;
+    other.data()[0] = 'g';
+    ASSERT_EQ(other.view(), "gpu.load");
+    ASSERT_EQ(original.view(), "cpu.load");
+
+    // A single owner is modified in place.
+    const char* before = std::as_const(other).data();
+    other.data()[1] = 'P';
+    ASSERT_EQ(std::as_const(other).data(), before);
+}
@@ -0,0 +1,87 @@
+#include <mylib/string_pool.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional> // std::mem_fn
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+class StringPoolFixture : public ::testing::Test {
+protected:
+    constexpr static std::uint64_t m_arena_size{1024u*1024u*64u};
+    mylib::Arena m_arena{m_arena_size};
+};
+
+TEST_F(StringPoolFixture, Deduplication) {
+    mylib::StringPool pool(&m_arena);
+    std::string hostname = "db-01.eu-west.example.com";
+    mylib::InternedString first = pool.intern(hostname);
+    mylib::InternedString second = pool.intern(std::string(hostname));
+    mylib::InternedString other = pool.intern("db-02.eu-west.example.com");
+
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(first.data(), second.data());
+    ASSERT_NE(first, other);
+    ASSERT_EQ(first.view(), hostname);
+    ASSERT_EQ(first.c_str()[first.size()], 0);
+    ASSERT_EQ(pool.size(), 2);
+
+    ASSERT_EQ(pool.find(hostname), first);
+    ASSERT_TRUE(pool.find("db-03.eu-west.example.com").empty());
+
+    ASSERT_EQ(pool.intern(mylib::String("db-02.eu-west.example.com")), other);
+    ASSERT_EQ(pool.intern(""), pool.intern(""));
+    ASSERT_EQ(std::hash<mylib::InternedString>{}(first), mylib::StringPool::hash(hostname));
+}
+
+TEST_F(StringPoolFixture, ManyStrings) {
+    mylib::StringPool pool(&m_arena);
+    std::vector<mylib::InternedString> interned;
+    constexpr std::uint64_t count{100000u};
+    for (std::uint64_t i = 0; i < count; i++) {
+        interned.push_back(pool.intern("metric.name." + std::to_string(i)));
+    }
+    // Repeats don't take any more memory.
+    const std::uint64_t memory = pool.memoryUsage();
+    for (std::uint64_t i = 0; i < count; i++) {
+        ASSERT_EQ(pool.intern("metric.name." + std::to_string(i)), interned[i]);
+    }
+    ASSERT_EQ(pool.size(), count);
+    ASSERT_EQ(pool.memoryUsage(), memory);
+
+    // A string larger than a chunk gets a chunk of its own.
+    std::string large(mylib::StringPool::DEFAULT_CHUNK_SIZE*2, 'x');
+    ASSERT_EQ(pool.intern(large).view(), large);
+    ASSERT_EQ(pool.find(large).size(), large.size());
+}
+
+TEST_F(StringPoolFixture, ConcurrentIntern) {
+    mylib::StringPool pool(&m_arena);
+    constexpr std::uint32_t threads_count{4u};
+    constexpr std::uint64_t labels_count{20000u};
+    std::vector<std::vector<mylib::InternedString>> results(threads_count);
+
+    // Every thread interns the same labels, in a different order, so new strings race with lookups and growth.
+    auto intern = [&pool, &results](std::uint32_t thread) {
+        for (std::uint64_t i = 0; i < labels_count; i++) {
+            const std::uint64_t label = (thread % 2) ? labels_count - i - 1 : i;
+            results[thread].push_back(pool.intern("label=" + std::to_string(label)));
+        }
+        if (thread % 2) std::reverse(results[thread].begin(), results[thread].end());
+    };
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t i = 0; i < threads_count; i++) {
+        threads.emplace_back(intern, i);
+    }
+    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+
+    ASSERT_EQ(pool.size(), labels_count);
+    for (std::uint64_t i = 0; i < labels_count; i++) {
+        for (std::uint32_t thread = 1; thread < threads_count; thread++) {
+            ASSERT_EQ(results[thread][i], results[0][i]);
+        }
+        ASSERT_EQ(results[0][i].view(), "label=" + std::to_string(i));
+    }
+}